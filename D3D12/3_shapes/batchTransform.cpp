@@ -0,0 +1,360 @@
+#include "batchTransform.hpp"
+
+#include <cassert>
+#include <cstdint>
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+// MSVC compiles any intrinsic without /arch; the CPU is checked at run time.
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+namespace
+{
+	// Row i of the product is sum over k of world[i][k] * view_proj row k;
+	// the product is then transposed in registers.
+	void transformOne(float const* world, __m128 const* vp, float* out)
+	{
+		__m128 rows[4];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			__m128 row = _mm_loadu_ps(world + 4 * i);
+
+			__m128 sum = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), vp[0]);
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), vp[1]));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), vp[2]));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), vp[3]));
+
+			rows[i] = sum;
+		}
+
+		_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+
+		_mm_stream_ps(out, rows[0]);
+		_mm_stream_ps(out + 4, rows[1]);
+		_mm_stream_ps(out + 8, rows[2]);
+		_mm_stream_ps(out + 12, rows[3]);
+	}
+
+	// Two matrices side by side, one per 128-bit lane. Shuffles and
+	// unpacks work within lanes, so the SSE steps carry over unchanged.
+	TARGET_AVX2 void transformTwo(float const* world, __m256 const* vp, float* out_a, float* out_b)
+	{
+		__m256 rows[4];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			__m256 row = _mm256_insertf128_ps(
+				_mm256_castps128_ps256(_mm_loadu_ps(world + 4 * i)),
+				_mm_loadu_ps(world + 16 + 4 * i),
+				1);
+
+			__m256 sum = _mm256_mul_ps(_mm256_permute_ps(row, _MM_SHUFFLE(0, 0, 0, 0)), vp[0]);
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_permute_ps(row, _MM_SHUFFLE(1, 1, 1, 1)), vp[1]));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_permute_ps(row, _MM_SHUFFLE(2, 2, 2, 2)), vp[2]));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_permute_ps(row, _MM_SHUFFLE(3, 3, 3, 3)), vp[3]));
+
+			rows[i] = sum;
+		}
+
+		__m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+		__m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+		__m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+		__m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+
+		__m256 columns[4] =
+		{
+			_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+			_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+			_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+			_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2))
+		};
+
+		for (int j = 0; j < 4; ++j)
+		{
+			_mm_stream_ps(out_a + 4 * j, _mm256_castps256_ps128(columns[j]));
+			_mm_stream_ps(out_b + 4 * j, _mm256_extractf128_ps(columns[j], 1));
+		}
+	}
+
+	// Moves 128-bit block j of m[i] to block i of the result j, i.e.
+	// transposes a 4x4 matrix of blocks: four matrices become their rows
+	// side by side, and back.
+	TARGET_AVX512 void transposeBlocks(__m512 m[4])
+	{
+		__m512 t0 = _mm512_shuffle_f32x4(m[0], m[1], _MM_SHUFFLE(1, 0, 1, 0));
+		__m512 t1 = _mm512_shuffle_f32x4(m[0], m[1], _MM_SHUFFLE(3, 2, 3, 2));
+		__m512 t2 = _mm512_shuffle_f32x4(m[2], m[3], _MM_SHUFFLE(1, 0, 1, 0));
+		__m512 t3 = _mm512_shuffle_f32x4(m[2], m[3], _MM_SHUFFLE(3, 2, 3, 2));
+
+		m[0] = _mm512_shuffle_f32x4(t0, t2, _MM_SHUFFLE(2, 0, 2, 0));
+		m[1] = _mm512_shuffle_f32x4(t0, t2, _MM_SHUFFLE(3, 1, 3, 1));
+		m[2] = _mm512_shuffle_f32x4(t1, t3, _MM_SHUFFLE(2, 0, 2, 0));
+		m[3] = _mm512_shuffle_f32x4(t1, t3, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+
+	// Four matrices, one per 128-bit lane. Multiplies and adds separately,
+	// like the other kernels, so all of them round the same way.
+	TARGET_AVX512 void transformFour(float const* world, __m512 const* vp, float* const* out, bool aligned)
+	{
+		__m512 rows[4];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			rows[i] = _mm512_loadu_ps(world + 16 * i);
+		}
+
+		transposeBlocks(rows);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			__m512 row = rows[i];
+
+			__m512 sum = _mm512_mul_ps(_mm512_permute_ps(row, _MM_SHUFFLE(0, 0, 0, 0)), vp[0]);
+			sum = _mm512_add_ps(sum, _mm512_mul_ps(_mm512_permute_ps(row, _MM_SHUFFLE(1, 1, 1, 1)), vp[1]));
+			sum = _mm512_add_ps(sum, _mm512_mul_ps(_mm512_permute_ps(row, _MM_SHUFFLE(2, 2, 2, 2)), vp[2]));
+			sum = _mm512_add_ps(sum, _mm512_mul_ps(_mm512_permute_ps(row, _MM_SHUFFLE(3, 3, 3, 3)), vp[3]));
+
+			rows[i] = sum;
+		}
+
+		__m512 t0 = _mm512_unpacklo_ps(rows[0], rows[1]);
+		__m512 t1 = _mm512_unpackhi_ps(rows[0], rows[1]);
+		__m512 t2 = _mm512_unpacklo_ps(rows[2], rows[3]);
+		__m512 t3 = _mm512_unpackhi_ps(rows[2], rows[3]);
+
+		__m512 columns[4] =
+		{
+			_mm512_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+			_mm512_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+			_mm512_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+			_mm512_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2))
+		};
+
+		// Back to one whole matrix per register.
+		transposeBlocks(columns);
+
+		for (int n = 0; n < 4; ++n)
+		{
+			if (aligned)
+			{
+				_mm512_stream_ps(out[n], columns[n]);
+			}
+			else
+			{
+				_mm_stream_ps(out[n], _mm512_extractf32x4_ps(columns[n], 0));
+				_mm_stream_ps(out[n] + 4, _mm512_extractf32x4_ps(columns[n], 1));
+				_mm_stream_ps(out[n] + 8, _mm512_extractf32x4_ps(columns[n], 2));
+				_mm_stream_ps(out[n] + 12, _mm512_extractf32x4_ps(columns[n], 3));
+			}
+		}
+	}
+
+	// The loops below return how many matrices they did, a multiple of the
+	// matrices per iteration; the rest is left to transformOne.
+
+	TARGET_AVX512 std::size_t transformQuads(
+		float const* world,
+		std::size_t count,
+		__m128 const* vp,
+		unsigned char* out,
+		std::size_t out_stride_in_bytes)
+	{
+		__m512 vp4[4];
+
+		for (int k = 0; k < 4; ++k)
+		{
+			vp4[k] = _mm512_broadcast_f32x4(vp[k]);
+		}
+
+		bool aligned = reinterpret_cast<std::uintptr_t>(out) % 64 == 0 && out_stride_in_bytes % 64 == 0;
+
+		std::size_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			float* outs[4];
+
+			for (int n = 0; n < 4; ++n)
+			{
+				outs[n] = reinterpret_cast<float*>(out + (i + n) * out_stride_in_bytes);
+			}
+
+			transformFour(world + 16 * i, vp4, outs, aligned);
+		}
+
+		return i;
+	}
+
+	TARGET_AVX2 std::size_t transformPairs(
+		float const* world,
+		std::size_t count,
+		__m128 const* vp,
+		unsigned char* out,
+		std::size_t out_stride_in_bytes)
+	{
+		__m256 vp2[4];
+
+		for (int k = 0; k < 4; ++k)
+		{
+			vp2[k] = _mm256_broadcast_ps(&vp[k]);
+		}
+
+		std::size_t i = 0;
+
+		for (; i + 2 <= count; i += 2)
+		{
+			transformTwo(
+				world + 16 * i,
+				vp2,
+				reinterpret_cast<float*>(out + i * out_stride_in_bytes),
+				reinterpret_cast<float*>(out + (i + 1) * out_stride_in_bytes));
+		}
+
+		return i;
+	}
+
+	// Also requires the OS to save the wider registers, as reported by XCR0.
+	TransformKernel detectTransformKernel()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+
+		__cpuid(info, 0);
+
+		if (info[0] < 7)
+		{
+			return TransformKernel::SSE;
+		}
+
+		__cpuid(info, 1);
+
+		bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x06) == 0x06;
+		bool os_saves_zmm = os_saves_ymm && (_xgetbv(0) & 0xE0) == 0xE0;
+
+		__cpuidex(info, 7, 0);
+
+		if (os_saves_zmm && (info[1] & (1 << 16)) != 0)
+		{
+			return TransformKernel::AVX512;
+		}
+
+		if (os_saves_ymm && (info[1] & (1 << 5)) != 0)
+		{
+			return TransformKernel::AVX2;
+		}
+#else
+		if (__builtin_cpu_supports("avx512f"))
+		{
+			return TransformKernel::AVX512;
+		}
+
+		if (__builtin_cpu_supports("avx2"))
+		{
+			return TransformKernel::AVX2;
+		}
+#endif
+
+		return TransformKernel::SSE;
+	}
+}
+
+TransformKernel bestTransformKernel()
+{
+	static TransformKernel const kernel = detectTransformKernel();
+
+	return kernel;
+}
+
+void transformTransposed(
+	DirectX::XMFLOAT4X4 const* world,
+	std::size_t count,
+	DirectX::XMFLOAT4X4 const& view_proj,
+	void* out,
+	std::size_t out_stride_in_bytes)
+{
+	transformTransposed(bestTransformKernel(), world, count, view_proj, out, out_stride_in_bytes);
+}
+
+void transformTransposed(
+	TransformKernel kernel,
+	DirectX::XMFLOAT4X4 const* world,
+	std::size_t count,
+	DirectX::XMFLOAT4X4 const& view_proj,
+	void* out,
+	std::size_t out_stride_in_bytes)
+{
+	if (kernel == TransformKernel::Scalar)
+	{
+		transformTransposedScalar(world, count, view_proj, out, out_stride_in_bytes);
+		return;
+	}
+
+	assert(reinterpret_cast<std::uintptr_t>(out) % 16 == 0 && out_stride_in_bytes % 16 == 0);
+
+	auto world_data = reinterpret_cast<float const*>(world);
+	auto out_data = static_cast<unsigned char*>(out);
+
+	__m128 vp[4];
+
+	for (int k = 0; k < 4; ++k)
+	{
+		vp[k] = _mm_loadu_ps(view_proj.m[k]);
+	}
+
+	std::size_t i = 0;
+
+	if (kernel == TransformKernel::AVX512)
+	{
+		i = transformQuads(world_data, count, vp, out_data, out_stride_in_bytes);
+	}
+	else if (kernel == TransformKernel::AVX2)
+	{
+		i = transformPairs(world_data, count, vp, out_data, out_stride_in_bytes);
+	}
+
+	for (; i < count; ++i)
+	{
+		transformOne(world_data + 16 * i, vp, reinterpret_cast<float*>(out_data + i * out_stride_in_bytes));
+	}
+
+	_mm_sfence();
+}
+
+void transformTransposedScalar(
+	DirectX::XMFLOAT4X4 const* world,
+	std::size_t count,
+	DirectX::XMFLOAT4X4 const& view_proj,
+	void* out,
+	std::size_t out_stride_in_bytes)
+{
+	auto out_data = static_cast<unsigned char*>(out);
+
+	for (std::size_t n = 0; n < count; ++n)
+	{
+		auto result = reinterpret_cast<float*>(out_data + n * out_stride_in_bytes);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				float sum = 0.0f;
+
+				for (int k = 0; k < 4; ++k)
+				{
+					sum += world[n].m[i][k] * view_proj.m[k][j];
+				}
+
+				result[4 * j + i] = sum;
+			}
+		}
+	}
+}
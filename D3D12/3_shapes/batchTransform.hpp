@@ -0,0 +1,52 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+
+enum class TransformKernel
+{
+	Scalar,
+	SSE,
+	AVX2,
+	AVX512
+};
+
+// Widest kernel the CPU and OS support, checked once.
+TransformKernel bestTransformKernel();
+
+// Writes transpose(world[i] * view_proj) for count matrices, the layout
+// HLSL expects for a float4x4 built from row-vector DirectXMath matrices,
+// straight into out: element i goes to out + i * out_stride_in_bytes, e.g.
+// mapped ObjectConstants at a 256-byte stride. out and the stride must be
+// multiples of 16 bytes. Stores are non-temporal, as for UploadBuffer's
+// bulk writes.
+//
+// Uses AVX-512 (four matrices per iteration) or AVX2 (two) when the CPU
+// supports them, SSE otherwise. All kernels multiply and add without
+// fusing, so they give the same results as transformTransposedScalar as
+// long as the compiler does not contract the scalar code into FMAs.
+void transformTransposed(
+	DirectX::XMFLOAT4X4 const* world,
+	std::size_t count,
+	DirectX::XMFLOAT4X4 const& view_proj,
+	void* out,
+	std::size_t out_stride_in_bytes);
+
+// Runs the given kernel, which the CPU must support; for benchmarks and
+// tests.
+void transformTransposed(
+	TransformKernel kernel,
+	DirectX::XMFLOAT4X4 const* world,
+	std::size_t count,
+	DirectX::XMFLOAT4X4 const& view_proj,
+	void* out,
+	std::size_t out_stride_in_bytes);
+
+// Plain C++ reference of transformTransposed, with ordinary stores.
+void transformTransposedScalar(
+	DirectX::XMFLOAT4X4 const* world,
+	std::size_t count,
+	DirectX::XMFLOAT4X4 const& view_proj,
+	void* out,
+	std::size_t out_stride_in_bytes);
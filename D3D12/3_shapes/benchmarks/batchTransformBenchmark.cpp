@@ -0,0 +1,153 @@
+// Times transformTransposed for 1k, 100k and 1M matrices with every kernel
+// the CPU supports, against the scalar reference, into host memory at the
+// packed and constant buffer strides. Builds without a device, e.g. from
+// D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. benchmarks\batchTransformBenchmark.cpp batchTransform.cpp
+//	g++ -std=c++17 -O2 -ffp-contract=off -I. benchmarks/batchTransformBenchmark.cpp batchTransform.cpp
+// (-ffp-contract=off keeps GCC from fusing the reference into FMAs, which
+// would make it differ from the kernels in the last bit.)
+
+#include "batchTransform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// Host memory standing in for a mapped upload heap, 64-byte aligned.
+	struct OutputBuffer
+	{
+		explicit OutputBuffer(std::size_t size_in_bytes)
+			:
+			storage(size_in_bytes + 64)
+		{
+			auto address = reinterpret_cast<std::uintptr_t>(storage.data());
+			data = storage.data() + ((64 - address % 64) % 64);
+		}
+
+		std::vector<unsigned char> storage;
+		unsigned char* data;
+	};
+
+	template <typename Function>
+	double bestMicroseconds(int repetitions, Function&& function)
+	{
+		double best = 1e30;
+
+		for (int r = 0; r < repetitions; ++r)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			auto end = std::chrono::steady_clock::now();
+
+			best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count());
+		}
+
+		return best;
+	}
+
+	char const* kernelName(TransformKernel kernel)
+	{
+		switch (kernel)
+		{
+		case TransformKernel::Scalar: return "scalar";
+		case TransformKernel::SSE: return "SSE";
+		case TransformKernel::AVX2: return "AVX2";
+		case TransformKernel::AVX512: return "AVX-512";
+		}
+
+		return "?";
+	}
+}
+
+int main()
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> distribution(-2.0f, 2.0f);
+
+	XMFLOAT4X4 view_proj;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			view_proj.m[i][j] = distribution(random);
+		}
+	}
+
+	TransformKernel best = bestTransformKernel();
+	std::printf("best kernel: %s\n", kernelName(best));
+
+	bool exact = true;
+
+	for (std::size_t count : { std::size_t(1000), std::size_t(100000), std::size_t(1000000) })
+	{
+		std::vector<XMFLOAT4X4> world(count);
+
+		for (auto& matrix : world)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				for (int j = 0; j < 4; ++j)
+				{
+					matrix.m[i][j] = distribution(random);
+				}
+			}
+		}
+
+		int repetitions = count >= 1000000 ? 5 : (count >= 100000 ? 20 : 500);
+
+		for (std::size_t stride : { std::size_t(64), std::size_t(256) })
+		{
+			OutputBuffer reference(count * stride);
+			OutputBuffer result(count * stride);
+
+			double scalar_time = bestMicroseconds(repetitions, [&]
+			{
+				transformTransposedScalar(world.data(), count, view_proj, reference.data, stride);
+			});
+
+			std::printf("%8zu matrices, stride %3zu: scalar %10.1f us", count, stride, scalar_time);
+
+			for (int k = static_cast<int>(TransformKernel::SSE); k <= static_cast<int>(best); ++k)
+			{
+				TransformKernel kernel = static_cast<TransformKernel>(k);
+
+				double time = bestMicroseconds(repetitions, [&]
+				{
+					transformTransposed(kernel, world.data(), count, view_proj, result.data, stride);
+				});
+
+				float max_error = 0.0f;
+
+				for (std::size_t n = 0; n < count; ++n)
+				{
+					auto a = reinterpret_cast<float const*>(reference.data + n * stride);
+					auto b = reinterpret_cast<float const*>(result.data + n * stride);
+
+					for (int e = 0; e < 16; ++e)
+					{
+						max_error = std::max(max_error, std::fabs(a[e] - b[e]));
+					}
+				}
+
+				exact &= max_error == 0.0f;
+
+				std::printf(", %s %10.1f us (x%.1f, max error %g)", kernelName(kernel), time, scalar_time / time, max_error);
+			}
+
+			std::printf("\n");
+		}
+	}
+
+	std::printf(exact ? "all kernels match the scalar reference exactly\n" : "kernels differ from the scalar reference\n");
+
+	return exact ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+// Times BoundsBuilder::computeBox and computeSphere over 10M packed
+// positions and the same positions in GeometryGenerator::Vertex, against a
+// scalar min/max loop. Checks that the packed fold gives exactly the scalar
+// box, for small counts that exercise the tail as well, and that the
+// sphere contains every point. Builds without a device, e.g. from
+// D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. benchmarks\boundsBuilderBenchmark.cpp boundsBuilder.cpp
+//	g++ -std=c++17 -O2 -I. benchmarks/boundsBuilderBenchmark.cpp boundsBuilder.cpp
+
+#include "boundsBuilder.hpp"
+#include "geometryGenerator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	template <typename Function>
+	double bestMilliseconds(int repetitions, Function&& function)
+	{
+		double best = 1e30;
+
+		for (int r = 0; r < repetitions; ++r)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			auto end = std::chrono::steady_clock::now();
+
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+
+		return best;
+	}
+
+	BoundingBox scalarBox(std::vector<XMFLOAT3> const& positions, std::size_t count)
+	{
+		if (count == 0)
+		{
+			return BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+		}
+
+		XMFLOAT3 lo = positions[0];
+		XMFLOAT3 hi = positions[0];
+
+		for (std::size_t i = 1; i < count; ++i)
+		{
+			lo.x = std::min(lo.x, positions[i].x);
+			lo.y = std::min(lo.y, positions[i].y);
+			lo.z = std::min(lo.z, positions[i].z);
+			hi.x = std::max(hi.x, positions[i].x);
+			hi.y = std::max(hi.y, positions[i].y);
+			hi.z = std::max(hi.z, positions[i].z);
+		}
+
+		BoundingBox box;
+		BoundingBox::CreateFromPoints(box, XMLoadFloat3(&lo), XMLoadFloat3(&hi));
+
+		return box;
+	}
+
+	bool sameBox(BoundingBox const& a, BoundingBox const& b)
+	{
+		return
+			a.Center.x == b.Center.x && a.Center.y == b.Center.y && a.Center.z == b.Center.z &&
+			a.Extents.x == b.Extents.x && a.Extents.y == b.Extents.y && a.Extents.z == b.Extents.z;
+	}
+
+	bool containsAll(BoundingSphere const& sphere, std::vector<XMFLOAT3> const& positions, std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			float dx = positions[i].x - sphere.Center.x;
+			float dy = positions[i].y - sphere.Center.y;
+			float dz = positions[i].z - sphere.Center.z;
+
+			if (std::sqrt(dx * dx + dy * dy + dz * dz) > sphere.Radius * 1.00001f + 1e-5f)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+int main()
+{
+	std::size_t const count = 10000000;
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+
+	std::vector<XMFLOAT3> positions(count);
+
+	for (auto& position : positions)
+	{
+		position = XMFLOAT3(distribution(random), distribution(random), distribution(random));
+	}
+
+	BoundsBuilder bounds_builder;
+	bool correct = true;
+
+	// Every remainder of the packed loop, and the counts below four that
+	// skip it.
+	for (std::size_t small_count = 0; small_count <= 16; ++small_count)
+	{
+		bool box_correct = sameBox(bounds_builder.computeBox(positions.data(), small_count), scalarBox(positions, small_count));
+		bool sphere_correct = containsAll(bounds_builder.computeSphere(positions.data(), small_count), positions, small_count);
+
+		if (!box_correct || !sphere_correct)
+		{
+			std::printf("%zu positions:%s%s\n", small_count, box_correct ? "" : " box MISMATCH", sphere_correct ? "" : " sphere misses points");
+		}
+
+		correct &= box_correct && sphere_correct;
+	}
+
+	std::vector<GeometryGenerator::Vertex> vertices(count);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		vertices[i].position = positions[i];
+	}
+
+	BoundingBox reference;
+	BoundingBox packed;
+	BoundingBox strided;
+	BoundingSphere sphere;
+
+	double scalar_time = bestMilliseconds(5, [&]
+	{
+		reference = scalarBox(positions, count);
+	});
+
+	double packed_time = bestMilliseconds(5, [&]
+	{
+		packed = bounds_builder.computeBox(positions.data(), count);
+	});
+
+	double strided_time = bestMilliseconds(5, [&]
+	{
+		strided = bounds_builder.computeBox(&vertices[0].position, count, sizeof(GeometryGenerator::Vertex));
+	});
+
+	double sphere_time = bestMilliseconds(3, [&]
+	{
+		sphere = bounds_builder.computeSphere(positions.data(), count);
+	});
+
+	bool packed_correct = sameBox(packed, reference);
+	bool strided_correct = sameBox(strided, reference);
+	bool sphere_correct = containsAll(sphere, positions, count);
+
+	correct &= packed_correct && strided_correct && sphere_correct;
+
+	std::printf("%zu positions\n", count);
+	std::printf("  scalar min/max               %8.2f ms\n", scalar_time);
+	std::printf("  computeBox, packed           %8.2f ms (x%.1f)%s\n", packed_time, scalar_time / packed_time, packed_correct ? "" : " MISMATCH");
+	std::printf("  computeBox, Vertex stride    %8.2f ms (x%.1f)%s\n", strided_time, scalar_time / strided_time, strided_correct ? "" : " MISMATCH");
+	std::printf("  computeSphere, packed        %8.2f ms, radius %g%s\n", sphere_time, sphere.Radius, sphere_correct ? "" : " misses points");
+
+	std::printf(correct ? "all boxes match the scalar min/max\n" : "FAILED\n");
+
+	return correct ? 0 : 1;
+}
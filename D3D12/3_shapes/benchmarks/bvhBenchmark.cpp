@@ -0,0 +1,277 @@
+// Times Bvh::build, both refits, queryFrustum, queryBox and raycast over 1M
+// random boxes, and checks every query against brute force after the build
+// and after each refit. Builds without a device, e.g. from D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. benchmarks\bvhBenchmark.cpp bvh.cpp
+//	g++ -std=c++17 -O2 -I. benchmarks/bvhBenchmark.cpp bvh.cpp
+
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	struct Ray
+	{
+		XMFLOAT3 origin;
+		XMFLOAT3 direction;
+	};
+
+	double milliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	bool outsideFrustum(Frustum const& frustum, BoundingBox const& box)
+	{
+		for (auto const& plane : frustum.planes)
+		{
+			float distance = plane.x * box.Center.x + plane.y * box.Center.y + plane.z * box.Center.z + plane.w;
+
+			float radius =
+				std::fabs(plane.x) * box.Extents.x +
+				std::fabs(plane.y) * box.Extents.y +
+				std::fabs(plane.z) * box.Extents.z;
+
+			if (distance + radius < 0.0f)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool overlaps(BoundingBox const& a, BoundingBox const& b)
+	{
+		return
+			std::fabs(a.Center.x - b.Center.x) <= a.Extents.x + b.Extents.x &&
+			std::fabs(a.Center.y - b.Center.y) <= a.Extents.y + b.Extents.y &&
+			std::fabs(a.Center.z - b.Center.z) <= a.Extents.z + b.Extents.z;
+	}
+
+	// Distance along ray to box, FLT_MAX on a miss; same slab test as Bvh.
+	float rayDistance(Ray const& ray, BoundingBox const& box)
+	{
+		float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+		float direction[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+		float center[3] = { box.Center.x, box.Center.y, box.Center.z };
+		float extents[3] = { box.Extents.x, box.Extents.y, box.Extents.z };
+
+		float t_near = 0.0f;
+		float t_far = FLT_MAX;
+
+		for (int k = 0; k < 3; ++k)
+		{
+			float t0 = (center[k] - extents[k] - origin[k]) / direction[k];
+			float t1 = (center[k] + extents[k] - origin[k]) / direction[k];
+
+			t_near = std::max(t_near, std::min(t0, t1));
+			t_far = std::min(t_far, std::max(t0, t1));
+		}
+
+		return t_near <= t_far ? t_near : FLT_MAX;
+	}
+
+	class Checker
+	{
+	public:
+		Checker(
+			std::vector<BoundingBox> const& bounds,
+			Frustum const& frustum,
+			BoundingBox const& query_box,
+			std::vector<Ray> const& rays)
+			:
+			bounds(bounds),
+			frustum(frustum),
+			query_box(query_box),
+			rays(rays)
+		{
+
+		}
+
+		// Runs every query, prints its time and compares it with brute force.
+		void run(Bvh const& bvh, char const* stage)
+		{
+			std::vector<std::uint32_t> result;
+			std::vector<std::uint32_t> reference;
+
+			auto start = std::chrono::steady_clock::now();
+			bvh.queryFrustum(frustum, result);
+			double frustum_time = milliseconds(start);
+
+			for (std::uint32_t i = 0; i < bounds.size(); ++i)
+			{
+				if (!outsideFrustum(frustum, bounds[i]))
+				{
+					reference.push_back(i);
+				}
+			}
+
+			std::sort(result.begin(), result.end());
+			bool frustum_correct = result == reference;
+			std::size_t frustum_count = result.size();
+
+			result.clear();
+			reference.clear();
+
+			start = std::chrono::steady_clock::now();
+			bvh.queryBox(query_box, result);
+			double box_time = milliseconds(start);
+
+			for (std::uint32_t i = 0; i < bounds.size(); ++i)
+			{
+				if (overlaps(query_box, bounds[i]))
+				{
+					reference.push_back(i);
+				}
+			}
+
+			std::sort(result.begin(), result.end());
+			bool box_correct = result == reference;
+			std::size_t box_count = result.size();
+
+			double ray_time = 0.0;
+			std::uint32_t ray_hits = 0;
+			std::uint32_t ray_mismatches = 0;
+
+			for (auto const& ray : rays)
+			{
+				std::uint32_t hit_primitive = 0;
+				float hit_distance = 0.0f;
+
+				start = std::chrono::steady_clock::now();
+				bool hit = bvh.raycast(ray.origin, ray.direction, hit_primitive, hit_distance);
+				ray_time += milliseconds(start);
+
+				float nearest = FLT_MAX;
+
+				for (auto const& box : bounds)
+				{
+					nearest = std::min(nearest, rayDistance(ray, box));
+				}
+
+				// Several boxes can share the nearest distance, so compare
+				// distances rather than primitives.
+				bool correct = hit ?
+					nearest != FLT_MAX && std::fabs(hit_distance - nearest) <= 1e-4f * std::max(1.0f, nearest) :
+					nearest == FLT_MAX;
+
+				ray_hits += hit ? 1 : 0;
+				ray_mismatches += correct ? 0 : 1;
+			}
+
+			std::printf("  %s\n", stage);
+			std::printf("    queryFrustum %8.3f ms, %7zu boxes%s\n", frustum_time, frustum_count, frustum_correct ? "" : " MISMATCH");
+			std::printf("    queryBox     %8.3f ms, %7zu boxes%s\n", box_time, box_count, box_correct ? "" : " MISMATCH");
+			std::printf(
+				"    raycast      %8.2f us, %4u/%zu hits%s\n",
+				1000.0 * ray_time / rays.size(),
+				ray_hits,
+				rays.size(),
+				ray_mismatches == 0 ? "" : " MISMATCH");
+
+			correct &= frustum_correct && box_correct && ray_mismatches == 0;
+		}
+
+		bool allCorrect() const
+		{
+			return correct;
+		}
+
+	private:
+		std::vector<BoundingBox> const& bounds;
+		Frustum const frustum;
+		BoundingBox const query_box;
+		std::vector<Ray> const& rays;
+
+		bool correct = true;
+	};
+}
+
+int main()
+{
+	std::uint32_t const count = 1000000;
+	std::uint32_t const ray_count = 200;
+	std::uint32_t const moved_count = 10000;
+
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> size(0.1f, 2.0f);
+
+	std::vector<BoundingBox> bounds(count);
+
+	for (auto& box : bounds)
+	{
+		box = BoundingBox(
+			XMFLOAT3(position(random), position(random), position(random)),
+			XMFLOAT3(size(random), size(random), size(random)));
+	}
+
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 1.5f, 1.0f, 1200.0f);
+
+	XMFLOAT4X4 view_proj;
+	XMStoreFloat4x4(&view_proj, XMMatrixMultiply(XMMatrixTranslation(0.0f, 0.0f, 600.0f), proj));
+
+	std::vector<Ray> rays(ray_count);
+
+	for (auto& ray : rays)
+	{
+		ray.origin = XMFLOAT3(position(random), position(random), -600.0f);
+		ray.direction = XMFLOAT3(position(random) / 1000.0f, position(random) / 1000.0f, 1.0f);
+	}
+
+	Checker checker(bounds, Frustum::fromViewProj(view_proj), BoundingBox(XMFLOAT3(10.0f, 20.0f, 30.0f), XMFLOAT3(100.0f, 50.0f, 80.0f)), rays);
+
+	std::printf("%u boxes\n", count);
+
+	Bvh bvh;
+
+	auto start = std::chrono::steady_clock::now();
+	bvh.build(bounds);
+	std::printf("  build                %8.1f ms, %zu nodes\n", milliseconds(start), bvh.getNodes().size());
+
+	checker.run(bvh, "after build");
+
+	// Every box drifts a little, then a full refit.
+	for (auto& box : bounds)
+	{
+		box.Center.x += size(random);
+		box.Center.y -= size(random);
+	}
+
+	start = std::chrono::steady_clock::now();
+	bvh.refit(bounds);
+	std::printf("  refit                %8.1f ms\n", milliseconds(start));
+
+	checker.run(bvh, "after full refit");
+
+	// A few boxes move far, each refit on its own.
+	std::uniform_int_distribution<std::uint32_t> primitive(0, count - 1);
+	double single_time = 0.0;
+
+	for (std::uint32_t i = 0; i < moved_count; ++i)
+	{
+		std::uint32_t moved = primitive(random);
+
+		bounds[moved].Center = XMFLOAT3(position(random), position(random), position(random));
+
+		start = std::chrono::steady_clock::now();
+		bvh.refit(moved, bounds[moved]);
+		single_time += milliseconds(start);
+	}
+
+	std::printf("  refit(primitive)     %8.2f us each, %u primitives\n", 1000.0 * single_time / moved_count, moved_count);
+
+	checker.run(bvh, "after single-primitive refits");
+
+	std::printf(checker.allCorrect() ? "all queries match brute force\n" : "FAILED\n");
+
+	return checker.allCorrect() ? 0 : 1;
+}
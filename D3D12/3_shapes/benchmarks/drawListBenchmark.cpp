@@ -0,0 +1,124 @@
+// Times DrawList::sort and DrawList::sort(ThreadPool&) on 1M keys against
+// std::stable_sort, checks that all three give the same order, and prints
+// the state changes before and after sorting. Builds without a device,
+// e.g. from D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. benchmarks\drawListBenchmark.cpp drawList.cpp
+//	g++ -std=c++17 -O2 -pthread -I. benchmarks/drawListBenchmark.cpp drawList.cpp
+
+#include "drawList.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+	double milliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	bool sameOrder(std::vector<DrawList::Item> const& a, std::vector<DrawList::Item> const& b)
+	{
+		if (a.size() != b.size())
+		{
+			return false;
+		}
+
+		for (std::size_t i = 0; i < a.size(); ++i)
+		{
+			if (a[i].key != b[i].key || a[i].draw != b[i].draw)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void printStatistics(char const* name, DrawList::Statistics const& statistics)
+	{
+		std::printf(
+			"  %-10s root signatures %7u, PSOs %7u, meshes %7u, materials %7u\n",
+			name,
+			statistics.root_signature_changes,
+			statistics.pso_changes,
+			statistics.mesh_changes,
+			statistics.material_changes);
+	}
+}
+
+int main()
+{
+	std::uint32_t const count = 1000000;
+
+	std::mt19937_64 random(7);
+	std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+
+	ThreadPool thread_pool;
+	bool correct = true;
+
+	// Keys of a scene with a few root signatures and PSOs, then fully random
+	// keys, where no radix pass can be skipped.
+	for (bool random_keys : { false, true })
+	{
+		DrawList single_threaded;
+		DrawList multi_threaded;
+
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			std::uint64_t key = random_keys ?
+				random() :
+				DrawList::makeKey(
+					static_cast<std::uint32_t>(random() % 3),
+					static_cast<std::uint32_t>(random() % 40),
+					static_cast<std::uint32_t>(random() % 500),
+					depth(random),
+					static_cast<std::uint32_t>(random() % 200));
+
+			single_threaded.add(key, i);
+			multi_threaded.add(key, i);
+		}
+
+		std::vector<DrawList::Item> reference = single_threaded.getItems();
+
+		auto start = std::chrono::steady_clock::now();
+
+		std::stable_sort(reference.begin(), reference.end(), [](DrawList::Item const& a, DrawList::Item const& b)
+		{
+			return a.key < b.key;
+		});
+
+		double stable_sort_time = milliseconds(start);
+
+		start = std::chrono::steady_clock::now();
+		single_threaded.sort();
+		double single_threaded_time = milliseconds(start);
+
+		start = std::chrono::steady_clock::now();
+		multi_threaded.sort(thread_pool);
+		double multi_threaded_time = milliseconds(start);
+
+		bool single_threaded_correct = sameOrder(single_threaded.getItems(), reference);
+		bool multi_threaded_correct = sameOrder(multi_threaded.getItems(), reference);
+
+		correct &= single_threaded_correct && multi_threaded_correct;
+
+		std::printf("%u %s keys\n", count, random_keys ? "random" : "scene");
+		std::printf("  std::stable_sort        %8.2f ms\n", stable_sort_time);
+		std::printf("  sort()                  %8.2f ms%s\n", single_threaded_time, single_threaded_correct ? "" : " WRONG ORDER");
+		std::printf(
+			"  sort(ThreadPool&), %2u threads %8.2f ms%s\n",
+			thread_pool.threadCount(),
+			multi_threaded_time,
+			multi_threaded_correct ? "" : " WRONG ORDER");
+
+		printStatistics("submitted", single_threaded.getSubmittedStatistics());
+		printStatistics("sorted", single_threaded.getSortedStatistics());
+	}
+
+	std::printf(correct ? "both sorts match std::stable_sort\n" : "FAILED\n");
+
+	return correct ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+// Times FrustumCuller::cull with the box and the sphere test, single
+// threaded and with a ThreadPool, for 100k and 1M rotated and scaled
+// objects, and checks every visible set against a scalar reference. Builds
+// without a device, e.g. from D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. benchmarks\frustumCullerBenchmark.cpp frustumCuller.cpp
+//	g++ -std=c++17 -O2 -pthread -I. benchmarks/frustumCullerBenchmark.cpp frustumCuller.cpp
+
+#include "frustumCuller.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	template <typename Function>
+	double bestMicroseconds(int repetitions, Function&& function)
+	{
+		double best = 1e30;
+
+		for (int r = 0; r < repetitions; ++r)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			auto end = std::chrono::steady_clock::now();
+
+			best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count());
+		}
+
+		return best;
+	}
+
+	// World AABB of local_bounds under world, one object at a time.
+	BoundingBox worldBounds(BoundingBox const& local_bounds, XMFLOAT4X4 const& world)
+	{
+		XMFLOAT3 const& c = local_bounds.Center;
+		XMFLOAT3 const& e = local_bounds.Extents;
+		auto const& m = world.m;
+
+		BoundingBox result;
+
+		result.Center.x = c.x * m[0][0] + c.y * m[1][0] + c.z * m[2][0] + m[3][0];
+		result.Center.y = c.x * m[0][1] + c.y * m[1][1] + c.z * m[2][1] + m[3][1];
+		result.Center.z = c.x * m[0][2] + c.y * m[1][2] + c.z * m[2][2] + m[3][2];
+
+		result.Extents.x = e.x * std::fabs(m[0][0]) + e.y * std::fabs(m[1][0]) + e.z * std::fabs(m[2][0]);
+		result.Extents.y = e.x * std::fabs(m[0][1]) + e.y * std::fabs(m[1][1]) + e.z * std::fabs(m[2][1]);
+		result.Extents.z = e.x * std::fabs(m[0][2]) + e.y * std::fabs(m[1][2]) + e.z * std::fabs(m[2][2]);
+
+		return result;
+	}
+
+	bool boxVisible(Frustum const& frustum, BoundingBox const& box)
+	{
+		for (auto const& plane : frustum.planes)
+		{
+			float distance = plane.x * box.Center.x + plane.y * box.Center.y + plane.z * box.Center.z + plane.w;
+
+			float radius =
+				std::fabs(plane.x) * box.Extents.x +
+				std::fabs(plane.y) * box.Extents.y +
+				std::fabs(plane.z) * box.Extents.z;
+
+			if (distance + radius < 0.0f)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool sphereVisible(Frustum const& frustum, BoundingBox const& box)
+	{
+		XMFLOAT3 const& e = box.Extents;
+
+		return frustum.intersectsSphere(box.Center, std::sqrt(e.x * e.x + e.y * e.y + e.z * e.z));
+	}
+}
+
+int main()
+{
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> position(-400.0f, 400.0f);
+	std::uniform_real_distribution<float> size(0.1f, 3.0f);
+	std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+
+	XMMATRIX proj = XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 1.5f, 1.0f, 500.0f);
+
+	XMFLOAT4X4 view_proj;
+	XMStoreFloat4x4(&view_proj, XMMatrixMultiply(XMMatrixTranslation(0.0f, 0.0f, 50.0f), proj));
+
+	Frustum frustum = Frustum::fromViewProj(view_proj);
+
+	ThreadPool thread_pool;
+	bool correct = true;
+
+	std::printf("%u threads\n", thread_pool.threadCount());
+
+	for (std::uint32_t count : { 100000u, 1000000u })
+	{
+		FrustumCuller culler;
+		std::vector<BoundingBox> world_bounds(count);
+
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			BoundingBox local_bounds(
+				XMFLOAT3(size(random), size(random), size(random)),
+				XMFLOAT3(size(random), size(random), size(random)));
+
+			XMFLOAT4X4 world;
+			XMStoreFloat4x4(&world,
+				XMMatrixScaling(size(random), size(random), size(random)) *
+				XMMatrixRotationRollPitchYaw(angle(random), angle(random), angle(random)) *
+				XMMatrixTranslation(position(random), position(random), position(random) + 400.0f));
+
+			culler.addObject(local_bounds, world);
+			world_bounds[i] = worldBounds(local_bounds, world);
+		}
+
+		int repetitions = count >= 1000000 ? 10 : 50;
+
+		for (FrustumCuller::Test test : { FrustumCuller::Test::Box, FrustumCuller::Test::Sphere })
+		{
+			bool box = test == FrustumCuller::Test::Box;
+
+			std::vector<std::uint32_t> reference;
+			std::vector<std::uint32_t> single_threaded;
+			std::vector<std::uint32_t> multi_threaded;
+
+			double scalar_time = bestMicroseconds(repetitions, [&]
+			{
+				reference.clear();
+
+				for (std::uint32_t i = 0; i < count; ++i)
+				{
+					if (box ? boxVisible(frustum, world_bounds[i]) : sphereVisible(frustum, world_bounds[i]))
+					{
+						reference.push_back(i);
+					}
+				}
+			});
+
+			double single_threaded_time = bestMicroseconds(repetitions, [&]
+			{
+				culler.cull(frustum, single_threaded, test);
+			});
+
+			double multi_threaded_time = bestMicroseconds(repetitions, [&]
+			{
+				culler.cull(frustum, multi_threaded, thread_pool, test);
+			});
+
+			bool single_threaded_correct = single_threaded == reference;
+			bool multi_threaded_correct = multi_threaded == reference;
+
+			correct &= single_threaded_correct && multi_threaded_correct;
+
+			std::printf(
+				"%8u objects, %-6s test: %7zu visible, scalar %8.1f us, cull %8.1f us (x%.1f)%s, ThreadPool %8.1f us (x%.1f)%s\n",
+				count,
+				box ? "box" : "sphere",
+				reference.size(),
+				scalar_time,
+				single_threaded_time,
+				scalar_time / single_threaded_time,
+				single_threaded_correct ? "" : " MISMATCH",
+				multi_threaded_time,
+				scalar_time / multi_threaded_time,
+				multi_threaded_correct ? "" : " MISMATCH");
+		}
+	}
+
+	std::printf(correct ? "all visible sets match the scalar reference\n" : "FAILED\n");
+
+	return correct ? 0 : 1;
+}
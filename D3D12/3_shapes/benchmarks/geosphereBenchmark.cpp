@@ -0,0 +1,104 @@
+// Times createGeosphere with SubdivisionMode::Split, the original path that
+// duplicates every edge midpoint, against SubdivisionMode::Welded for
+// levels 0 to 6, and prints the vertex counts of both. Checks that the
+// welded mesh has the 10 * 4^level + 2 vertices of a closed geosphere and
+// draws the same triangles as the split one. Builds without a device,
+// e.g. from D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. benchmarks\geosphereBenchmark.cpp geometryGenerator.cpp boundsBuilder.cpp
+//	g++ -std=c++17 -O2 -pthread -I. benchmarks/geosphereBenchmark.cpp geometryGenerator.cpp boundsBuilder.cpp
+
+#include "geometryGenerator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+namespace
+{
+	template <typename Function>
+	double bestMilliseconds(int repetitions, Function&& function)
+	{
+		double best = 1e30;
+
+		for (int r = 0; r < repetitions; ++r)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			auto end = std::chrono::steady_clock::now();
+
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+
+		return best;
+	}
+
+	// Largest distance between corresponding corners of the two meshes.
+	float maxCornerDistance(GeometryGenerator::MeshData const& a, GeometryGenerator::MeshData const& b)
+	{
+		float result = 0.0f;
+
+		for (std::size_t i = 0; i < a.indices_32.size(); ++i)
+		{
+			auto const& p = a.vertices[a.indices_32[i]].position;
+			auto const& q = b.vertices[b.indices_32[i]].position;
+
+			result = std::max(result, std::sqrt(
+				(p.x - q.x) * (p.x - q.x) +
+				(p.y - q.y) * (p.y - q.y) +
+				(p.z - q.z) * (p.z - q.z)));
+		}
+
+		return result;
+	}
+}
+
+int main()
+{
+	GeometryGenerator geometry_generator;
+	bool correct = true;
+
+	for (std::uint32_t level = 0; level <= 6; ++level)
+	{
+		int repetitions = level >= 5 ? 5 : 50;
+
+		GeometryGenerator::MeshData split;
+		GeometryGenerator::MeshData welded;
+
+		double split_time = bestMilliseconds(repetitions, [&]
+		{
+			split = geometry_generator.createGeosphere(1.0f, level, GeometryGenerator::SubdivisionMode::Split);
+		});
+
+		double welded_time = bestMilliseconds(repetitions, [&]
+		{
+			welded = geometry_generator.createGeosphere(1.0f, level, GeometryGenerator::SubdivisionMode::Welded);
+		});
+
+		std::size_t expected_vertices = 10 * (std::size_t(1) << (2 * level)) + 2;
+
+		bool same_triangles =
+			split.indices_32.size() == welded.indices_32.size() &&
+			maxCornerDistance(split, welded) <= 1e-5f;
+
+		bool level_correct = same_triangles && welded.vertices.size() == expected_vertices;
+
+		correct &= level_correct;
+
+		std::printf(
+			"level %u: %7zu triangles, split %8.3f ms %7zu vertices, welded %8.3f ms %7zu vertices (x%.1f)%s\n",
+			level,
+			welded.indices_32.size() / 3,
+			split_time,
+			split.vertices.size(),
+			welded_time,
+			welded.vertices.size(),
+			split_time / welded_time,
+			level_correct ? "" : " MISMATCH");
+	}
+
+	std::printf(correct ? "welded meshes match the split ones\n" : "FAILED\n");
+
+	return correct ? 0 : 1;
+}
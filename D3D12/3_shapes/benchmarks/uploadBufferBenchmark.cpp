@@ -0,0 +1,158 @@
+// Times UploadBuffer's bulk writes against its per-element copyData for
+// 50k ObjectConstants-sized elements, with host memory standing in for the
+// mapped upload heap. Runs the same streamCopyElements and
+// streamFillElements the bulk writes are built on. Builds without a
+// device, e.g. from D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. benchmarks\uploadBufferBenchmark.cpp
+//	g++ -std=c++17 -O2 -I. benchmarks/uploadBufferBenchmark.cpp
+//
+// Host memory is write-back rather than write-combined, so this
+// understates what streaming stores save on a real upload heap.
+
+#include "streamCopy.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	// Same size as ObjectConstants, a transposed float4x4.
+	struct Constants
+	{
+		float world[16];
+	};
+
+	// Mapped upload heaps are 64 KB aligned.
+	struct MappedBuffer
+	{
+		explicit MappedBuffer(std::size_t size_in_bytes)
+			:
+			storage(size_in_bytes + 65536)
+		{
+			auto address = reinterpret_cast<std::uintptr_t>(storage.data());
+			data = storage.data() + ((65536 - address % 65536) % 65536);
+		}
+
+		std::vector<unsigned char> storage;
+		unsigned char* data;
+	};
+
+	template <typename Function>
+	double bestMicroseconds(Function&& function)
+	{
+		double best = 1e30;
+
+		for (int r = 0; r < 50; ++r)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			auto end = std::chrono::steady_clock::now();
+
+			best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count());
+		}
+
+		return best;
+	}
+
+	bool matches(MappedBuffer const& buffer, std::vector<Constants> const& source, std::size_t stride)
+	{
+		for (std::size_t i = 0; i < source.size(); ++i)
+		{
+			if (std::memcmp(buffer.data + i * stride, &source[i], sizeof(Constants)) != 0)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+int main()
+{
+	std::uint32_t const count = 50000;
+
+	// Wider source records for the strided copy, e.g. a scene's objects.
+	struct Object
+	{
+		Constants constants;
+		float bounds[8];
+	};
+
+	std::vector<Constants> source(count);
+	std::vector<Object> objects(count);
+
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		for (int e = 0; e < 16; ++e)
+		{
+			source[i].world[e] = static_cast<float>(i * 16 + e);
+		}
+
+		objects[i].constants = source[i];
+	}
+
+	bool correct = true;
+
+	// 256 is the constant buffer stride, sizeof(Constants) a structured buffer.
+	for (std::size_t stride : { std::size_t(256), sizeof(Constants) })
+	{
+		MappedBuffer mapped(count * stride);
+
+		std::printf("stride %zu, %u elements\n", stride, count);
+
+		// copyData(int, T const&) per element, as before the bulk writes.
+		double per_element = bestMicroseconds([&]
+		{
+			for (int i = 0; i < static_cast<int>(count); ++i)
+			{
+				std::memcpy(&mapped.data[i * stride], &source[i], sizeof(Constants));
+			}
+		});
+
+		correct &= matches(mapped, source, stride);
+		std::memset(mapped.data, 0, count * stride);
+
+		double span = bestMicroseconds([&]
+		{
+			streamCopyElements(mapped.data, stride, source.data(), sizeof(Constants), sizeof(Constants), count);
+			streamFence();
+		});
+
+		correct &= matches(mapped, source, stride);
+		std::memset(mapped.data, 0, count * stride);
+
+		double strided = bestMicroseconds([&]
+		{
+			streamCopyElements(mapped.data, stride, &objects[0].constants, sizeof(Object), sizeof(Constants), count);
+			streamFence();
+		});
+
+		correct &= matches(mapped, source, stride);
+		std::memset(mapped.data, 0, count * stride);
+
+		double fill = bestMicroseconds([&]
+		{
+			streamFillElements<Constants>(mapped.data, stride, 0, count, [&](std::uint32_t index, Constants& element)
+			{
+				element = source[index];
+			});
+
+			streamFence();
+		});
+
+		correct &= matches(mapped, source, stride);
+
+		std::printf("  per-element copyData  %8.1f us\n", per_element);
+		std::printf("  copyData span         %8.1f us (x%.2f)\n", span, per_element / span);
+		std::printf("  copyStrided           %8.1f us (x%.2f)\n", strided, per_element / strided);
+		std::printf("  fill                  %8.1f us (x%.2f)\n", fill, per_element / fill);
+	}
+
+	std::printf(correct ? "all writes correct\n" : "WRONG DATA\n");
+
+	return correct ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+#include "boundsBuilder.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+using namespace DirectX;
+
+namespace
+{
+	XMFLOAT3 const& positionAt(XMFLOAT3 const* positions, std::size_t i, std::size_t stride_in_bytes)
+	{
+		return *reinterpret_cast<XMFLOAT3 const*>(
+			reinterpret_cast<std::uint8_t const*>(positions) + i * stride_in_bytes);
+	}
+
+	// Folds the lanes of the three accumulators of a packed reduction, which
+	// hold (x y z x), (y z x y) and (z x y z), into one (x y z) vector.
+	template <typename Reduce>
+	XMVECTOR foldPackedLanes(XMVECTOR a, XMVECTOR b, XMVECTOR c, Reduce reduce)
+	{
+		XMVECTOR from_b = XMVectorSwizzle<2, 0, 1, 3>(b);
+		XMVECTOR from_c = XMVectorSwizzle<1, 2, 0, 3>(c);
+
+		XMVECTOR w_lanes = XMVectorPermute<3, 7, 0, 0>(a, b);
+		w_lanes = XMVectorPermute<0, 1, 7, 7>(w_lanes, c);
+
+		return reduce(reduce(a, from_b), reduce(from_c, w_lanes));
+	}
+}
+
+BoundingBox BoundsBuilder::computeBox(
+	XMFLOAT3 const* positions,
+	std::size_t count,
+	std::size_t stride_in_bytes)
+{
+	if (count == 0)
+	{
+		return BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+	}
+
+	XMVECTOR v_min = XMLoadFloat3(positions);
+	XMVECTOR v_max = v_min;
+
+	std::size_t i = 0;
+
+	if (stride_in_bytes == sizeof(XMFLOAT3))
+	{
+		// Four positions are twelve floats: three full vectors whose lanes
+		// always see the same components.
+		XMFLOAT4 const* floats = reinterpret_cast<XMFLOAT4 const*>(positions);
+
+		XMVECTOR min_a = v_min, min_b = v_min, min_c = v_min;
+		XMVECTOR max_a = v_min, max_b = v_min, max_c = v_min;
+
+		if (count >= 4)
+		{
+			min_a = max_a = XMLoadFloat4(floats + 0);
+			min_b = max_b = XMLoadFloat4(floats + 1);
+			min_c = max_c = XMLoadFloat4(floats + 2);
+
+			for (i = 4; i + 4 <= count; i += 4)
+			{
+				XMVECTOR a = XMLoadFloat4(floats + 3 * (i / 4) + 0);
+				XMVECTOR b = XMLoadFloat4(floats + 3 * (i / 4) + 1);
+				XMVECTOR c = XMLoadFloat4(floats + 3 * (i / 4) + 2);
+
+				min_a = XMVectorMin(min_a, a);
+				min_b = XMVectorMin(min_b, b);
+				min_c = XMVectorMin(min_c, c);
+				max_a = XMVectorMax(max_a, a);
+				max_b = XMVectorMax(max_b, b);
+				max_c = XMVectorMax(max_c, c);
+			}
+
+			v_min = foldPackedLanes(min_a, min_b, min_c, [](XMVECTOR x, XMVECTOR y) { return XMVectorMin(x, y); });
+			v_max = foldPackedLanes(max_a, max_b, max_c, [](XMVECTOR x, XMVECTOR y) { return XMVectorMax(x, y); });
+		}
+	}
+
+	for (; i < count; ++i)
+	{
+		XMVECTOR p = XMLoadFloat3(&positionAt(positions, i, stride_in_bytes));
+
+		v_min = XMVectorMin(v_min, p);
+		v_max = XMVectorMax(v_max, p);
+	}
+
+	BoundingBox box;
+	BoundingBox::CreateFromPoints(box, v_min, v_max);
+
+	return box;
+}
+
+BoundingSphere BoundsBuilder::computeSphere(
+	XMFLOAT3 const* positions,
+	std::size_t count,
+	std::size_t stride_in_bytes)
+{
+	if (count == 0)
+	{
+		return BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f);
+	}
+
+	// Sphere around the AABB center.
+	BoundingBox box = computeBox(positions, count, stride_in_bytes);
+	XMVECTOR box_center = XMLoadFloat3(&box.Center);
+
+	float box_radius_sq = 0.0f;
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		XMVECTOR p = XMLoadFloat3(&positionAt(positions, i, stride_in_bytes));
+		box_radius_sq = std::max(box_radius_sq, XMVectorGetX(XMVector3LengthSq(p - box_center)));
+	}
+
+	// Ritter: start from the two points farthest apart along the axis with
+	// the most spread, then grow the sphere to take in every outlier.
+	std::size_t min_index[3] = {}, max_index[3] = {};
+
+	for (std::size_t i = 1; i < count; ++i)
+	{
+		XMFLOAT3 const& p = positionAt(positions, i, stride_in_bytes);
+		float const components[3] = { p.x, p.y, p.z };
+
+		for (std::uint32_t axis = 0; axis < 3; ++axis)
+		{
+			float const* lo = &positionAt(positions, min_index[axis], stride_in_bytes).x;
+			float const* hi = &positionAt(positions, max_index[axis], stride_in_bytes).x;
+
+			if (components[axis] < lo[axis])
+			{
+				min_index[axis] = i;
+			}
+
+			if (components[axis] > hi[axis])
+			{
+				max_index[axis] = i;
+			}
+		}
+	}
+
+	XMVECTOR a = XMVectorZero(), b = XMVectorZero();
+	float widest_sq = -1.0f;
+
+	for (std::uint32_t axis = 0; axis < 3; ++axis)
+	{
+		XMVECTOR lo = XMLoadFloat3(&positionAt(positions, min_index[axis], stride_in_bytes));
+		XMVECTOR hi = XMLoadFloat3(&positionAt(positions, max_index[axis], stride_in_bytes));
+
+		float spread_sq = XMVectorGetX(XMVector3LengthSq(hi - lo));
+
+		if (spread_sq > widest_sq)
+		{
+			widest_sq = spread_sq;
+			a = lo;
+			b = hi;
+		}
+	}
+
+	XMVECTOR center = (a + b) * 0.5f;
+	float radius = 0.5f * sqrtf(widest_sq);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		XMVECTOR p = XMLoadFloat3(&positionAt(positions, i, stride_in_bytes));
+		float distance = XMVectorGetX(XMVector3Length(p - center));
+
+		if (distance > radius)
+		{
+			float new_radius = 0.5f * (radius + distance);
+			center += (p - center) * ((new_radius - radius) / distance);
+			radius = new_radius;
+		}
+	}
+
+	BoundingSphere sphere;
+
+	if (sqrtf(box_radius_sq) <= radius)
+	{
+		sphere.Center = box.Center;
+		sphere.Radius = sqrtf(box_radius_sq);
+	}
+	else
+	{
+		XMStoreFloat3(&sphere.Center, center);
+		sphere.Radius = radius;
+	}
+
+	return sphere;
+}
+
+BoundingOrientedBox BoundsBuilder::computeOrientedBox(
+	XMFLOAT3 const* positions,
+	std::size_t count,
+	std::size_t stride_in_bytes)
+{
+	BoundingOrientedBox box;
+
+	if (count == 0)
+	{
+		box.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		box.Extents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+		return box;
+	}
+
+	BoundingOrientedBox::CreateFromPoints(box, count, positions, stride_in_bytes);
+
+	return box;
+}
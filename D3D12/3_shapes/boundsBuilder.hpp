@@ -0,0 +1,33 @@
+#pragma once
+
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+
+#include <cstddef>
+
+// Bounding volumes over strided position streams. stride_in_bytes is the
+// distance between consecutive positions, so the same calls work on
+// GeometryGenerator::Vertex arrays and on tightly packed XMFLOAT3 arrays.
+class BoundsBuilder
+{
+public:
+	// Tight AABB. Packed XMFLOAT3 arrays are reduced four positions at a
+	// time with three unaligned vector loads and no shuffles.
+	DirectX::BoundingBox computeBox(
+		DirectX::XMFLOAT3 const* positions,
+		std::size_t count,
+		std::size_t stride_in_bytes = sizeof(DirectX::XMFLOAT3));
+
+	// The smaller of Ritter's sphere and the sphere around the AABB center.
+	DirectX::BoundingSphere computeSphere(
+		DirectX::XMFLOAT3 const* positions,
+		std::size_t count,
+		std::size_t stride_in_bytes = sizeof(DirectX::XMFLOAT3));
+
+	// Fitted along the principal axes of the points, which is much tighter
+	// than the AABB for long rotated shapes but costs a covariance pass.
+	DirectX::BoundingOrientedBox computeOrientedBox(
+		DirectX::XMFLOAT3 const* positions,
+		std::size_t count,
+		std::size_t stride_in_bytes = sizeof(DirectX::XMFLOAT3));
+};
@@ -0,0 +1,218 @@
+#include "buddyAllocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	bool isPowerOfTwo(std::uint64_t x)
+	{
+		return x != 0 && (x & (x - 1)) == 0;
+	}
+}
+
+BuddyAllocator::BuddyAllocator(std::uint64_t capacity, std::uint64_t min_block_size)
+	:
+	size{ capacity },
+	min_block_size{ min_block_size }
+{
+	assert(isPowerOfTwo(capacity) && isPowerOfTwo(min_block_size) && min_block_size <= capacity);
+
+	max_order = 0;
+
+	while (blockSizeOf(max_order) < capacity)
+	{
+		++max_order;
+	}
+
+	free_blocks.resize(max_order + 1);
+	free_blocks[max_order].insert(0);
+}
+
+std::uint64_t BuddyAllocator::allocate(std::uint64_t size, std::uint64_t alignment)
+{
+	assert(size > 0 && isPowerOfTwo(alignment));
+
+	if (size > this->size || alignment > this->size)
+	{
+		return invalid_offset;
+	}
+
+	std::uint32_t order = orderOf(std::max(size, alignment));
+
+	std::uint32_t source_order = order;
+
+	while (source_order <= max_order && free_blocks[source_order].empty())
+	{
+		++source_order;
+	}
+
+	if (source_order > max_order)
+	{
+		return invalid_offset;
+	}
+
+	std::uint64_t offset = *free_blocks[source_order].begin();
+	free_blocks[source_order].erase(free_blocks[source_order].begin());
+
+	// Split down to the requested order, keeping the lower half.
+	while (source_order > order)
+	{
+		--source_order;
+		free_blocks[source_order].insert(offset + blockSizeOf(source_order));
+	}
+
+	allocations[offset] = { order, size };
+
+	requested_bytes += size;
+	allocated_bytes += blockSizeOf(order);
+
+	return offset;
+}
+
+void BuddyAllocator::free(std::uint64_t offset)
+{
+	auto it = allocations.find(offset);
+	assert(it != allocations.end());
+
+	std::uint32_t order = it->second.order;
+
+	requested_bytes -= it->second.requested_size;
+	allocated_bytes -= blockSizeOf(order);
+
+	allocations.erase(it);
+
+	while (order < max_order)
+	{
+		std::uint64_t buddy = offset ^ blockSizeOf(order);
+		auto buddy_it = free_blocks[order].find(buddy);
+
+		if (buddy_it == free_blocks[order].end())
+		{
+			break;
+		}
+
+		free_blocks[order].erase(buddy_it);
+		offset = std::min(offset, buddy);
+		++order;
+	}
+
+	free_blocks[order].insert(offset);
+}
+
+std::uint64_t BuddyAllocator::blockSize(std::uint64_t offset) const
+{
+	auto it = allocations.find(offset);
+	assert(it != allocations.end());
+
+	return blockSizeOf(it->second.order);
+}
+
+std::vector<BuddyAllocator::Move> BuddyAllocator::beginDefragment(std::uint32_t max_moves)
+{
+	assert(pending_frees.empty());
+
+	std::vector<std::uint64_t> offsets;
+	offsets.reserve(allocations.size());
+
+	for (auto const& allocation : allocations)
+	{
+		offsets.push_back(allocation.first);
+	}
+
+	std::sort(offsets.begin(), offsets.end(), std::greater<std::uint64_t>());
+
+	std::vector<Move> moves;
+
+	for (std::uint64_t from : offsets)
+	{
+		if (moves.size() == max_moves)
+		{
+			break;
+		}
+
+		Block block = allocations[from];
+		std::uint64_t block_size = blockSizeOf(block.order);
+
+		// Take the lowest free block of the same order, if it is lower.
+		std::uint64_t to = allocate(block_size, block_size);
+
+		if (to == invalid_offset)
+		{
+			continue;
+		}
+
+		if (to > from)
+		{
+			free(to);
+			continue;
+		}
+
+		// Keep the requested size of the moved allocation.
+		requested_bytes += block.requested_size - block_size;
+		allocations[to].requested_size = block.requested_size;
+
+		moves.push_back({ from, to, block.requested_size });
+		pending_frees.push_back(from);
+	}
+
+	return moves;
+}
+
+void BuddyAllocator::endDefragment()
+{
+	for (std::uint64_t offset : pending_frees)
+	{
+		free(offset);
+	}
+
+	pending_frees.clear();
+}
+
+BuddyAllocator::Statistics BuddyAllocator::getStatistics() const
+{
+	Statistics statistics;
+
+	statistics.allocation_count = static_cast<std::uint32_t>(allocations.size());
+	statistics.requested_bytes = requested_bytes;
+	statistics.allocated_bytes = allocated_bytes;
+
+	for (std::uint32_t order = 0; order <= max_order; ++order)
+	{
+		std::uint64_t count = free_blocks[order].size();
+
+		statistics.free_block_count += static_cast<std::uint32_t>(count);
+		statistics.free_bytes += count * blockSizeOf(order);
+
+		if (count > 0)
+		{
+			statistics.largest_free_block = blockSizeOf(order);
+		}
+	}
+
+	if (statistics.free_bytes > 0)
+	{
+		statistics.external_fragmentation =
+			1.0f - static_cast<float>(statistics.largest_free_block) / static_cast<float>(statistics.free_bytes);
+	}
+
+	if (statistics.allocated_bytes > 0)
+	{
+		statistics.internal_fragmentation =
+			1.0f - static_cast<float>(statistics.requested_bytes) / static_cast<float>(statistics.allocated_bytes);
+	}
+
+	return statistics;
+}
+
+std::uint32_t BuddyAllocator::orderOf(std::uint64_t size) const
+{
+	std::uint32_t order = 0;
+
+	while (blockSizeOf(order) < size)
+	{
+		++order;
+	}
+
+	return order;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// Binary buddy allocator over the offsets [0, capacity) of a heap or
+// buffer. Blocks are powers of two from min_block_size up to capacity, and
+// every block is aligned to its size, so any alignment up to the block size
+// comes for free. Freed blocks merge with their free buddy. Lower offsets
+// are preferred, which keeps live blocks packed at the front and leaves
+// defragment little to move.
+//
+// Only offsets are tracked, so the policy runs without a device;
+// d3d12HeapSuballocator.hpp puts it over ID3D12Heaps or shared buffers.
+class BuddyAllocator
+{
+public:
+	static std::uint64_t const invalid_offset = UINT64_MAX;
+
+	struct Statistics
+	{
+		std::uint32_t allocation_count = 0;
+
+		// Sizes as requested, and as the blocks they were rounded up to.
+		std::uint64_t requested_bytes = 0;
+		std::uint64_t allocated_bytes = 0;
+
+		std::uint64_t free_bytes = 0;
+		std::uint32_t free_block_count = 0;
+		std::uint64_t largest_free_block = 0;
+
+		// Share of free space not in the largest free block: 0 when all of
+		// it is usable by one allocation, close to 1 when it is scattered.
+		float external_fragmentation = 0.0f;
+
+		// Share of allocated space lost to rounding up to block sizes.
+		float internal_fragmentation = 0.0f;
+	};
+
+	// A live block to copy from from_offset to to_offset. The new block is
+	// already reserved and the old one stays so until defragmentation is
+	// done, so the copies may all run before anything is freed.
+	struct Move
+	{
+		std::uint64_t from_offset;
+		std::uint64_t to_offset;
+		std::uint64_t size;
+	};
+
+	// capacity and min_block_size must be powers of two.
+	BuddyAllocator(std::uint64_t capacity, std::uint64_t min_block_size);
+
+	// Returns invalid_offset when no free block is large enough.
+	std::uint64_t allocate(std::uint64_t size, std::uint64_t alignment = 1);
+
+	// offset must have been returned by allocate.
+	void free(std::uint64_t offset);
+
+	// Size of the block at offset, which may exceed the size requested.
+	std::uint64_t blockSize(std::uint64_t offset) const;
+
+	// Plans up to max_moves moves of live blocks to lower free offsets,
+	// highest blocks first. Each moved allocation is reserved at its new
+	// offset and its old block is marked to be freed by endDefragment,
+	// after the caller copied the data and repointed its users.
+	std::vector<Move> beginDefragment(std::uint32_t max_moves);
+	void endDefragment();
+
+	Statistics getStatistics() const;
+
+	std::uint64_t capacity() const
+	{
+		return size;
+	}
+
+private:
+	struct Block
+	{
+		std::uint32_t order;
+		std::uint64_t requested_size;
+	};
+
+	std::uint64_t blockSizeOf(std::uint32_t order) const
+	{
+		return min_block_size << order;
+	}
+
+	std::uint32_t orderOf(std::uint64_t size) const;
+
+	std::uint64_t size;
+	std::uint64_t min_block_size;
+	std::uint32_t max_order;
+
+	// Free blocks per order, by offset.
+	std::vector<std::set<std::uint64_t>> free_blocks;
+
+	std::unordered_map<std::uint64_t, Block> allocations;
+	std::vector<std::uint64_t> pending_frees;
+
+	std::uint64_t requested_bytes = 0;
+	std::uint64_t allocated_bytes = 0;
+};
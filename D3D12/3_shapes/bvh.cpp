@@ -0,0 +1,613 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	std::uint32_t const invalid_index = ~0u;
+
+	float component(XMFLOAT3 const& v, std::uint32_t axis)
+	{
+		return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+	}
+
+	void grow(XMFLOAT3& bounds_min, XMFLOAT3& bounds_max, XMFLOAT3 const& p_min, XMFLOAT3 const& p_max)
+	{
+		bounds_min = XMFLOAT3(std::min(bounds_min.x, p_min.x), std::min(bounds_min.y, p_min.y), std::min(bounds_min.z, p_min.z));
+		bounds_max = XMFLOAT3(std::max(bounds_max.x, p_max.x), std::max(bounds_max.y, p_max.y), std::max(bounds_max.z, p_max.z));
+	}
+
+	float halfArea(XMFLOAT3 const& bounds_min, XMFLOAT3 const& bounds_max)
+	{
+		float dx = bounds_max.x - bounds_min.x;
+		float dy = bounds_max.y - bounds_min.y;
+		float dz = bounds_max.z - bounds_min.z;
+
+		return dx * dy + dy * dz + dz * dx;
+	}
+
+	bool overlaps(XMFLOAT3 const& a_min, XMFLOAT3 const& a_max, XMFLOAT3 const& b_min, XMFLOAT3 const& b_max)
+	{
+		return
+			a_min.x <= b_max.x && a_max.x >= b_min.x &&
+			a_min.y <= b_max.y && a_max.y >= b_min.y &&
+			a_min.z <= b_max.z && a_max.z >= b_min.z;
+	}
+
+	// Entry distance of the ray into the box, or FLT_MAX when it misses.
+	float rayBoxDistance(
+		XMFLOAT3 const& origin,
+		XMFLOAT3 const& inverse_direction,
+		XMFLOAT3 const& bounds_min,
+		XMFLOAT3 const& bounds_max)
+	{
+		float tx0 = (bounds_min.x - origin.x) * inverse_direction.x;
+		float tx1 = (bounds_max.x - origin.x) * inverse_direction.x;
+		float ty0 = (bounds_min.y - origin.y) * inverse_direction.y;
+		float ty1 = (bounds_max.y - origin.y) * inverse_direction.y;
+		float tz0 = (bounds_min.z - origin.z) * inverse_direction.z;
+		float tz1 = (bounds_max.z - origin.z) * inverse_direction.z;
+
+		float t_near = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+		float t_far = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::max(tz0, tz1));
+
+		return t_near <= t_far ? t_near : FLT_MAX;
+	}
+
+	enum class PlaneSide
+	{
+		Outside,
+		Inside,
+		Crossing
+	};
+
+	PlaneSide classify(XMFLOAT4 const& plane, XMFLOAT3 const& bounds_min, XMFLOAT3 const& bounds_max)
+	{
+		XMFLOAT3 center(
+			0.5f * (bounds_min.x + bounds_max.x),
+			0.5f * (bounds_min.y + bounds_max.y),
+			0.5f * (bounds_min.z + bounds_max.z));
+
+		XMFLOAT3 extents(
+			0.5f * (bounds_max.x - bounds_min.x),
+			0.5f * (bounds_max.y - bounds_min.y),
+			0.5f * (bounds_max.z - bounds_min.z));
+
+		float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+		float reach = fabsf(plane.x) * extents.x + fabsf(plane.y) * extents.y + fabsf(plane.z) * extents.z;
+
+		if (distance + reach < 0.0f)
+		{
+			return PlaneSide::Outside;
+		}
+
+		return distance - reach >= 0.0f ? PlaneSide::Inside : PlaneSide::Crossing;
+	}
+}
+
+void Bvh::build(std::vector<BoundingBox> const& bounds)
+{
+	std::uint32_t primitive_count = static_cast<std::uint32_t>(bounds.size());
+
+	nodes.clear();
+	parents.clear();
+
+	primitive_ids.resize(primitive_count);
+	primitive_min.resize(primitive_count);
+	primitive_max.resize(primitive_count);
+	primitive_slots.resize(primitive_count);
+	primitive_leaves.resize(primitive_count);
+
+	if (primitive_count == 0)
+	{
+		return;
+	}
+
+	// Inputs in primitive order; reordered into leaf order at the end.
+	std::vector<XMFLOAT3> input_min(primitive_count);
+	std::vector<XMFLOAT3> input_max(primitive_count);
+	std::vector<XMFLOAT3> centroids(primitive_count);
+
+	for (std::uint32_t i = 0; i < primitive_count; ++i)
+	{
+		XMFLOAT3 const& c = bounds[i].Center;
+		XMFLOAT3 const& e = bounds[i].Extents;
+
+		input_min[i] = XMFLOAT3(c.x - e.x, c.y - e.y, c.z - e.z);
+		input_max[i] = XMFLOAT3(c.x + e.x, c.y + e.y, c.z + e.z);
+		centroids[i] = c;
+		primitive_ids[i] = i;
+	}
+
+	nodes.reserve(2 * (primitive_count / max_leaf_size + 1));
+	parents.reserve(nodes.capacity());
+
+	// Depth first without recursion: a node is created when its task is
+	// popped, so the left child, popped right after its parent is split,
+	// always lands at parent + 1. Right children patch their index into the
+	// parent when they are created.
+	struct Task
+	{
+		std::uint32_t parent;
+		std::uint32_t first;
+		std::uint32_t count;
+		bool is_right;
+	};
+
+	std::vector<Task> tasks;
+	tasks.push_back({ invalid_index, 0, primitive_count, false });
+
+	while (!tasks.empty())
+	{
+		Task task = tasks.back();
+		tasks.pop_back();
+
+		std::uint32_t node = static_cast<std::uint32_t>(nodes.size());
+
+		nodes.emplace_back();
+		parents.push_back(task.parent);
+
+		if (task.is_right)
+		{
+			nodes[task.parent].right_or_first = node;
+		}
+
+		XMFLOAT3 bounds_min(FLT_MAX, FLT_MAX, FLT_MAX), bounds_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		XMFLOAT3 centroid_min = bounds_min, centroid_max = bounds_max;
+
+		for (std::uint32_t i = task.first; i < task.first + task.count; ++i)
+		{
+			std::uint32_t id = primitive_ids[i];
+
+			grow(bounds_min, bounds_max, input_min[id], input_max[id]);
+			grow(centroid_min, centroid_max, centroids[id], centroids[id]);
+		}
+
+		nodes[node].bounds_min = bounds_min;
+		nodes[node].bounds_max = bounds_max;
+
+		if (task.count <= max_leaf_size)
+		{
+			nodes[node].right_or_first = task.first;
+			nodes[node].primitive_count = task.count;
+
+			for (std::uint32_t i = task.first; i < task.first + task.count; ++i)
+			{
+				primitive_leaves[primitive_ids[i]] = node;
+			}
+
+			continue;
+		}
+
+		std::uint32_t left_count = split(
+			centroids,
+			input_min,
+			input_max,
+			centroid_min,
+			centroid_max,
+			task.first,
+			task.count);
+
+		tasks.push_back({ node, task.first + left_count, task.count - left_count, true });
+		tasks.push_back({ node, task.first, left_count, false });
+	}
+
+	for (std::uint32_t slot = 0; slot < primitive_count; ++slot)
+	{
+		std::uint32_t id = primitive_ids[slot];
+
+		primitive_min[slot] = input_min[id];
+		primitive_max[slot] = input_max[id];
+		primitive_slots[id] = slot;
+	}
+}
+
+std::uint32_t Bvh::split(
+	std::vector<XMFLOAT3> const& centroids,
+	std::vector<XMFLOAT3> const& input_min,
+	std::vector<XMFLOAT3> const& input_max,
+	XMFLOAT3 const& centroid_min,
+	XMFLOAT3 const& centroid_max,
+	std::uint32_t first,
+	std::uint32_t count)
+{
+	auto ids_begin = primitive_ids.begin() + first;
+	auto ids_end = ids_begin + count;
+
+	XMFLOAT3 extent(
+		centroid_max.x - centroid_min.x,
+		centroid_max.y - centroid_min.y,
+		centroid_max.z - centroid_min.z);
+
+	std::uint32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+
+	float axis_min = component(centroid_min, axis);
+	float axis_extent = component(extent, axis);
+
+	auto medianSplit = [&]
+	{
+		std::nth_element(ids_begin, ids_begin + count / 2, ids_end, [&](std::uint32_t a, std::uint32_t b)
+		{
+			return component(centroids[a], axis) < component(centroids[b], axis);
+		});
+
+		return count / 2;
+	};
+
+	if (axis_extent <= 0.0f)
+	{
+		return medianSplit();
+	}
+
+	struct Bin
+	{
+		XMFLOAT3 bounds_min = { FLT_MAX, FLT_MAX, FLT_MAX };
+		XMFLOAT3 bounds_max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		std::uint32_t count = 0;
+	};
+
+	Bin bins[bin_count];
+
+	float scale = bin_count * (1.0f - 1e-5f) / axis_extent;
+
+	auto binOf = [&](std::uint32_t id)
+	{
+		float offset = component(centroids[id], axis) - axis_min;
+		return std::min(static_cast<std::uint32_t>(offset * scale), bin_count - 1);
+	};
+
+	for (auto it = ids_begin; it != ids_end; ++it)
+	{
+		std::uint32_t id = *it;
+		Bin& bin = bins[binOf(id)];
+
+		grow(bin.bounds_min, bin.bounds_max, input_min[id], input_max[id]);
+		++bin.count;
+	}
+
+	// Right to left sweep of the areas and counts of every right side.
+	float right_area[bin_count];
+	std::uint32_t right_count[bin_count];
+
+	Bin accumulated;
+
+	for (std::uint32_t i = bin_count - 1; i > 0; --i)
+	{
+		grow(accumulated.bounds_min, accumulated.bounds_max, bins[i].bounds_min, bins[i].bounds_max);
+		accumulated.count += bins[i].count;
+
+		right_area[i] = accumulated.count ? halfArea(accumulated.bounds_min, accumulated.bounds_max) : 0.0f;
+		right_count[i] = accumulated.count;
+	}
+
+	accumulated = Bin();
+
+	float best_cost = FLT_MAX;
+	std::uint32_t best_split = 0;
+
+	for (std::uint32_t i = 0; i + 1 < bin_count; ++i)
+	{
+		grow(accumulated.bounds_min, accumulated.bounds_max, bins[i].bounds_min, bins[i].bounds_max);
+		accumulated.count += bins[i].count;
+
+		if (accumulated.count == 0 || right_count[i + 1] == 0)
+		{
+			continue;
+		}
+
+		float cost =
+			halfArea(accumulated.bounds_min, accumulated.bounds_max) * accumulated.count +
+			right_area[i + 1] * right_count[i + 1];
+
+		if (cost < best_cost)
+		{
+			best_cost = cost;
+			best_split = i;
+		}
+	}
+
+	if (best_cost == FLT_MAX)
+	{
+		return medianSplit();
+	}
+
+	auto middle = std::partition(ids_begin, ids_end, [&](std::uint32_t id) { return binOf(id) <= best_split; });
+
+	return static_cast<std::uint32_t>(middle - ids_begin);
+}
+
+void Bvh::refit(std::vector<BoundingBox> const& bounds)
+{
+	assert(bounds.size() == primitive_ids.size());
+
+	for (std::uint32_t slot = 0; slot < primitive_ids.size(); ++slot)
+	{
+		BoundingBox const& box = bounds[primitive_ids[slot]];
+
+		primitive_min[slot] = XMFLOAT3(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+		primitive_max[slot] = XMFLOAT3(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+	}
+
+	// Children always come after their parent.
+	for (std::size_t node = nodes.size(); node-- > 0;)
+	{
+		refitNode(static_cast<std::uint32_t>(node));
+	}
+}
+
+void Bvh::refit(std::uint32_t primitive, BoundingBox const& bounds)
+{
+	assert(primitive < primitive_slots.size());
+
+	std::uint32_t slot = primitive_slots[primitive];
+
+	primitive_min[slot] = XMFLOAT3(bounds.Center.x - bounds.Extents.x, bounds.Center.y - bounds.Extents.y, bounds.Center.z - bounds.Extents.z);
+	primitive_max[slot] = XMFLOAT3(bounds.Center.x + bounds.Extents.x, bounds.Center.y + bounds.Extents.y, bounds.Center.z + bounds.Extents.z);
+
+	for (std::uint32_t node = primitive_leaves[primitive]; node != invalid_index; node = parents[node])
+	{
+		Node before = nodes[node];
+
+		refitNode(node);
+
+		// Ancestors only depend on this node's bounds.
+		if (before.bounds_min.x == nodes[node].bounds_min.x &&
+			before.bounds_min.y == nodes[node].bounds_min.y &&
+			before.bounds_min.z == nodes[node].bounds_min.z &&
+			before.bounds_max.x == nodes[node].bounds_max.x &&
+			before.bounds_max.y == nodes[node].bounds_max.y &&
+			before.bounds_max.z == nodes[node].bounds_max.z)
+		{
+			break;
+		}
+	}
+}
+
+void Bvh::refitNode(std::uint32_t node)
+{
+	Node& n = nodes[node];
+
+	XMFLOAT3 bounds_min(FLT_MAX, FLT_MAX, FLT_MAX), bounds_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	if (n.primitive_count > 0)
+	{
+		for (std::uint32_t slot = n.right_or_first; slot < n.right_or_first + n.primitive_count; ++slot)
+		{
+			grow(bounds_min, bounds_max, primitive_min[slot], primitive_max[slot]);
+		}
+	}
+	else
+	{
+		grow(bounds_min, bounds_max, nodes[node + 1].bounds_min, nodes[node + 1].bounds_max);
+		grow(bounds_min, bounds_max, nodes[n.right_or_first].bounds_min, nodes[n.right_or_first].bounds_max);
+	}
+
+	n.bounds_min = bounds_min;
+	n.bounds_max = bounds_max;
+}
+
+void Bvh::queryFrustum(Frustum const& frustum, std::vector<std::uint32_t>& primitives) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	// Each entry carries the planes its box still crosses; subtrees fully
+	// inside every plane are appended without further tests.
+	struct Entry
+	{
+		std::uint32_t node;
+		std::uint32_t plane_mask;
+	};
+
+	std::uint32_t const all_planes = (1u << Frustum::PlaneCount) - 1;
+
+	std::vector<Entry> stack;
+	stack.push_back({ 0, all_planes });
+
+	auto cullMask = [&](XMFLOAT3 const& bounds_min, XMFLOAT3 const& bounds_max, std::uint32_t mask)
+	{
+		for (int i = 0; i < Frustum::PlaneCount; ++i)
+		{
+			if (!(mask & (1u << i)))
+			{
+				continue;
+			}
+
+			PlaneSide side = classify(frustum.planes[i], bounds_min, bounds_max);
+
+			if (side == PlaneSide::Outside)
+			{
+				return invalid_index;
+			}
+
+			if (side == PlaneSide::Inside)
+			{
+				mask &= ~(1u << i);
+			}
+		}
+
+		return mask;
+	};
+
+	while (!stack.empty())
+	{
+		Entry entry = stack.back();
+		stack.pop_back();
+
+		Node const& node = nodes[entry.node];
+		std::uint32_t mask = cullMask(node.bounds_min, node.bounds_max, entry.plane_mask);
+
+		if (mask == invalid_index)
+		{
+			continue;
+		}
+
+		if (node.primitive_count == 0)
+		{
+			stack.push_back({ node.right_or_first, mask });
+			stack.push_back({ entry.node + 1, mask });
+			continue;
+		}
+
+		for (std::uint32_t slot = node.right_or_first; slot < node.right_or_first + node.primitive_count; ++slot)
+		{
+			if (mask == 0 || cullMask(primitive_min[slot], primitive_max[slot], mask) != invalid_index)
+			{
+				primitives.push_back(primitive_ids[slot]);
+			}
+		}
+	}
+}
+
+void Bvh::queryBox(BoundingBox const& box, std::vector<std::uint32_t>& primitives) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	XMFLOAT3 box_min(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+	XMFLOAT3 box_max(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+
+	std::vector<std::uint32_t> stack;
+	stack.push_back(0);
+
+	while (!stack.empty())
+	{
+		Node const& node = nodes[stack.back()];
+		std::uint32_t index = stack.back();
+		stack.pop_back();
+
+		if (!overlaps(node.bounds_min, node.bounds_max, box_min, box_max))
+		{
+			continue;
+		}
+
+		if (node.primitive_count == 0)
+		{
+			stack.push_back(node.right_or_first);
+			stack.push_back(index + 1);
+			continue;
+		}
+
+		for (std::uint32_t slot = node.right_or_first; slot < node.right_or_first + node.primitive_count; ++slot)
+		{
+			if (overlaps(primitive_min[slot], primitive_max[slot], box_min, box_max))
+			{
+				primitives.push_back(primitive_ids[slot]);
+			}
+		}
+	}
+}
+
+bool Bvh::raycast(
+	XMFLOAT3 const& origin,
+	XMFLOAT3 const& direction,
+	std::uint32_t& hit_primitive,
+	float& hit_distance,
+	RayHitFunction const& hit_function) const
+{
+	if (nodes.empty())
+	{
+		return false;
+	}
+
+	XMFLOAT3 inverse_direction(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+	float best = FLT_MAX;
+	std::uint32_t best_primitive = invalid_index;
+
+	struct Entry
+	{
+		std::uint32_t node;
+		float distance;
+	};
+
+	std::vector<Entry> stack;
+
+	float root_distance = rayBoxDistance(origin, inverse_direction, nodes[0].bounds_min, nodes[0].bounds_max);
+
+	if (root_distance != FLT_MAX)
+	{
+		stack.push_back({ 0, root_distance });
+	}
+
+	while (!stack.empty())
+	{
+		Entry entry = stack.back();
+		stack.pop_back();
+
+		if (entry.distance >= best)
+		{
+			continue;
+		}
+
+		Node const& node = nodes[entry.node];
+
+		if (node.primitive_count > 0)
+		{
+			for (std::uint32_t slot = node.right_or_first; slot < node.right_or_first + node.primitive_count; ++slot)
+			{
+				float distance = rayBoxDistance(origin, inverse_direction, primitive_min[slot], primitive_max[slot]);
+
+				if (distance >= best)
+				{
+					continue;
+				}
+
+				if (hit_function && !hit_function(primitive_ids[slot], distance))
+				{
+					continue;
+				}
+
+				if (distance < best)
+				{
+					best = distance;
+					best_primitive = primitive_ids[slot];
+				}
+			}
+
+			continue;
+		}
+
+		std::uint32_t left = entry.node + 1;
+		std::uint32_t right = node.right_or_first;
+
+		float left_distance = rayBoxDistance(origin, inverse_direction, nodes[left].bounds_min, nodes[left].bounds_max);
+		float right_distance = rayBoxDistance(origin, inverse_direction, nodes[right].bounds_min, nodes[right].bounds_max);
+
+		// Push the farther child first so the nearer one is visited next.
+		if (left_distance > right_distance)
+		{
+			std::swap(left, right);
+			std::swap(left_distance, right_distance);
+		}
+
+		if (right_distance < best)
+		{
+			stack.push_back({ right, right_distance });
+		}
+
+		if (left_distance < best)
+		{
+			stack.push_back({ left, left_distance });
+		}
+	}
+
+	if (best_primitive == invalid_index)
+	{
+		return false;
+	}
+
+	hit_primitive = best_primitive;
+	hit_distance = best;
+
+	return true;
+}
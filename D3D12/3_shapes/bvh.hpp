@@ -0,0 +1,92 @@
+#pragma once
+
+#include "frustum.hpp"
+
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Bounding volume hierarchy over world space AABBs, built with binned SAH
+// and stored depth first: the left child of an interior node directly
+// follows it, so only the right child needs an index.
+class Bvh
+{
+public:
+	static std::uint32_t const max_leaf_size = 8;
+	static std::uint32_t const bin_count = 16;
+
+	// 32 bytes, two per cache line.
+	struct Node
+	{
+		DirectX::XMFLOAT3 bounds_min;
+		std::uint32_t right_or_first = 0;
+
+		DirectX::XMFLOAT3 bounds_max;
+
+		// Number of primitives of a leaf; 0 for interior nodes.
+		std::uint32_t primitive_count = 0;
+	};
+
+	// Exact test for a primitive whose AABB the ray hits. Returns whether
+	// the primitive is hit and, if so, sets distance along the ray.
+	using RayHitFunction = std::function<bool(std::uint32_t primitive, float& distance)>;
+
+	void build(std::vector<DirectX::BoundingBox> const& bounds);
+
+	// Moves the nodes to new primitive bounds without changing the tree.
+	// Cheap, but the tree degrades as objects drift from where it was built.
+	void refit(std::vector<DirectX::BoundingBox> const& bounds);
+
+	// Refits only the path from primitive's leaf to the root.
+	void refit(std::uint32_t primitive, DirectX::BoundingBox const& bounds);
+
+	// Appends the primitives whose AABB is not fully outside frustum.
+	void queryFrustum(Frustum const& frustum, std::vector<std::uint32_t>& primitives) const;
+
+	// Appends the primitives whose AABB overlaps box.
+	void queryBox(DirectX::BoundingBox const& box, std::vector<std::uint32_t>& primitives) const;
+
+	// Nearest primitive along the ray, visiting nodes front to back. Without
+	// hit_function, the distance to the primitive's AABB is used.
+	bool raycast(
+		DirectX::XMFLOAT3 const& origin,
+		DirectX::XMFLOAT3 const& direction,
+		std::uint32_t& hit_primitive,
+		float& hit_distance,
+		RayHitFunction const& hit_function = nullptr) const;
+
+	std::vector<Node> const& getNodes() const
+	{
+		return nodes;
+	}
+
+private:
+	// Partitions primitive_ids[first, first + count) by binned SAH and
+	// returns the size of the left part.
+	std::uint32_t split(
+		std::vector<DirectX::XMFLOAT3> const& centroids,
+		std::vector<DirectX::XMFLOAT3> const& input_min,
+		std::vector<DirectX::XMFLOAT3> const& input_max,
+		DirectX::XMFLOAT3 const& centroid_min,
+		DirectX::XMFLOAT3 const& centroid_max,
+		std::uint32_t first,
+		std::uint32_t count);
+
+	void refitNode(std::uint32_t node);
+
+	std::vector<Node> nodes;
+	std::vector<std::uint32_t> parents;
+
+	// Leaves reference runs of primitive_ids; the primitive bounds are kept
+	// in the same order so leaf tests read them sequentially.
+	std::vector<std::uint32_t> primitive_ids;
+	std::vector<DirectX::XMFLOAT3> primitive_min;
+	std::vector<DirectX::XMFLOAT3> primitive_max;
+
+	// Position of each primitive in primitive_ids, and its leaf.
+	std::vector<std::uint32_t> primitive_slots;
+	std::vector<std::uint32_t> primitive_leaves;
+};
@@ -0,0 +1,41 @@
+#include "constantAllocator.hpp"
+
+#include <cassert>
+
+ConstantAllocator::ConstantAllocator(void* data, std::uint64_t gpu_address, std::uint64_t capacity)
+	:
+	data{ static_cast<unsigned char*>(data) },
+	gpu_address{ gpu_address },
+	ring{ capacity }
+{
+	assert(gpu_address % alignment == 0);
+}
+
+void ConstantAllocator::beginFrame(std::uint64_t completed_value)
+{
+	ring.release(completed_value);
+}
+
+void ConstantAllocator::endFrame(std::uint64_t fence_value)
+{
+	ring.close(fence_value);
+}
+
+ConstantAllocator::Allocation ConstantAllocator::allocate(std::uint64_t size_in_bytes)
+{
+	std::uint64_t size = (size_in_bytes + alignment - 1) & ~(alignment - 1);
+	std::uint64_t offset = ring.allocate(size, alignment);
+
+	Allocation allocation;
+
+	if (offset == StagingRing::invalid_offset)
+	{
+		return allocation;
+	}
+
+	allocation.data = data + offset;
+	allocation.gpu_address = gpu_address + offset;
+	allocation.size = size;
+
+	return allocation;
+}
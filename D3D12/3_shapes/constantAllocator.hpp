@@ -0,0 +1,78 @@
+#pragma once
+
+#include "stagingRing.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+// Per-frame constant data suballocated from one persistently mapped ring.
+// Every allocation is 256-byte aligned, as root CBVs and constant buffer
+// views require, so constants of any type share the ring and the number of
+// objects may change from frame to frame. A frame's allocations are freed
+// together, in O(1), once the fence value passed to endFrame completes.
+//
+// The ring is given as a CPU pointer and the GPU virtual address it maps
+// to; d3d12ConstantAllocator.hpp creates it in an upload heap, tests can
+// back it with host memory and any base address.
+class ConstantAllocator
+{
+public:
+	static std::uint64_t const alignment = 256;
+
+	struct Allocation
+	{
+		// Null when the ring is full.
+		void* data = nullptr;
+		std::uint64_t gpu_address = 0;
+		std::uint64_t size = 0;
+	};
+
+	ConstantAllocator(ConstantAllocator const&) = delete;
+	ConstantAllocator& operator=(ConstantAllocator const&) = delete;
+
+	ConstantAllocator(void* data, std::uint64_t gpu_address, std::uint64_t capacity);
+
+	// Frees the frames whose fence value is at most completed_value.
+	void beginFrame(std::uint64_t completed_value);
+
+	// Hands everything allocated since the last endFrame to fence_value.
+	void endFrame(std::uint64_t fence_value);
+
+	// Size is rounded up to alignment.
+	Allocation allocate(std::uint64_t size_in_bytes);
+
+	template <typename T>
+	Allocation push(T const& constants)
+	{
+		Allocation allocation = allocate(sizeof(T));
+
+		if (allocation.data != nullptr)
+		{
+			std::memcpy(allocation.data, &constants, sizeof(T));
+		}
+
+		return allocation;
+	}
+
+	std::uint64_t usedBytes() const
+	{
+		return ring.usedBytes();
+	}
+
+	std::uint64_t capacity() const
+	{
+		return ring.capacity();
+	}
+
+	// Bytes allocated in the current frame.
+	std::uint64_t frameBytes() const
+	{
+		return ring.openBytes();
+	}
+
+private:
+	unsigned char* data;
+	std::uint64_t gpu_address;
+
+	StagingRing ring;
+};
@@ -405,6 +405,9 @@ bool D3D12App::initDirect3D()
 	THROW_IF_FAILED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_12_1, IID_PPV_ARGS(&device)));
 	THROW_IF_FAILED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
 
+	fence_timeline = std::make_unique<D3D12Fence>(fence);
+	fence_waiter = std::make_unique<FenceWaiter>(wait_event_backend);
+
 	rtv_descriptor_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 	dsv_descriptor_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
 	cbv_srv_uav_descriptor_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
@@ -414,6 +417,7 @@ bool D3D12App::initDirect3D()
 #endif
 
 	createCommandStructure();
+	createUploadQueue();
 	createSwapChain();
 	createRTVAndDSVDescriptorHeaps();
 
@@ -444,6 +448,15 @@ void D3D12App::createCommandStructure()
 	command_list->Close();
 }
 
+void D3D12App::createUploadQueue()
+{
+	direct_queue = std::make_unique<D3D12Queue>(device.Get(), command_queue);
+	copy_queue = std::make_unique<D3D12Queue>(device.Get(), D3D12_COMMAND_LIST_TYPE_COPY);
+
+	queue_scheduler = std::make_unique<QueueScheduler>(direct_queue.get(), nullptr, copy_queue.get());
+	upload_manager = std::make_unique<UploadManager>(device, *queue_scheduler, *fence_waiter);
+}
+
 void D3D12App::createSwapChain()
 {
 	swap_chain.Reset();
@@ -481,15 +494,12 @@ void D3D12App::flushCommandQueue()
 
 	THROW_IF_FAILED(command_queue->Signal(fence.Get(), fence_value));
 
-	if (fence->GetCompletedValue() < fence_value)
-	{
-		HANDLE event_handle = CreateEventEx(nullptr, FALSE, FALSE, EVENT_ALL_ACCESS);
-
-		THROW_IF_FAILED(fence->SetEventOnCompletion(fence_value, event_handle));
+	waitForFence(fence_value);
+}
 
-		WaitForSingleObject(event_handle, INFINITE);
-		CloseHandle(event_handle);
-	}
+void D3D12App::waitForFence(UINT64 value)
+{
+	fence_waiter->wait(*fence_timeline, value);
 }
 
 Microsoft::WRL::ComPtr<ID3D12Resource> D3D12App::currentSwapChainBuffer() const
@@ -6,7 +6,12 @@
 #endif
 
 #include "config.hpp"
+#include "d3d12Fence.hpp"
+#include "d3d12Queue.hpp"
 #include "gameTimer.hpp"
+#include "uploadManager.hpp"
+
+#include <memory>
 
 #pragma comment(lib, "d3dcompiler.lib")
 #pragma comment(lib, "D3D12.lib")
@@ -50,10 +55,14 @@ protected:
 	bool initWindow();
 	bool initDirect3D();
 	void createCommandStructure();
+	void createUploadQueue();
 	void createSwapChain();
 
 	void flushCommandQueue();
 
+	// Blocks until fence reaches value.
+	void waitForFence(UINT64 value);
+
 	Microsoft::WRL::ComPtr<ID3D12Resource> currentSwapChainBuffer() const;
 	D3D12_CPU_DESCRIPTOR_HANDLE currentSwapChainBufferView() const;
 	D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView() const;
@@ -85,10 +94,21 @@ protected:
 	Microsoft::WRL::ComPtr<ID3D12Fence> fence;
 	UINT64 fence_value = 0u;
 
+	std::unique_ptr<D3D12Fence> fence_timeline;
+	Win32EventBackend wait_event_backend;
+	std::unique_ptr<FenceWaiter> fence_waiter;
+
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue> command_queue;
 	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> command_allocator;
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList6> command_list;
 
+	// Initial data is copied on its own queue; the direct queue waits for
+	// an upload ticket through the scheduler before using the resources.
+	std::unique_ptr<D3D12Queue> direct_queue;
+	std::unique_ptr<D3D12Queue> copy_queue;
+	std::unique_ptr<QueueScheduler> queue_scheduler;
+	std::unique_ptr<UploadManager> upload_manager;
+
 	static UINT const n_swap_chain_buffers = 2;
 	UINT current_swap_chain_buffer = 0u;
 	Microsoft::WRL::ComPtr<ID3D12Resource> swap_chain_buffers[n_swap_chain_buffers];
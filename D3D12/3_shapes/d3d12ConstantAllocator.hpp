@@ -0,0 +1,58 @@
+#pragma once
+
+#include "config.hpp"
+#include "constantAllocator.hpp"
+
+#include <memory>
+
+// ConstantAllocator over a persistently mapped upload heap buffer.
+class D3D12ConstantAllocator
+{
+public:
+	D3D12ConstantAllocator(D3D12ConstantAllocator const&) = delete;
+	D3D12ConstantAllocator& operator=(D3D12ConstantAllocator const&) = delete;
+
+	D3D12ConstantAllocator(ID3D12Device* device, UINT64 capacity)
+	{
+		auto heap_properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+		auto buffer = CD3DX12_RESOURCE_DESC::Buffer(capacity);
+
+		THROW_IF_FAILED(device->CreateCommittedResource(
+			&heap_properties,
+			D3D12_HEAP_FLAG_NONE,
+			&buffer,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&upload_buffer)));
+
+		void* mapped_data = nullptr;
+		THROW_IF_FAILED(upload_buffer->Map(0, nullptr, &mapped_data));
+
+		allocator = std::make_unique<ConstantAllocator>(
+			mapped_data,
+			upload_buffer->GetGPUVirtualAddress(),
+			capacity);
+	}
+
+	~D3D12ConstantAllocator()
+	{
+		if (upload_buffer)
+		{
+			upload_buffer->Unmap(0, nullptr);
+		}
+	}
+
+	ConstantAllocator& get()
+	{
+		return *allocator;
+	}
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> resource() const
+	{
+		return upload_buffer;
+	}
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Resource> upload_buffer;
+	std::unique_ptr<ConstantAllocator> allocator;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "config.hpp"
+#include "fenceWaiter.hpp"
+
+class D3D12Fence : public FenceTimeline
+{
+public:
+	explicit D3D12Fence(Microsoft::WRL::ComPtr<ID3D12Fence> fence)
+		:
+		fence{ fence }
+	{
+
+	}
+
+	ID3D12Fence* get() const
+	{
+		return fence.Get();
+	}
+
+	virtual void setEventOnCompletion(std::uint64_t value, void* event) override
+	{
+		THROW_IF_FAILED(fence->SetEventOnCompletion(value, event));
+	}
+
+protected:
+	virtual std::uint64_t queryCompletedValue() override
+	{
+		return fence->GetCompletedValue();
+	}
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Fence> fence;
+};
+
+class Win32EventBackend : public WaitEventBackend
+{
+public:
+	virtual void* createEvent() override
+	{
+		HANDLE event = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+
+		if (event == nullptr)
+		{
+			throw Exception(HRESULT_FROM_WIN32(GetLastError()), "CreateEventEx", __FILE__, __LINE__);
+		}
+
+		return event;
+	}
+
+	virtual void destroyEvent(void* event) override
+	{
+		CloseHandle(event);
+	}
+
+	virtual std::int32_t wait(void* const* events, std::uint32_t count, bool wait_all, std::uint32_t timeout_ms) override
+	{
+		DWORD result = WaitForMultipleObjects(count, events, wait_all ? TRUE : FALSE, timeout_ms);
+
+		if (result == WAIT_TIMEOUT)
+		{
+			return timed_out;
+		}
+
+		if (result >= WAIT_OBJECT_0 + count)
+		{
+			throw Exception(HRESULT_FROM_WIN32(GetLastError()), "WaitForMultipleObjects", __FILE__, __LINE__);
+		}
+
+		return static_cast<std::int32_t>(result - WAIT_OBJECT_0);
+	}
+};
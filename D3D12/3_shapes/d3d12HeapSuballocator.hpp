@@ -0,0 +1,231 @@
+#pragma once
+
+#include "buddyAllocator.hpp"
+#include "config.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// Default heap memory for vertex and index buffers, carved out of large
+// pages by a BuddyAllocator per page instead of one committed resource per
+// buffer. Pages are either ID3D12Heaps that blocks become placed buffers
+// in, or one committed buffer each that blocks are offset-based views of
+// (VBVs and IBVs at gpuAddress). A request larger than a page gets a page
+// of its own.
+//
+// Defragmentation is per page: beginDefragment plans moves, the caller
+// copies the blocks (CopyBufferRegion within the shared buffer, or between
+// placed buffers created at the new blocks) and repoints their users, and
+// endDefragment frees the old blocks once those copies completed.
+class D3D12HeapSuballocator
+{
+public:
+	enum class Mode
+	{
+		PlacedResources,
+		SharedBuffers
+	};
+
+	// Pages are buddy allocators, so page_size must be a power of two.
+	static UINT64 const default_page_size = 64ull << 20;
+
+	struct Block
+	{
+		UINT page = 0;
+		UINT64 offset = BuddyAllocator::invalid_offset;
+		UINT64 size = 0;
+	};
+
+	D3D12HeapSuballocator(D3D12HeapSuballocator const&) = delete;
+	D3D12HeapSuballocator& operator=(D3D12HeapSuballocator const&) = delete;
+
+	D3D12HeapSuballocator(
+		Microsoft::WRL::ComPtr<ID3D12Device> device,
+		Mode mode,
+		UINT64 page_size = default_page_size)
+		:
+		device{ device },
+		mode{ mode },
+		page_size{ page_size }
+	{
+		// Placed resources must start at 64 KB boundaries; views only need
+		// the 256 bytes constant buffers do.
+		min_block_size = mode == Mode::PlacedResources ?
+			D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT :
+			D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+
+		assert((page_size & (page_size - 1)) == 0 && page_size >= min_block_size);
+	}
+
+	Block allocate(UINT64 size_in_bytes)
+	{
+		Block block;
+		block.size = size_in_bytes;
+
+		for (UINT i = 0; i < pages.size(); ++i)
+		{
+			block.offset = pages[i].allocator->allocate(size_in_bytes);
+
+			if (block.offset != BuddyAllocator::invalid_offset)
+			{
+				block.page = i;
+				return block;
+			}
+		}
+
+		UINT64 new_page_size = page_size;
+
+		while (new_page_size < size_in_bytes)
+		{
+			new_page_size *= 2;
+		}
+
+		addPage(new_page_size);
+
+		block.page = static_cast<UINT>(pages.size() - 1);
+		block.offset = pages.back().allocator->allocate(size_in_bytes);
+
+		return block;
+	}
+
+	// Resources placed in the block must have been released.
+	void free(Block const& block)
+	{
+		pages[block.page].allocator->free(block.offset);
+	}
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> createPlacedBuffer(Block const& block, D3D12_RESOURCE_STATES initial_state)
+	{
+		assert(mode == Mode::PlacedResources);
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+		auto desc = CD3DX12_RESOURCE_DESC::Buffer(block.size);
+
+		THROW_IF_FAILED(device->CreatePlacedResource(
+			pages[block.page].heap.Get(),
+			block.offset,
+			&desc,
+			initial_state,
+			nullptr,
+			IID_PPV_ARGS(&buffer)));
+
+		return buffer;
+	}
+
+	// Shared buffer of the block's page; the block starts at block.offset.
+	ID3D12Resource* buffer(Block const& block) const
+	{
+		assert(mode == Mode::SharedBuffers);
+
+		return pages[block.page].buffer.Get();
+	}
+
+	D3D12_GPU_VIRTUAL_ADDRESS gpuAddress(Block const& block) const
+	{
+		return buffer(block)->GetGPUVirtualAddress() + block.offset;
+	}
+
+	std::vector<BuddyAllocator::Move> beginDefragment(UINT page, UINT max_moves)
+	{
+		return pages[page].allocator->beginDefragment(max_moves);
+	}
+
+	void endDefragment(UINT page)
+	{
+		pages[page].allocator->endDefragment();
+	}
+
+	UINT pageCount() const
+	{
+		return static_cast<UINT>(pages.size());
+	}
+
+	BuddyAllocator::Statistics getPageStatistics(UINT page) const
+	{
+		return pages[page].allocator->getStatistics();
+	}
+
+	// Sums over all pages; the largest free block is that of any page.
+	BuddyAllocator::Statistics getStatistics() const
+	{
+		BuddyAllocator::Statistics total;
+
+		for (auto const& page : pages)
+		{
+			BuddyAllocator::Statistics statistics = page.allocator->getStatistics();
+
+			total.allocation_count += statistics.allocation_count;
+			total.requested_bytes += statistics.requested_bytes;
+			total.allocated_bytes += statistics.allocated_bytes;
+			total.free_bytes += statistics.free_bytes;
+			total.free_block_count += statistics.free_block_count;
+			total.largest_free_block = std::max(total.largest_free_block, statistics.largest_free_block);
+		}
+
+		if (total.free_bytes > 0)
+		{
+			total.external_fragmentation =
+				1.0f - static_cast<float>(total.largest_free_block) / static_cast<float>(total.free_bytes);
+		}
+
+		if (total.allocated_bytes > 0)
+		{
+			total.internal_fragmentation =
+				1.0f - static_cast<float>(total.requested_bytes) / static_cast<float>(total.allocated_bytes);
+		}
+
+		return total;
+	}
+
+private:
+	struct Page
+	{
+		Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+		Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+		std::unique_ptr<BuddyAllocator> allocator;
+	};
+
+	void addPage(UINT64 size_in_bytes)
+	{
+		Page page;
+
+		if (mode == Mode::PlacedResources)
+		{
+			CD3DX12_HEAP_DESC heap_desc(
+				size_in_bytes,
+				D3D12_HEAP_TYPE_DEFAULT,
+				D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+				D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS);
+
+			THROW_IF_FAILED(device->CreateHeap(&heap_desc, IID_PPV_ARGS(&page.heap)));
+		}
+		else
+		{
+			auto heap_properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+			auto desc = CD3DX12_RESOURCE_DESC::Buffer(size_in_bytes);
+
+			// Buffers are promoted from COMMON on use and decay back to it,
+			// so blocks of one buffer can be copied to and read
+			// independently.
+			THROW_IF_FAILED(device->CreateCommittedResource(
+				&heap_properties,
+				D3D12_HEAP_FLAG_NONE,
+				&desc,
+				D3D12_RESOURCE_STATE_COMMON,
+				nullptr,
+				IID_PPV_ARGS(&page.buffer)));
+		}
+
+		page.allocator = std::make_unique<BuddyAllocator>(size_in_bytes, min_block_size);
+
+		pages.push_back(std::move(page));
+	}
+
+	Microsoft::WRL::ComPtr<ID3D12Device> device;
+	Mode mode;
+	UINT64 page_size;
+	UINT64 min_block_size;
+
+	std::vector<Page> pages;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "config.hpp"
+#include "d3d12Fence.hpp"
+#include "queueScheduler.hpp"
+
+#include <memory>
+
+// Command queue with its own fence, for QueueScheduler.
+class D3D12Queue : public QueueBackend
+{
+public:
+	D3D12Queue(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type)
+	{
+		D3D12_COMMAND_QUEUE_DESC queue_desc = {};
+		queue_desc.Type = type;
+		queue_desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+
+		THROW_IF_FAILED(device->CreateCommandQueue(
+			&queue_desc,
+			IID_PPV_ARGS(&queue)));
+
+		createFence(device);
+	}
+
+	// Schedules an existing queue. The fence is still a new one, so values
+	// signaled by others on their own fences do not interfere.
+	D3D12Queue(ID3D12Device* device, Microsoft::WRL::ComPtr<ID3D12CommandQueue> queue)
+		:
+		queue{ queue }
+	{
+		createFence(device);
+	}
+
+	ID3D12CommandQueue* get() const
+	{
+		return queue.Get();
+	}
+
+	virtual void executeCommandLists(void* const* command_lists, std::uint32_t count) override
+	{
+		queue->ExecuteCommandLists(count, reinterpret_cast<ID3D12CommandList* const*>(command_lists));
+	}
+
+	virtual void signal(std::uint64_t value) override
+	{
+		THROW_IF_FAILED(queue->Signal(fence_timeline->get(), value));
+	}
+
+	virtual void wait(QueueBackend& other, std::uint64_t value) override
+	{
+		THROW_IF_FAILED(queue->Wait(static_cast<D3D12Queue&>(other).fence_timeline->get(), value));
+	}
+
+	virtual FenceTimeline& fence() override
+	{
+		return *fence_timeline;
+	}
+
+private:
+	void createFence(ID3D12Device* device)
+	{
+		Microsoft::WRL::ComPtr<ID3D12Fence> queue_fence;
+		THROW_IF_FAILED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&queue_fence)));
+
+		fence_timeline = std::make_unique<D3D12Fence>(queue_fence);
+	}
+
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> queue;
+	std::unique_ptr<D3D12Fence> fence_timeline;
+};
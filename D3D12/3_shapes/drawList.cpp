@@ -0,0 +1,243 @@
+#include "drawList.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	std::uint32_t const material_shift = 0;
+	std::uint32_t const depth_shift = material_shift + DrawList::material_bits;
+	std::uint32_t const mesh_shift = depth_shift + DrawList::depth_bits;
+	std::uint32_t const pso_shift = mesh_shift + DrawList::mesh_bits;
+	std::uint32_t const root_signature_shift = pso_shift + DrawList::pso_bits;
+
+	static_assert(root_signature_shift + DrawList::root_signature_bits == 64, "Key fields must fill 64 bits");
+
+	std::uint32_t const radix_bits = 8;
+	std::uint32_t const radix = 1 << radix_bits;
+	std::uint32_t const pass_count = 64 / radix_bits;
+
+	// Smallest run of items worth a thread of its own.
+	std::uint32_t const min_block_size = 16384;
+
+	std::uint64_t mask(std::uint32_t bits)
+	{
+		return (std::uint64_t(1) << bits) - 1;
+	}
+
+	std::uint32_t field(std::uint64_t key, std::uint32_t shift, std::uint32_t bits)
+	{
+		return static_cast<std::uint32_t>((key >> shift) & mask(bits));
+	}
+
+	std::uint32_t digit(std::uint64_t key, std::uint32_t pass)
+	{
+		return static_cast<std::uint32_t>(key >> (pass * radix_bits)) & (radix - 1);
+	}
+}
+
+std::uint64_t DrawList::makeKey(
+	std::uint32_t root_signature,
+	std::uint32_t pso,
+	std::uint32_t mesh,
+	float depth,
+	std::uint32_t material)
+{
+	assert(root_signature <= mask(root_signature_bits));
+	assert(pso <= mask(pso_bits));
+	assert(mesh <= mask(mesh_bits));
+	assert(material <= mask(material_bits));
+
+	std::uint64_t depth_bucket = static_cast<std::uint64_t>(
+		std::min(std::max(depth, 0.0f), 1.0f) * static_cast<float>(mask(depth_bits)) + 0.5f);
+
+	return
+		static_cast<std::uint64_t>(root_signature) << root_signature_shift |
+		static_cast<std::uint64_t>(pso) << pso_shift |
+		static_cast<std::uint64_t>(mesh) << mesh_shift |
+		depth_bucket << depth_shift |
+		static_cast<std::uint64_t>(material) << material_shift;
+}
+
+std::uint32_t DrawList::rootSignatureOf(std::uint64_t key)
+{
+	return field(key, root_signature_shift, root_signature_bits);
+}
+
+std::uint32_t DrawList::psoOf(std::uint64_t key)
+{
+	return field(key, pso_shift, pso_bits);
+}
+
+std::uint32_t DrawList::meshOf(std::uint64_t key)
+{
+	return field(key, mesh_shift, mesh_bits);
+}
+
+std::uint32_t DrawList::materialOf(std::uint64_t key)
+{
+	return field(key, material_shift, material_bits);
+}
+
+void DrawList::clear()
+{
+	items.clear();
+}
+
+void DrawList::add(std::uint64_t key, std::uint32_t draw)
+{
+	items.push_back({ key, draw });
+}
+
+void DrawList::sort()
+{
+	submitted_statistics = countStateChanges();
+	radixSort(nullptr);
+	sorted_statistics = countStateChanges();
+}
+
+void DrawList::sort(ThreadPool& thread_pool)
+{
+	submitted_statistics = countStateChanges();
+	radixSort(&thread_pool);
+	sorted_statistics = countStateChanges();
+}
+
+DrawList::Statistics DrawList::countStateChanges() const
+{
+	Statistics statistics;
+
+	for (std::size_t i = 1; i < items.size(); ++i)
+	{
+		std::uint64_t a = items[i - 1].key;
+		std::uint64_t b = items[i].key;
+
+		statistics.root_signature_changes += rootSignatureOf(a) != rootSignatureOf(b);
+		statistics.pso_changes += psoOf(a) != psoOf(b);
+		statistics.mesh_changes += meshOf(a) != meshOf(b);
+		statistics.material_changes += materialOf(a) != materialOf(b);
+	}
+
+	return statistics;
+}
+
+void DrawList::radixSort(ThreadPool* thread_pool)
+{
+	std::uint32_t count = static_cast<std::uint32_t>(items.size());
+
+	if (count < 2)
+	{
+		return;
+	}
+
+	scratch.resize(count);
+
+	// Items are split into fixed blocks, each with its own histogram, so
+	// every block can scatter its items on any thread and stay stable.
+	std::uint32_t block_count = 1;
+
+	if (thread_pool && thread_pool->threadCount() > 1)
+	{
+		block_count = std::max(1u, std::min(4 * thread_pool->threadCount(), count / min_block_size));
+	}
+
+	std::uint32_t block_size = (count + block_count - 1) / block_count;
+	block_count = (count + block_size - 1) / block_size;
+
+	auto forEachBlock = [&](auto const& fn)
+	{
+		if (block_count == 1)
+		{
+			fn(0u, 0u, count);
+			return;
+		}
+
+		thread_pool->parallelFor(block_count, [&](std::uint32_t first_block, std::uint32_t last_block)
+		{
+			for (std::uint32_t block = first_block; block < last_block; ++block)
+			{
+				fn(block, block * block_size, std::min(count, (block + 1) * block_size));
+			}
+		});
+	};
+
+	// Histograms of every byte in one read. Their totals do not depend on
+	// the order of the items, so they tell which passes can be skipped.
+	std::vector<std::uint32_t> histograms(block_count * pass_count * radix, 0);
+
+	forEachBlock([&](std::uint32_t block, std::uint32_t begin, std::uint32_t end)
+	{
+		std::uint32_t* histogram = &histograms[block * pass_count * radix];
+
+		for (std::uint32_t i = begin; i < end; ++i)
+		{
+			std::uint64_t key = items[i].key;
+
+			for (std::uint32_t pass = 0; pass < pass_count; ++pass)
+			{
+				++histogram[pass * radix + digit(key, pass)];
+			}
+		}
+	});
+
+	std::vector<std::uint32_t> offsets(block_count * radix);
+	bool block_histograms_current = true;
+
+	for (std::uint32_t pass = 0; pass < pass_count; ++pass)
+	{
+		std::uint32_t totals[radix] = {};
+
+		for (std::uint32_t block = 0; block < block_count; ++block)
+		{
+			for (std::uint32_t d = 0; d < radix; ++d)
+			{
+				totals[d] += histograms[(block * pass_count + pass) * radix + d];
+			}
+		}
+
+		if (totals[digit(items[0].key, pass)] == count)
+		{
+			continue;
+		}
+
+		// Per-block histograms of later bytes go stale once items move
+		// between blocks.
+		if (!block_histograms_current)
+		{
+			forEachBlock([&](std::uint32_t block, std::uint32_t begin, std::uint32_t end)
+			{
+				std::uint32_t* histogram = &histograms[(block * pass_count + pass) * radix];
+				std::fill(histogram, histogram + radix, 0);
+
+				for (std::uint32_t i = begin; i < end; ++i)
+				{
+					++histogram[digit(items[i].key, pass)];
+				}
+			});
+		}
+
+		std::uint32_t sum = 0;
+
+		for (std::uint32_t d = 0; d < radix; ++d)
+		{
+			for (std::uint32_t block = 0; block < block_count; ++block)
+			{
+				offsets[block * radix + d] = sum;
+				sum += histograms[(block * pass_count + pass) * radix + d];
+			}
+		}
+
+		forEachBlock([&](std::uint32_t block, std::uint32_t begin, std::uint32_t end)
+		{
+			std::uint32_t* offset = &offsets[block * radix];
+
+			for (std::uint32_t i = begin; i < end; ++i)
+			{
+				scratch[offset[digit(items[i].key, pass)]++] = items[i];
+			}
+		});
+
+		items.swap(scratch);
+		block_histograms_current = block_count == 1;
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "threadPool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Visible draws of a frame, each with a 64-bit key that orders them by the
+// state they need, so recording in key order changes the root signature,
+// PSO and vertex/index buffers as rarely as possible. Keys are sorted with
+// an LSD radix sort, one byte per pass; passes whose byte is the same for
+// every key are skipped, which is most of them when only a few root
+// signatures and PSOs are in use.
+class DrawList
+{
+public:
+	// Key fields, most significant first. A PSO is created against one root
+	// signature, so the root signature goes above it.
+	static std::uint32_t const root_signature_bits = 4;
+	static std::uint32_t const pso_bits = 12;
+	static std::uint32_t const mesh_bits = 16;
+	static std::uint32_t const depth_bits = 16;
+	static std::uint32_t const material_bits = 16;
+
+	struct Item
+	{
+		std::uint64_t key;
+
+		// Caller's index of the draw, e.g. into its array of render items.
+		std::uint32_t draw;
+	};
+
+	// Number of times consecutive items differ in a field, i.e. the state
+	// changes recording the list in its current order costs.
+	struct Statistics
+	{
+		std::uint32_t root_signature_changes = 0;
+		std::uint32_t pso_changes = 0;
+		std::uint32_t mesh_changes = 0;
+		std::uint32_t material_changes = 0;
+	};
+
+	// depth is normalized to [0, 1] and quantized, so opaque draws go front
+	// to back; pass 1 - depth for back to front.
+	static std::uint64_t makeKey(
+		std::uint32_t root_signature,
+		std::uint32_t pso,
+		std::uint32_t mesh,
+		float depth,
+		std::uint32_t material);
+
+	static std::uint32_t rootSignatureOf(std::uint64_t key);
+	static std::uint32_t psoOf(std::uint64_t key);
+	static std::uint32_t meshOf(std::uint64_t key);
+	static std::uint32_t materialOf(std::uint64_t key);
+
+	void clear();
+	void add(std::uint64_t key, std::uint32_t draw);
+
+	// Stable: draws with equal keys keep the order they were added in.
+	// Records the statistics of the list before and after sorting.
+	void sort();
+
+	// Same result, with the histograms and scatters of each pass split
+	// between the threads of thread_pool.
+	void sort(ThreadPool& thread_pool);
+
+	std::vector<Item> const& getItems() const
+	{
+		return items;
+	}
+
+	Statistics countStateChanges() const;
+
+	Statistics getSubmittedStatistics() const
+	{
+		return submitted_statistics;
+	}
+
+	Statistics getSortedStatistics() const
+	{
+		return sorted_statistics;
+	}
+
+private:
+	void radixSort(ThreadPool* thread_pool);
+
+	std::vector<Item> items;
+	std::vector<Item> scratch;
+
+	Statistics submitted_statistics;
+	Statistics sorted_statistics;
+};
@@ -0,0 +1,215 @@
+#include "fenceWaiter.hpp"
+
+#include <cassert>
+
+FenceWaiter::FenceWaiter(WaitEventBackend& backend)
+	:
+	backend{ backend }
+{
+
+}
+
+FenceWaiter::~FenceWaiter()
+{
+	for (auto event : free_events)
+	{
+		backend.destroyEvent(event);
+	}
+
+	for (auto event : pending_events)
+	{
+		backend.destroyEvent(event);
+	}
+}
+
+bool FenceWaiter::poll(FenceTimeline& fence, std::uint64_t value)
+{
+	return fence.isComplete(value);
+}
+
+bool FenceWaiter::wait(FenceTimeline& fence, std::uint64_t value, std::uint32_t timeout_ms)
+{
+	Wait single_wait{ &fence, value };
+
+	return waitAll(&single_wait, 1, timeout_ms);
+}
+
+bool FenceWaiter::waitAll(Wait const* waits, std::uint32_t count, std::uint32_t timeout_ms)
+{
+	assert(count <= max_wait_count);
+
+	if (timeout_ms == 0)
+	{
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			if (!waits[i].fence->isComplete(waits[i].value))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void* events[max_wait_count];
+	std::uint32_t event_waits[max_wait_count];
+	std::uint32_t event_count = armEvents(waits, count, events, event_waits);
+
+	if (event_count == 0)
+	{
+		return true;
+	}
+
+	++blocking_waits;
+
+	std::int32_t result = backend.wait(events, event_count, true, timeout_ms);
+
+	// Waiting for all events resets all of them, timing out resets none.
+	if (result == WaitEventBackend::timed_out)
+	{
+		pending_events.insert(pending_events.end(), events, events + event_count);
+
+		return false;
+	}
+
+	free_events.insert(free_events.end(), events, events + event_count);
+
+	for (std::uint32_t i = 0; i < event_count; ++i)
+	{
+		waits[event_waits[i]].fence->noteCompleted(waits[event_waits[i]].value);
+	}
+
+	return true;
+}
+
+std::int32_t FenceWaiter::waitAny(Wait const* waits, std::uint32_t count, std::uint32_t timeout_ms)
+{
+	assert(count <= max_wait_count);
+
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		if (waits[i].fence->isComplete(waits[i].value))
+		{
+			return static_cast<std::int32_t>(i);
+		}
+	}
+
+	if (timeout_ms == 0 || count == 0)
+	{
+		return -1;
+	}
+
+	void* events[max_wait_count];
+	std::uint32_t event_waits[max_wait_count];
+
+	// A fence may complete between the checks above and arming its event.
+	std::int32_t first_completed = -1;
+	std::uint32_t event_count = armEvents(waits, count, events, event_waits, &first_completed);
+
+	if (first_completed >= 0)
+	{
+		return first_completed;
+	}
+
+	++blocking_waits;
+
+	std::int32_t result = backend.wait(events, event_count, false, timeout_ms);
+
+	for (std::uint32_t i = 0; i < event_count; ++i)
+	{
+		if (static_cast<std::int32_t>(i) == result)
+		{
+			free_events.push_back(events[i]);
+		}
+		else
+		{
+			pending_events.push_back(events[i]);
+		}
+	}
+
+	if (result == WaitEventBackend::timed_out)
+	{
+		return -1;
+	}
+
+	Wait const& completed = waits[event_waits[result]];
+	completed.fence->noteCompleted(completed.value);
+
+	return static_cast<std::int32_t>(event_waits[result]);
+}
+
+void* FenceWaiter::acquireEvent()
+{
+	if (free_events.empty())
+	{
+		recyclePendingEvents();
+	}
+
+	if (free_events.empty())
+	{
+		++events_created;
+
+		return backend.createEvent();
+	}
+
+	void* event = free_events.back();
+	free_events.pop_back();
+
+	return event;
+}
+
+void FenceWaiter::recyclePendingEvents()
+{
+	std::size_t kept = 0;
+
+	for (auto event : pending_events)
+	{
+		// A zero timeout wait consumes the signal if it has arrived.
+		if (backend.wait(&event, 1, true, 0) != WaitEventBackend::timed_out)
+		{
+			free_events.push_back(event);
+		}
+		else
+		{
+			pending_events[kept++] = event;
+		}
+	}
+
+	pending_events.resize(kept);
+}
+
+std::uint32_t FenceWaiter::armEvents(
+	Wait const* waits,
+	std::uint32_t count,
+	void** events,
+	std::uint32_t* event_waits,
+	std::int32_t* first_completed)
+{
+	std::uint32_t event_count = 0;
+
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		if (waits[i].fence->isComplete(waits[i].value))
+		{
+			if (first_completed == nullptr)
+			{
+				continue;
+			}
+
+			// The armed events still fire later, so they cannot be reused yet.
+			pending_events.insert(pending_events.end(), events, events + event_count);
+			*first_completed = static_cast<std::int32_t>(i);
+
+			return 0;
+		}
+
+		void* event = acquireEvent();
+		waits[i].fence->setEventOnCompletion(waits[i].value, event);
+
+		events[event_count] = event;
+		event_waits[event_count] = i;
+		++event_count;
+	}
+
+	return event_count;
+}
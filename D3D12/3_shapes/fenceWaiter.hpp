@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// A fence as FenceWaiter sees it. The last completed value is cached, so
+// checking a value the fence is already known to have passed costs no call
+// into the driver. d3d12Fence.hpp wraps ID3D12Fence; tests can implement
+// this over a simulated timeline.
+class FenceTimeline
+{
+public:
+	virtual ~FenceTimeline() = default;
+
+	bool isComplete(std::uint64_t value)
+	{
+		return value <= completed_value || value <= refresh();
+	}
+
+	// Queries the fence and updates the cache.
+	std::uint64_t refresh()
+	{
+		std::uint64_t value = queryCompletedValue();
+		++query_count;
+
+		completed_value = value > completed_value ? value : completed_value;
+
+		return completed_value;
+	}
+
+	// Last value seen by refresh; the fence may be further along.
+	std::uint64_t lastCompletedValue() const
+	{
+		return completed_value;
+	}
+
+	std::uint64_t queryCount() const
+	{
+		return query_count;
+	}
+
+	// Signals event once the fence reaches value (immediately if it has).
+	virtual void setEventOnCompletion(std::uint64_t value, void* event) = 0;
+
+protected:
+	virtual std::uint64_t queryCompletedValue() = 0;
+
+private:
+	friend class FenceWaiter;
+
+	// Called after an event for value fired, which proves the fence passed it.
+	void noteCompleted(std::uint64_t value)
+	{
+		completed_value = value > completed_value ? value : completed_value;
+	}
+
+	std::uint64_t completed_value = 0;
+	std::uint64_t query_count = 0;
+};
+
+// Auto-reset events and waits on them, e.g. Win32 events.
+class WaitEventBackend
+{
+public:
+	static std::int32_t const timed_out = -1;
+
+	virtual ~WaitEventBackend() = default;
+
+	virtual void* createEvent() = 0;
+	virtual void destroyEvent(void* event) = 0;
+
+	// Waits for one (wait_all false) or all of count events and resets the
+	// ones it returns for. Returns the index of the signaled event, 0 when
+	// all were, or timed_out.
+	virtual std::int32_t wait(void* const* events, std::uint32_t count, bool wait_all, std::uint32_t timeout_ms) = 0;
+};
+
+// Blocking and non-blocking waits on fence values, with events taken from
+// a pool instead of being created and closed around every wait. Meant to
+// be used from one thread.
+class FenceWaiter
+{
+public:
+	static std::uint32_t const infinite = 0xFFFFFFFF;
+
+	// Limit of WaitForMultipleObjects.
+	static std::uint32_t const max_wait_count = 64;
+
+	struct Wait
+	{
+		FenceTimeline* fence;
+		std::uint64_t value;
+	};
+
+	FenceWaiter(FenceWaiter const&) = delete;
+	FenceWaiter& operator=(FenceWaiter const&) = delete;
+
+	explicit FenceWaiter(WaitEventBackend& backend);
+	~FenceWaiter();
+
+	// Non-blocking.
+	bool poll(FenceTimeline& fence, std::uint64_t value);
+
+	// Returns false if timeout_ms elapsed first.
+	bool wait(FenceTimeline& fence, std::uint64_t value, std::uint32_t timeout_ms = infinite);
+
+	// Waits until every fence reached its value. Returns false on timeout.
+	bool waitAll(Wait const* waits, std::uint32_t count, std::uint32_t timeout_ms = infinite);
+
+	// Waits until any fence reached its value and returns that wait's
+	// index, or -1 on timeout.
+	std::int32_t waitAny(Wait const* waits, std::uint32_t count, std::uint32_t timeout_ms = infinite);
+
+	std::uint32_t eventsCreated() const
+	{
+		return events_created;
+	}
+
+	std::uint64_t blockingWaits() const
+	{
+		return blocking_waits;
+	}
+
+private:
+	void* acquireEvent();
+
+	// Events still armed by setEventOnCompletion after their wait returned
+	// are signaled later; reusing one before that signal is consumed would
+	// end its next wait early.
+	void recyclePendingEvents();
+
+	// Arms an event for each wait in waits that is not complete yet. With
+	// first_completed, stops instead at the first wait found complete,
+	// stores its index there and returns 0; events armed before it are
+	// moved to pending_events.
+	std::uint32_t armEvents(
+		Wait const* waits,
+		std::uint32_t count,
+		void** events,
+		std::uint32_t* event_waits,
+		std::int32_t* first_completed = nullptr);
+
+	WaitEventBackend& backend;
+
+	std::vector<void*> free_events;
+	std::vector<void*> pending_events;
+
+	std::uint32_t events_created = 0;
+	std::uint64_t blocking_waits = 0;
+};
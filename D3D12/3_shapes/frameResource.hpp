@@ -1,6 +1,8 @@
 #pragma once
 
+#include "instanceBatcher.hpp"
 #include "math.hpp"
+#include "renderItems.hpp"
 #include "uploadBuffer.hpp"
 
 struct ObjectConstants
@@ -34,7 +36,7 @@ struct Vertex
 
 struct FrameResource
 {
-	FrameResource(ID3D12Device* device, UINT pass_count, UINT object_count)
+	FrameResource(ID3D12Device* device, UINT pass_count, UINT object_count, UINT max_instance_count = 0)
 	{
 		THROW_IF_FAILED(device->CreateCommandAllocator(
 			D3D12_COMMAND_LIST_TYPE_DIRECT,
@@ -42,6 +44,12 @@ struct FrameResource
 
 		pass_cb = std::make_unique<UploadBuffer<PassConstants>>(device, pass_count, true);
 		object_cb = std::make_unique<UploadBuffer<ObjectConstants>>(device, object_count, true);
+
+		if (max_instance_count > 0)
+		{
+			instance_buffer = std::make_unique<UploadBuffer<InstanceBatcher::InstanceData>>(
+				device, max_instance_count, false);
+		}
 	}
 
 	~FrameResource()
@@ -57,5 +65,25 @@ struct FrameResource
 	std::unique_ptr<UploadBuffer<PassConstants>> pass_cb = nullptr;
 	std::unique_ptr<UploadBuffer<ObjectConstants>> object_cb = nullptr;
 
+	// Per-instance data of InstanceBatcher, bound as a structured buffer.
+	std::unique_ptr<UploadBuffer<InstanceBatcher::InstanceData>> instance_buffer = nullptr;
+
 	UINT64 fence = 0;
 };
+
+// Transposes and copies into frame.object_cb only the objects whose
+// constants it holds stale. frame must be the one FrameRing::beginFrame
+// just returned. Returns the number of objects written.
+inline UINT updateObjectConstants(RenderItemSet& items, FrameResource& frame)
+{
+	return items.updateFrame([&frame](std::uint32_t index, DirectX::XMFLOAT4X4 const& world)
+	{
+		ObjectConstants object_constants;
+
+		DirectX::XMStoreFloat4x4(
+			&object_constants.world,
+			DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&world)));
+
+		frame.object_cb->copyData(index, object_constants);
+	});
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Ring of per-frame resources that lets the CPU record up to frame_count
+// frames ahead of the GPU. Each Resource has a `fence` member holding the
+// fence value signaled after the last frame that used it (as in
+// FrameResource), and reusing a slot waits for that value only, instead of
+// draining the queue every frame.
+//
+// The fence itself stays outside: callers pass its completed value and a
+// function that blocks until a given value is reached, so the bookkeeping
+// runs the same against an ID3D12Fence or a simulated timeline.
+template <typename Resource>
+class FrameRing
+{
+public:
+	FrameRing(FrameRing const&) = delete;
+	FrameRing& operator=(FrameRing const&) = delete;
+
+	// Builds frame_count resources, each constructed from args.
+	template <typename... Args>
+	explicit FrameRing(std::uint32_t frame_count, Args const&... args)
+	{
+		for (std::uint32_t i = 0; i < frame_count; ++i)
+		{
+			resources.push_back(std::make_unique<Resource>(args...));
+		}
+
+		// The first beginFrame moves to slot 0.
+		current_index = frame_count - 1;
+	}
+
+	// Moves to the next slot and, while the GPU may still be reading it,
+	// calls wait(fence value of the slot). Call once per frame before any
+	// of the slot's allocators or buffers are touched.
+	template <typename Wait>
+	Resource& beginFrame(std::uint64_t completed_value, Wait&& wait)
+	{
+		current_index = (current_index + 1) % frameCount();
+
+		Resource& resource = *resources[current_index];
+
+		if (resource.fence != 0 && resource.fence > completed_value)
+		{
+			++wait_count;
+			wait(resource.fence);
+		}
+
+		return resource;
+	}
+
+	// Records the fence value signaled after the current frame's command
+	// lists were submitted.
+	void endFrame(std::uint64_t fence_value)
+	{
+		resources[current_index]->fence = fence_value;
+	}
+
+	// Largest fence value of any slot; waiting for it idles the ring, e.g.
+	// before resizing or releasing what the frames reference.
+	std::uint64_t lastFenceValue() const
+	{
+		std::uint64_t value = 0;
+
+		for (auto const& resource : resources)
+		{
+			value = resource->fence > value ? resource->fence : value;
+		}
+
+		return value;
+	}
+
+	// Frames submitted but not yet completed by the GPU.
+	std::uint32_t framesInFlight(std::uint64_t completed_value) const
+	{
+		std::uint32_t count = 0;
+
+		for (auto const& resource : resources)
+		{
+			count += resource->fence > completed_value;
+		}
+
+		return count;
+	}
+
+	Resource& current()
+	{
+		return *resources[current_index];
+	}
+
+	Resource& operator[](std::uint32_t index)
+	{
+		return *resources[index];
+	}
+
+	std::uint32_t currentIndex() const
+	{
+		return current_index;
+	}
+
+	std::uint32_t frameCount() const
+	{
+		return static_cast<std::uint32_t>(resources.size());
+	}
+
+	// Times beginFrame called wait, i.e. the slot's fence value was beyond
+	// the completed value passed in.
+	std::uint64_t waitCount() const
+	{
+		return wait_count;
+	}
+
+private:
+	std::vector<std::unique_ptr<Resource>> resources;
+	std::uint32_t current_index = 0;
+
+	std::uint64_t wait_count = 0;
+};
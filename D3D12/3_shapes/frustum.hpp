@@ -0,0 +1,69 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// The six planes of a view frustum, pointing inwards and normalized, so
+// dot(plane.xyz, p) + plane.w is the signed distance of p to each of them.
+struct Frustum
+{
+	enum Plane
+	{
+		Left,
+		Right,
+		Bottom,
+		Top,
+		Near,
+		Far,
+		PlaneCount
+	};
+
+	DirectX::XMFLOAT4 planes[PlaneCount];
+
+	// Extracts the planes from a row-vector view_proj such as
+	// PassConstants::view_proj (before it is transposed for HLSL), with
+	// the D3D clip space depth range [0, 1].
+	static Frustum fromViewProj(DirectX::XMFLOAT4X4 const& view_proj)
+	{
+		auto const& m = view_proj.m;
+
+		auto column = [&m](int j)
+		{
+			return DirectX::XMVectorSet(m[0][j], m[1][j], m[2][j], m[3][j]);
+		};
+
+		DirectX::XMVECTOR x = column(0);
+		DirectX::XMVECTOR y = column(1);
+		DirectX::XMVECTOR z = column(2);
+		DirectX::XMVECTOR w = column(3);
+
+		Frustum frustum;
+
+		DirectX::XMStoreFloat4(&frustum.planes[Left], DirectX::XMPlaneNormalize(w + x));
+		DirectX::XMStoreFloat4(&frustum.planes[Right], DirectX::XMPlaneNormalize(w - x));
+		DirectX::XMStoreFloat4(&frustum.planes[Bottom], DirectX::XMPlaneNormalize(w + y));
+		DirectX::XMStoreFloat4(&frustum.planes[Top], DirectX::XMPlaneNormalize(w - y));
+		DirectX::XMStoreFloat4(&frustum.planes[Near], DirectX::XMPlaneNormalize(z));
+		DirectX::XMStoreFloat4(&frustum.planes[Far], DirectX::XMPlaneNormalize(w - z));
+
+		return frustum;
+	}
+
+	bool intersectsSphere(DirectX::XMFLOAT3 const& center, float radius) const
+	{
+		for (int i = 0; i < PlaneCount; ++i)
+		{
+			float distance =
+				planes[i].x * center.x +
+				planes[i].y * center.y +
+				planes[i].z * center.z +
+				planes[i].w;
+
+			if (distance < -radius)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
@@ -0,0 +1,233 @@
+#include "frustumCuller.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	struct SplatPlane
+	{
+		XMVECTOR x, y, z, w;
+		XMVECTOR abs_x, abs_y, abs_z;
+	};
+
+	XMVECTOR loadFour(std::vector<float> const& stream, std::uint32_t first)
+	{
+		return XMLoadFloat4(reinterpret_cast<XMFLOAT4 const*>(stream.data() + first));
+	}
+}
+
+std::uint32_t FrustumCuller::addObject(BoundingBox const& local_bounds, XMFLOAT4X4 const& world)
+{
+	std::uint32_t object = object_count++;
+
+	if (object_count > center_x.size())
+	{
+		std::size_t padded_size = center_x.size() + batch_size;
+
+		for (auto stream : { &center_x, &center_y, &center_z, &extent_x, &extent_y, &extent_z, &radius })
+		{
+			stream->resize(padded_size, 0.0f);
+		}
+	}
+
+	transformBounds(object, local_bounds, world);
+
+	return object;
+}
+
+void FrustumCuller::setObject(std::uint32_t object, BoundingBox const& local_bounds, XMFLOAT4X4 const& world)
+{
+	assert(object < object_count);
+
+	transformBounds(object, local_bounds, world);
+}
+
+void FrustumCuller::clear()
+{
+	for (auto stream : { &center_x, &center_y, &center_z, &extent_x, &extent_y, &extent_z, &radius })
+	{
+		stream->clear();
+	}
+
+	object_count = 0;
+}
+
+std::uint32_t FrustumCuller::objectCount() const
+{
+	return object_count;
+}
+
+void FrustumCuller::transformBounds(
+	std::uint32_t object,
+	BoundingBox const& local_bounds,
+	XMFLOAT4X4 const& world)
+{
+	// Arvo: the world AABB of a transformed box has the transformed center
+	// and extents |M| * e, with M the upper 3x3 of the row-vector matrix.
+	XMFLOAT3 const& c = local_bounds.Center;
+	XMFLOAT3 const& e = local_bounds.Extents;
+	auto const& m = world.m;
+
+	center_x[object] = c.x * m[0][0] + c.y * m[1][0] + c.z * m[2][0] + m[3][0];
+	center_y[object] = c.x * m[0][1] + c.y * m[1][1] + c.z * m[2][1] + m[3][1];
+	center_z[object] = c.x * m[0][2] + c.y * m[1][2] + c.z * m[2][2] + m[3][2];
+
+	extent_x[object] = e.x * fabsf(m[0][0]) + e.y * fabsf(m[1][0]) + e.z * fabsf(m[2][0]);
+	extent_y[object] = e.x * fabsf(m[0][1]) + e.y * fabsf(m[1][1]) + e.z * fabsf(m[2][1]);
+	extent_z[object] = e.x * fabsf(m[0][2]) + e.y * fabsf(m[1][2]) + e.z * fabsf(m[2][2]);
+
+	radius[object] = sqrtf(
+		extent_x[object] * extent_x[object] +
+		extent_y[object] * extent_y[object] +
+		extent_z[object] * extent_z[object]);
+}
+
+void FrustumCuller::cull(Frustum const& frustum, std::vector<std::uint32_t>& visible, Test test) const
+{
+	visible.resize(object_count);
+	visible.resize(cullRange(frustum, 0, object_count, visible.data(), test));
+}
+
+void FrustumCuller::cull(
+	Frustum const& frustum,
+	std::vector<std::uint32_t>& visible,
+	ThreadPool& thread_pool,
+	Test test) const
+{
+	std::uint32_t batch_count = (object_count + batch_size - 1) / batch_size;
+
+	// Runs of whole batches, a few per thread so uneven runs balance out.
+	std::uint32_t run_count = std::min(batch_count, 4 * thread_pool.threadCount());
+
+	if (run_count <= 1)
+	{
+		cull(frustum, visible, test);
+		return;
+	}
+
+	std::uint32_t batches_per_run = (batch_count + run_count - 1) / run_count;
+	std::uint32_t objects_per_run = batches_per_run * batch_size;
+	run_count = (batch_count + batches_per_run - 1) / batches_per_run;
+
+	std::vector<std::uint32_t> run_visible(run_count);
+	visible.resize(object_count);
+
+	thread_pool.parallelFor(run_count, [&](std::uint32_t first_run, std::uint32_t last_run)
+	{
+		for (std::uint32_t run = first_run; run < last_run; ++run)
+		{
+			std::uint32_t begin = run * objects_per_run;
+			std::uint32_t end = std::min(begin + objects_per_run, object_count);
+
+			run_visible[run] = cullRange(frustum, begin, end, visible.data() + begin, test);
+		}
+	});
+
+	std::uint32_t visible_count = run_visible[0];
+
+	for (std::uint32_t run = 1; run < run_count; ++run)
+	{
+		std::memmove(
+			visible.data() + visible_count,
+			visible.data() + run * objects_per_run,
+			run_visible[run] * sizeof(std::uint32_t));
+
+		visible_count += run_visible[run];
+	}
+
+	visible.resize(visible_count);
+}
+
+std::uint32_t FrustumCuller::cullRange(
+	Frustum const& frustum,
+	std::uint32_t begin,
+	std::uint32_t end,
+	std::uint32_t* out,
+	Test test) const
+{
+	assert(begin % batch_size == 0);
+	assert(end <= object_count);
+
+	SplatPlane planes[Frustum::PlaneCount];
+
+	for (int i = 0; i < Frustum::PlaneCount; ++i)
+	{
+		XMVECTOR plane = XMLoadFloat4(&frustum.planes[i]);
+
+		planes[i].x = XMVectorSplatX(plane);
+		planes[i].y = XMVectorSplatY(plane);
+		planes[i].z = XMVectorSplatZ(plane);
+		planes[i].w = XMVectorSplatW(plane);
+		planes[i].abs_x = XMVectorAbs(planes[i].x);
+		planes[i].abs_y = XMVectorAbs(planes[i].y);
+		planes[i].abs_z = XMVectorAbs(planes[i].z);
+	}
+
+	XMVECTOR zero = XMVectorZero();
+	std::uint32_t count = 0;
+
+	for (std::uint32_t first = begin; first < end; first += batch_size)
+	{
+		XMVECTOR cx[2] = { loadFour(center_x, first), loadFour(center_x, first + 4) };
+		XMVECTOR cy[2] = { loadFour(center_y, first), loadFour(center_y, first + 4) };
+		XMVECTOR cz[2] = { loadFour(center_z, first), loadFour(center_z, first + 4) };
+
+		XMVECTOR ex[2], ey[2], ez[2], r[2];
+
+		if (test == Test::Box)
+		{
+			ex[0] = loadFour(extent_x, first);
+			ex[1] = loadFour(extent_x, first + 4);
+			ey[0] = loadFour(extent_y, first);
+			ey[1] = loadFour(extent_y, first + 4);
+			ez[0] = loadFour(extent_z, first);
+			ez[1] = loadFour(extent_z, first + 4);
+		}
+		else
+		{
+			r[0] = loadFour(radius, first);
+			r[1] = loadFour(radius, first + 4);
+		}
+
+		XMVECTOR inside[2] = { XMVectorTrueInt(), XMVectorTrueInt() };
+
+		for (auto const& plane : planes)
+		{
+			for (int half = 0; half < 2; ++half)
+			{
+				XMVECTOR distance = XMVectorMultiplyAdd(plane.x, cx[half],
+					XMVectorMultiplyAdd(plane.y, cy[half],
+					XMVectorMultiplyAdd(plane.z, cz[half], plane.w)));
+
+				// Projected half size of the box on the plane normal.
+				XMVECTOR reach = test == Test::Box ?
+					XMVectorMultiplyAdd(plane.abs_x, ex[half],
+					XMVectorMultiplyAdd(plane.abs_y, ey[half],
+					XMVectorMultiply(plane.abs_z, ez[half]))) :
+					r[half];
+
+				inside[half] = XMVectorAndInt(inside[half], XMVectorGreaterOrEqual(distance + reach, zero));
+			}
+		}
+
+		std::uint32_t lanes[batch_size];
+		XMStoreInt4(lanes + 0, inside[0]);
+		XMStoreInt4(lanes + 4, inside[1]);
+
+		std::uint32_t lane_count = std::min(batch_size, end - first);
+
+		// Branchless append: every lane is written, only visible ones count.
+		for (std::uint32_t lane = 0; lane < lane_count; ++lane)
+		{
+			out[count] = first + lane;
+			count += lanes[lane] & 1;
+		}
+	}
+
+	return count;
+}
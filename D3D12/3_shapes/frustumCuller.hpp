@@ -0,0 +1,76 @@
+#pragma once
+
+#include "frustum.hpp"
+#include "threadPool.hpp"
+
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+// World space bounds of many objects kept as one stream per component, so
+// the plane tests run on eight objects per iteration (two DirectXMath
+// vectors of four) without gathering.
+class FrustumCuller
+{
+public:
+	enum class Test
+	{
+		// Exact AABB against plane test.
+		Box,
+
+		// Sphere around each AABB: cheaper, slightly more conservative.
+		Sphere
+	};
+
+	static std::uint32_t const batch_size = 8;
+
+	// local_bounds is usually SubmeshGeometry::bounds and world the matrix
+	// that goes into ObjectConstants. Returns the index reported by cull.
+	std::uint32_t addObject(DirectX::BoundingBox const& local_bounds, DirectX::XMFLOAT4X4 const& world);
+	void setObject(std::uint32_t object, DirectX::BoundingBox const& local_bounds, DirectX::XMFLOAT4X4 const& world);
+
+	void clear();
+	std::uint32_t objectCount() const;
+
+	// Replaces visible with the indices of the objects inside frustum, in
+	// increasing order. Build frustum with Frustum::fromViewProj from
+	// PassConstants::view_proj.
+	void cull(Frustum const& frustum, std::vector<std::uint32_t>& visible, Test test = Test::Box) const;
+
+	// Same result, with each thread of thread_pool culling its own run of
+	// batches into a disjoint part of visible before it is compacted.
+	void cull(
+		Frustum const& frustum,
+		std::vector<std::uint32_t>& visible,
+		ThreadPool& thread_pool,
+		Test test = Test::Box) const;
+
+	// Culls objects [begin, end), begin being a multiple of batch_size, and
+	// writes the visible ones to out, which needs room for end - begin
+	// indices. Returns how many were written.
+	std::uint32_t cullRange(
+		Frustum const& frustum,
+		std::uint32_t begin,
+		std::uint32_t end,
+		std::uint32_t* out,
+		Test test = Test::Box) const;
+
+private:
+	void transformBounds(
+		std::uint32_t object,
+		DirectX::BoundingBox const& local_bounds,
+		DirectX::XMFLOAT4X4 const& world);
+
+	// Padded to a multiple of batch_size; the padding is never reported.
+	std::vector<float> center_x;
+	std::vector<float> center_y;
+	std::vector<float> center_z;
+	std::vector<float> extent_x;
+	std::vector<float> extent_y;
+	std::vector<float> extent_z;
+	std::vector<float> radius;
+
+	std::uint32_t object_count = 0;
+};
@@ -1,14 +1,319 @@
 #include "geometryGenerator.hpp"
+#include "boundsBuilder.hpp"
 
 #include <algorithm>
 
 using namespace DirectX;
 
+namespace
+{
+	float const icosahedron_x = 0.525731f;
+	float const icosahedron_z = 0.850651f;
+
+	XMFLOAT3 const icosahedron_positions[12] =
+	{
+		XMFLOAT3(-icosahedron_x, 0.0f, icosahedron_z),  XMFLOAT3(icosahedron_x, 0.0f, icosahedron_z),
+		XMFLOAT3(-icosahedron_x, 0.0f, -icosahedron_z), XMFLOAT3(icosahedron_x, 0.0f, -icosahedron_z),
+		XMFLOAT3(0.0f, icosahedron_z, icosahedron_x),   XMFLOAT3(0.0f, icosahedron_z, -icosahedron_x),
+		XMFLOAT3(0.0f, -icosahedron_z, icosahedron_x),  XMFLOAT3(0.0f, -icosahedron_z, -icosahedron_x),
+		XMFLOAT3(icosahedron_z, icosahedron_x, 0.0f),   XMFLOAT3(-icosahedron_z, icosahedron_x, 0.0f),
+		XMFLOAT3(icosahedron_z, -icosahedron_x, 0.0f),  XMFLOAT3(-icosahedron_z, -icosahedron_x, 0.0f)
+	};
+
+	std::uint32_t const icosahedron_indices[60] =
+	{
+		1, 4, 0,
+		4, 9, 0,
+		4, 5, 9,
+		8, 5, 4,
+		1, 8, 4,
+
+		1, 10, 8,
+		10, 3, 8,
+		8, 3, 5,
+		3, 2, 5,
+		3, 7, 2,
+
+		3, 10, 7,
+		10, 6, 7,
+		6, 11, 7,
+		6, 0, 11,
+		6, 1, 0,
+
+		10, 1, 6,
+		11, 0, 9,
+		2, 11, 9,
+		5, 2, 9,
+		11, 2, 7
+	};
+
+	// Triangular lattice of n = 2^levels segments per icosahedron edge. A
+	// point (i, j) of face (a, b, c) is a + i / n * (b - a) + j / n * (c - a).
+	// Lattice indices are global: the 12 corners, then the points inside
+	// each of the 30 edges, then the points inside each of the 20 faces, so
+	// neighbouring faces share the points on their common edge.
+	class GeosphereLattice
+	{
+	public:
+		struct Point
+		{
+			std::uint32_t i;
+			std::uint32_t j;
+		};
+
+		GeosphereLattice(std::uint32_t levels)
+			:
+			n{ 1u << levels }
+		{
+			std::uint32_t n_edges = 0;
+
+			for (std::uint32_t f = 0; f < 20; ++f)
+			{
+				for (std::uint32_t e = 0; e < 3; ++e)
+				{
+					std::uint32_t a = icosahedron_indices[f * 3 + e];
+					std::uint32_t b = icosahedron_indices[f * 3 + (e + 1) % 3];
+
+					if (edges[a][b] == 0)
+					{
+						edge_ends[n_edges][0] = std::min(a, b);
+						edge_ends[n_edges][1] = std::max(a, b);
+
+						edges[a][b] = edges[b][a] = ++n_edges;
+					}
+				}
+			}
+
+			edge_base = 12;
+			face_base = edge_base + 30 * (n - 1);
+			face_size = n > 1 ? (n - 1) * (n - 2) / 2 : 0;
+		}
+
+		std::uint32_t vertexCount() const
+		{
+			return 10 * n * n + 2;
+		}
+
+		std::size_t triangleCount(std::uint32_t levels) const
+		{
+			return (std::size_t)20 << (2 * levels);
+		}
+
+		static Point midPoint(Point a, Point b)
+		{
+			return { (a.i + b.i) / 2, (a.j + b.j) / 2 };
+		}
+
+		std::uint32_t index(std::uint32_t face, Point p) const
+		{
+			std::uint32_t a = icosahedron_indices[face * 3 + 0];
+			std::uint32_t b = icosahedron_indices[face * 3 + 1];
+			std::uint32_t c = icosahedron_indices[face * 3 + 2];
+
+			std::uint32_t w = n - p.i - p.j;
+
+			if (p.i == n)
+				return b;
+
+			if (p.j == n)
+				return c;
+
+			if (w == n)
+				return a;
+
+			if (p.j == 0)
+				return edgeIndex(a, b, p.i);
+
+			if (p.i == 0)
+				return edgeIndex(a, c, p.j);
+
+			if (w == 0)
+				return edgeIndex(b, c, p.j);
+
+			std::uint32_t row = p.j - 1;
+			std::uint32_t row_offset = row * (n - 1) - row * (row + 1) / 2;
+
+			return face_base + face * face_size + row_offset + p.i - 1;
+		}
+
+		// Visits every lattice point once, with its unprojected position.
+		template <typename Fn>
+		void forEachVertex(Fn&& fn) const
+		{
+			for (std::uint32_t v = 0; v < 12; ++v)
+			{
+				fn(v, icosahedron_positions[v]);
+			}
+
+			for (std::uint32_t e = 0; e < 30; ++e)
+			{
+				for (std::uint32_t t = 1; t < n; ++t)
+				{
+					fn(edge_base + e * (n - 1) + t - 1, lerp(edge_ends[e][0], edge_ends[e][1], t));
+				}
+			}
+
+			for (std::uint32_t f = 0; f < 20; ++f)
+			{
+				std::uint32_t index = face_base + f * face_size;
+
+				for (std::uint32_t j = 1; j + 1 < n; ++j)
+				{
+					for (std::uint32_t i = 1; i + j < n; ++i)
+					{
+						fn(index++, lerp(
+							icosahedron_indices[f * 3 + 0],
+							icosahedron_indices[f * 3 + 1],
+							icosahedron_indices[f * 3 + 2],
+							i,
+							j));
+					}
+				}
+			}
+		}
+
+		// Visits the triangles of the given level in the order repeated
+		// subdivision produces them.
+		template <typename Fn>
+		void forEachTriangle(std::uint32_t level, Fn&& fn) const
+		{
+			for (std::uint32_t f = 0; f < 20; ++f)
+			{
+				visit(f, { 0, 0 }, { n, 0 }, { 0, n }, level, fn);
+			}
+		}
+
+	private:
+		std::uint32_t edgeIndex(std::uint32_t a, std::uint32_t b, std::uint32_t t) const
+		{
+			if (a > b)
+				t = n - t;
+
+			return edge_base + (edges[a][b] - 1) * (n - 1) + t - 1;
+		}
+
+		XMFLOAT3 lerp(std::uint32_t a, std::uint32_t b, std::uint32_t t) const
+		{
+			XMVECTOR pa = XMLoadFloat3(&icosahedron_positions[a]);
+			XMVECTOR pb = XMLoadFloat3(&icosahedron_positions[b]);
+
+			XMFLOAT3 p;
+			XMStoreFloat3(&p, pa + ((float)t / n) * (pb - pa));
+
+			return p;
+		}
+
+		XMFLOAT3 lerp(
+			std::uint32_t a,
+			std::uint32_t b,
+			std::uint32_t c,
+			std::uint32_t i,
+			std::uint32_t j) const
+		{
+			XMVECTOR pa = XMLoadFloat3(&icosahedron_positions[a]);
+			XMVECTOR pb = XMLoadFloat3(&icosahedron_positions[b]);
+			XMVECTOR pc = XMLoadFloat3(&icosahedron_positions[c]);
+
+			XMFLOAT3 p;
+			XMStoreFloat3(&p, pa + ((float)i / n) * (pb - pa) + ((float)j / n) * (pc - pa));
+
+			return p;
+		}
+
+		template <typename Fn>
+		void visit(
+			std::uint32_t face,
+			Point a,
+			Point b,
+			Point c,
+			std::uint32_t depth,
+			Fn& fn) const
+		{
+			if (depth == 0)
+			{
+				fn(face, a, b, c);
+				return;
+			}
+
+			Point m0 = midPoint(a, b);
+			Point m1 = midPoint(b, c);
+			Point m2 = midPoint(a, c);
+
+			visit(face, a, m0, m2, depth - 1, fn);
+			visit(face, m0, m1, m2, depth - 1, fn);
+			visit(face, m2, m1, c, depth - 1, fn);
+			visit(face, m0, b, m1, depth - 1, fn);
+		}
+
+		std::uint32_t n = 1;
+		std::uint32_t edges[12][12] = {};
+		std::uint32_t edge_ends[30][2] = {};
+
+		std::uint32_t edge_base = 0;
+		std::uint32_t face_base = 0;
+		std::uint32_t face_size = 0;
+	};
+
+	// Interleaves the lanes of x, y and z into four consecutive XMFLOAT3s.
+	void storeFloat3x4(XMFLOAT3* out, FXMVECTOR x, FXMVECTOR y, FXMVECTOR z)
+	{
+		XMVECTOR xy01 = XMVectorMergeXY(x, y);
+		XMVECTOR xy23 = XMVectorMergeZW(x, y);
+
+		XMVECTOR yz1 = XMVectorPermute<3, 5, 0, 0>(xy01, z);
+
+		XMFLOAT4* out_4 = reinterpret_cast<XMFLOAT4*>(out);
+
+		XMStoreFloat4(out_4 + 0, XMVectorPermute<0, 1, 4, 2>(xy01, z));
+		XMStoreFloat4(out_4 + 1, XMVectorPermute<0, 1, 4, 5>(yz1, xy23));
+		XMStoreFloat4(out_4 + 2, XMVectorPermute<6, 2, 3, 7>(xy23, z));
+	}
+
+	// Interleaves the lanes of u and v into four consecutive XMFLOAT2s.
+	void storeFloat2x4(XMFLOAT2* out, FXMVECTOR u, FXMVECTOR v)
+	{
+		XMFLOAT4* out_4 = reinterpret_cast<XMFLOAT4*>(out);
+
+		XMStoreFloat4(out_4 + 0, XMVectorMergeXY(u, v));
+		XMStoreFloat4(out_4 + 1, XMVectorMergeZW(u, v));
+	}
+
+	// cos and sin of j * d_theta for j in [0, count), padded to a multiple of 4.
+	void buildSinCosTable(
+		std::uint32_t count,
+		float d_theta,
+		std::vector<float>& cos_table,
+		std::vector<float>& sin_table)
+	{
+		std::uint32_t padded_count = (count + 3) & ~3u;
+
+		cos_table.resize(padded_count);
+		sin_table.resize(padded_count);
+
+		for (std::uint32_t j = 0; j < padded_count; j += 4)
+		{
+			XMVECTOR theta = XMVectorSet(
+				(float)(j + 0) * d_theta,
+				(float)(j + 1) * d_theta,
+				(float)(j + 2) * d_theta,
+				(float)(j + 3) * d_theta);
+
+			XMVECTOR s;
+			XMVECTOR c;
+			XMVectorSinCos(&s, &c, theta);
+
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&cos_table[j]), c);
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&sin_table[j]), s);
+		}
+	}
+}
+
 GeometryGenerator::MeshData GeometryGenerator::createBox(
 	float width,
 	float height,
 	float depth,
-	std::uint32_t n_subdivisions)
+	std::uint32_t n_subdivisions,
+	SubdivisionMode mode)
 {
 	MeshData mesh_data;
 
@@ -77,9 +382,11 @@ GeometryGenerator::MeshData GeometryGenerator::createBox(
 
 	for (std::uint32_t i = 0; i < n_subdivisions; ++i)
 	{
-		subdivide(mesh_data);
+		subdivide(mesh_data, mode);
 	}
 
+	computeBounds(mesh_data);
+
 	return mesh_data;
 }
 
@@ -90,85 +397,178 @@ GeometryGenerator::MeshData GeometryGenerator::createSphere(
 {
 	MeshData mesh_data;
 
-	Vertex top_vertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-	Vertex bottom_vertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	beginSphere(radius, slice_count, stack_count, mesh_data);
 
-	mesh_data.vertices.emplace_back(top_vertex);
+	for (std::uint32_t i = 1; i <= stack_count - 1; ++i)
+	{
+		buildSphereRing(radius, slice_count, stack_count, i, mesh_data);
+	}
 
-	float phi_step = XM_PI / stack_count;
-	float theta_step = 2.0f * XM_PI / slice_count;
+	buildSphereIndices(slice_count, stack_count, mesh_data.indices_32);
 
-	for (std::uint32_t i = 1; i <= stack_count - 1; ++i)
+	computeBounds(mesh_data);
+
+	return mesh_data;
+}
+
+GeometryGenerator::MeshData GeometryGenerator::createSphere(
+	float radius,
+	std::uint32_t slice_count,
+	std::uint32_t stack_count,
+	ThreadPool& thread_pool)
+{
+	MeshData mesh_data;
+
+	beginSphere(radius, slice_count, stack_count, mesh_data);
+
+	thread_pool.parallelFor(stack_count - 1, [&](std::uint32_t begin, std::uint32_t end)
 	{
-		float phi = i * phi_step;
+		for (std::uint32_t i = begin; i < end; ++i)
+		{
+			buildSphereRing(radius, slice_count, stack_count, i + 1, mesh_data);
+		}
+	});
 
-		for (std::uint32_t j = 0; j <= slice_count; ++j)
+	mesh_data.indices_32.resize(sphereIndexCount(slice_count, stack_count));
+
+	thread_pool.parallelFor(stack_count, [&](std::uint32_t begin, std::uint32_t end)
+	{
+		for (std::uint32_t band = begin; band < end; ++band)
 		{
-			float theta = j * theta_step;
+			buildSphereIndexBand(slice_count, stack_count, band, mesh_data.indices_32);
+		}
+	});
 
-			Vertex v;
+	computeBounds(mesh_data);
 
-			// spherical to cartesian
-			v.position.x = radius * sinf(phi) * cosf(theta);
-			v.position.y = radius * cosf(phi);
-			v.position.z = radius * sinf(phi) * sinf(theta);
+	return mesh_data;
+}
+
+void GeometryGenerator::beginSphere(
+	float radius,
+	std::uint32_t slice_count,
+	std::uint32_t stack_count,
+	MeshData& mesh_data)
+{
+	mesh_data.vertices.resize(2 + (stack_count - 1) * (slice_count + 1));
 
-			// Partial derivative of P with respect to theta
-			v.tangent_u.x = -radius * sinf(phi) * sinf(theta);
-			v.tangent_u.y = 0.0f;
-			v.tangent_u.z = +radius * sinf(phi) * cosf(theta);
+	mesh_data.vertices.front() = Vertex(0.0f, +radius, 0.0f, 0.0f, +1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	mesh_data.vertices.back() = Vertex(0.0f, -radius, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+}
 
-			XMVECTOR t = XMLoadFloat3(&v.tangent_u);
-			XMStoreFloat3(&v.tangent_u, XMVector3Normalize(t));
+void GeometryGenerator::buildSphereRing(
+	float radius,
+	std::uint32_t slice_count,
+	std::uint32_t stack_count,
+	std::uint32_t ring,
+	MeshData& mesh_data)
+{
+	float phi_step = XM_PI / stack_count;
+	float theta_step = 2.0f * XM_PI / slice_count;
 
-			XMVECTOR p = XMLoadFloat3(&v.position);
-			XMStoreFloat3(&v.normal, XMVector3Normalize(p));
+	float phi = ring * phi_step;
 
-			v.tex_c.x = theta / XM_2PI;
-			v.tex_c.y = phi / XM_PI;
+	Vertex* ring_vertices = &mesh_data.vertices[1 + (ring - 1) * (slice_count + 1)];
 
-			mesh_data.vertices.push_back(v);
-		}
+	for (std::uint32_t j = 0; j <= slice_count; ++j)
+	{
+		float theta = j * theta_step;
+
+		Vertex& v = ring_vertices[j];
+
+		// spherical to cartesian
+		v.position.x = radius * sinf(phi) * cosf(theta);
+		v.position.y = radius * cosf(phi);
+		v.position.z = radius * sinf(phi) * sinf(theta);
+
+		// Partial derivative of P with respect to theta
+		v.tangent_u.x = -radius * sinf(phi) * sinf(theta);
+		v.tangent_u.y = 0.0f;
+		v.tangent_u.z = +radius * sinf(phi) * cosf(theta);
+
+		XMVECTOR t = XMLoadFloat3(&v.tangent_u);
+		XMStoreFloat3(&v.tangent_u, XMVector3Normalize(t));
+
+		XMVECTOR p = XMLoadFloat3(&v.position);
+		XMStoreFloat3(&v.normal, XMVector3Normalize(p));
+
+		v.tex_c.x = theta / XM_2PI;
+		v.tex_c.y = phi / XM_PI;
 	}
+}
+
+std::size_t GeometryGenerator::sphereIndexCount(
+	std::uint32_t slice_count,
+	std::uint32_t stack_count)
+{
+	return 6 * (std::size_t)slice_count * (stack_count - 1);
+}
 
-	mesh_data.vertices.push_back(bottom_vertex);
+void GeometryGenerator::buildSphereIndices(
+	std::uint32_t slice_count,
+	std::uint32_t stack_count,
+	std::vector<std::uint32_t>& indices)
+{
+	indices.resize(sphereIndexCount(slice_count, stack_count));
 
-	for (std::uint32_t i = 1; i <= slice_count; ++i)
+	for (std::uint32_t band = 0; band < stack_count; ++band)
 	{
-		mesh_data.indices_32.push_back(0);
-		mesh_data.indices_32.push_back(i + 1);
-		mesh_data.indices_32.push_back(i);
+		buildSphereIndexBand(slice_count, stack_count, band, indices);
 	}
+}
 
-	std::uint32_t base_index = 1;
+void GeometryGenerator::buildSphereIndexBand(
+	std::uint32_t slice_count,
+	std::uint32_t stack_count,
+	std::uint32_t band,
+	std::vector<std::uint32_t>& indices)
+{
+	// Band 0 is the north pole fan, band stack_count - 1 the south pole fan
+	// and the bands in between are quads joining two rings.
 	std::uint32_t ring_vertex_count = slice_count + 1;
-	for (std::uint32_t i = 0; i < stack_count - 2; ++i)
+	std::uint32_t south_pole_index = 1 + (stack_count - 1) * ring_vertex_count;
+
+	std::uint32_t* out = band == 0 ?
+		&indices[0] :
+		&indices[3 * (std::size_t)slice_count + 6 * (std::size_t)slice_count * (band - 1)];
+
+	if (band == 0)
 	{
-		for (std::uint32_t j = 0; j < slice_count; ++j)
+		for (std::uint32_t i = 1; i <= slice_count; ++i)
 		{
-			mesh_data.indices_32.push_back(base_index + i * ring_vertex_count + j);
-			mesh_data.indices_32.push_back(base_index + i * ring_vertex_count + j + 1);
-			mesh_data.indices_32.push_back(base_index + (i + 1) * ring_vertex_count + j);
-
-			mesh_data.indices_32.push_back(base_index + (i + 1) * ring_vertex_count + j);
-			mesh_data.indices_32.push_back(base_index + i * ring_vertex_count + j + 1);
-			mesh_data.indices_32.push_back(base_index + (i + 1) * ring_vertex_count + j + 1);
+			*out++ = 0;
+			*out++ = i + 1;
+			*out++ = i;
 		}
 	}
+	else if (band == stack_count - 1)
+	{
+		// Offset the indices to the index of the first vertex in the last ring.
+		std::uint32_t base_index = south_pole_index - ring_vertex_count;
 
-	std::uint32_t south_pole_index = (std::uint32_t)mesh_data.vertices.size() - 1;
+		for (std::uint32_t i = 0; i < slice_count; ++i)
+		{
+			*out++ = south_pole_index;
+			*out++ = base_index + i;
+			*out++ = base_index + i + 1;
+		}
+	}
+	else
+	{
+		std::uint32_t base_index = 1;
+		std::uint32_t i = band - 1;
 
-	// Offset the indices to the index of the first vertex in the last ring.
-	base_index = south_pole_index - ring_vertex_count;
+		for (std::uint32_t j = 0; j < slice_count; ++j)
+		{
+			*out++ = base_index + i * ring_vertex_count + j;
+			*out++ = base_index + i * ring_vertex_count + j + 1;
+			*out++ = base_index + (i + 1) * ring_vertex_count + j;
 
-	for (std::uint32_t i = 0; i < slice_count; ++i)
-	{
-		mesh_data.indices_32.push_back(south_pole_index);
-		mesh_data.indices_32.push_back(base_index + i);
-		mesh_data.indices_32.push_back(base_index + i + 1);
+			*out++ = base_index + (i + 1) * ring_vertex_count + j;
+			*out++ = base_index + i * ring_vertex_count + j + 1;
+			*out++ = base_index + (i + 1) * ring_vertex_count + j + 1;
+		}
 	}
-
-	return mesh_data;
 }
 
 void GeometryGenerator::subdivide(MeshData& mesh_data)
@@ -216,6 +616,120 @@ void GeometryGenerator::subdivide(MeshData& mesh_data)
 	}
 }
 
+void GeometryGenerator::subdivideWelded(MeshData& mesh_data)
+{
+	// Every edge (i0, i1) is keyed as the sorted pair in an open addressing
+	// table, so triangles sharing an edge also share its midpoint vertex.
+	std::uint64_t const empty_key = ~0ull;
+
+	std::uint32_t n_indices = (std::uint32_t)mesh_data.indices_32.size();
+	std::uint32_t n_tris = n_indices / 3;
+	std::uint32_t n_vertices = (std::uint32_t)mesh_data.vertices.size();
+
+	// An open mesh has up to 3 edges per triangle; keep the load factor <= 0.5.
+	std::uint32_t capacity = 1;
+	while (capacity < 2 * n_indices)
+		capacity <<= 1;
+
+	std::vector<std::uint64_t> keys(capacity, empty_key);
+	std::vector<std::uint32_t> values(capacity);
+
+	std::uint32_t mask = capacity - 1;
+	std::uint32_t n_edges = 0;
+
+	auto findSlot = [&](std::uint32_t a, std::uint32_t b)
+	{
+		std::uint64_t key = a < b ?
+			((std::uint64_t)a << 32) | b :
+			((std::uint64_t)b << 32) | a;
+
+		std::uint32_t slot = (std::uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+
+		while (keys[slot] != empty_key && keys[slot] != key)
+			slot = (slot + 1) & mask;
+
+		if (keys[slot] == empty_key)
+		{
+			keys[slot] = key;
+			values[slot] = n_vertices + n_edges++;
+		}
+
+		return slot;
+	};
+
+	// Midpoint slots per triangle edge: (v0, v1), (v1, v2), (v0, v2).
+	std::vector<std::uint32_t> midpoints(n_indices);
+
+	for (std::uint32_t i = 0; i < n_tris; ++i)
+	{
+		std::uint32_t i0 = mesh_data.indices_32[i * 3 + 0];
+		std::uint32_t i1 = mesh_data.indices_32[i * 3 + 1];
+		std::uint32_t i2 = mesh_data.indices_32[i * 3 + 2];
+
+		midpoints[i * 3 + 0] = values[findSlot(i0, i1)];
+		midpoints[i * 3 + 1] = values[findSlot(i1, i2)];
+		midpoints[i * 3 + 2] = values[findSlot(i0, i2)];
+	}
+
+	mesh_data.vertices.resize(n_vertices + n_edges);
+
+	for (std::uint32_t slot = 0; slot < capacity; ++slot)
+	{
+		if (keys[slot] == empty_key)
+			continue;
+
+		std::uint32_t a = (std::uint32_t)(keys[slot] >> 32);
+		std::uint32_t b = (std::uint32_t)(keys[slot] & 0xFFFFFFFFu);
+
+		mesh_data.vertices[values[slot]] = midPoint(mesh_data.vertices[a], mesh_data.vertices[b]);
+	}
+
+	// Expand the index buffer in place, back to front, so no triangle is
+	// overwritten before it has been read.
+	mesh_data.indices_32.resize(4 * (std::size_t)n_indices);
+
+	for (std::uint32_t i = n_tris; i-- > 0;)
+	{
+		std::uint32_t i0 = mesh_data.indices_32[i * 3 + 0];
+		std::uint32_t i1 = mesh_data.indices_32[i * 3 + 1];
+		std::uint32_t i2 = mesh_data.indices_32[i * 3 + 2];
+
+		std::uint32_t m0 = midpoints[i * 3 + 0];
+		std::uint32_t m1 = midpoints[i * 3 + 1];
+		std::uint32_t m2 = midpoints[i * 3 + 2];
+
+		std::uint32_t* out = &mesh_data.indices_32[i * 12];
+
+		out[0] = i0;
+		out[1] = m0;
+		out[2] = m2;
+
+		out[3] = m0;
+		out[4] = m1;
+		out[5] = m2;
+
+		out[6] = m2;
+		out[7] = m1;
+		out[8] = i2;
+
+		out[9] = m0;
+		out[10] = i1;
+		out[11] = m1;
+	}
+}
+
+void GeometryGenerator::subdivide(MeshData& mesh_data, SubdivisionMode mode)
+{
+	if (mode == SubdivisionMode::Welded)
+	{
+		subdivideWelded(mesh_data);
+	}
+	else
+	{
+		subdivide(mesh_data);
+	}
+}
+
 GeometryGenerator::Vertex GeometryGenerator::midPoint(
 	Vertex const& v0,
 	Vertex const& v1)
@@ -248,62 +762,105 @@ GeometryGenerator::Vertex GeometryGenerator::midPoint(
 
 GeometryGenerator::MeshData GeometryGenerator::createGeosphere(
 	float radius,
-	std::uint32_t n_subdivisions)
+	std::uint32_t n_subdivisions,
+	SubdivisionMode mode)
 {
 	MeshData mesh_data;
 
 	n_subdivisions = std::min<std::uint32_t>(n_subdivisions, 6u);
 
-	float const x = 0.525731f;
-	float const z = 0.850651f;
+	mesh_data.vertices.resize(12);
+	mesh_data.indices_32.assign(&icosahedron_indices[0], &icosahedron_indices[60]);
+
+	for (std::uint32_t i = 0; i < 12; ++i)
+		mesh_data.vertices[i].position = icosahedron_positions[i];
+
+	for (std::uint32_t i = 0; i < n_subdivisions; ++i)
+		subdivide(mesh_data, mode);
+
+	projectOntoSphere(radius, mesh_data);
 
-	XMFLOAT3 pos[12] =
+	computeBounds(mesh_data);
+
+	return mesh_data;
+}
+
+GeometryGenerator::MeshData GeometryGenerator::createGeosphereDirect(
+	float radius,
+	std::uint32_t n_subdivisions)
+{
+	MeshData mesh_data;
+
+	n_subdivisions = std::min<std::uint32_t>(n_subdivisions, 12u);
+
+	GeosphereLattice lattice(n_subdivisions);
+
+	// Number the lattice the way repeated welded subdivision would: level L
+	// midpoints follow the level L - 1 vertices, in order of first use.
+	std::vector<std::uint32_t> ids(lattice.vertexCount(), ~0u);
+
+	for (std::uint32_t i = 0; i < 12; ++i)
+		ids[i] = i;
+
+	std::uint32_t next_id = 12;
+
+	for (std::uint32_t level = 0; level < n_subdivisions; ++level)
 	{
-		XMFLOAT3(-x, 0.0f, z),  XMFLOAT3(x, 0.0f, z),
-		XMFLOAT3(-x, 0.0f, -z), XMFLOAT3(x, 0.0f, -z),
-		XMFLOAT3(0.0f, z, x),   XMFLOAT3(0.0f, z, -x),
-		XMFLOAT3(0.0f, -z, x),  XMFLOAT3(0.0f, -z, -x),
-		XMFLOAT3(z, x, 0.0f),   XMFLOAT3(-z, x, 0.0f),
-		XMFLOAT3(z, -x, 0.0f),  XMFLOAT3(-z, -x, 0.0f)
-	};
+		lattice.forEachTriangle(level, [&](
+			std::uint32_t face,
+			GeosphereLattice::Point a,
+			GeosphereLattice::Point b,
+			GeosphereLattice::Point c)
+		{
+			std::uint32_t m0 = lattice.index(face, GeosphereLattice::midPoint(a, b));
+			std::uint32_t m1 = lattice.index(face, GeosphereLattice::midPoint(b, c));
+			std::uint32_t m2 = lattice.index(face, GeosphereLattice::midPoint(a, c));
+
+			if (ids[m0] == ~0u)
+				ids[m0] = next_id++;
 
-	std::uint32_t k[60] =
+			if (ids[m1] == ~0u)
+				ids[m1] = next_id++;
+
+			if (ids[m2] == ~0u)
+				ids[m2] = next_id++;
+		});
+	}
+
+	mesh_data.vertices.resize(lattice.vertexCount());
+
+	lattice.forEachVertex([&](std::uint32_t index, XMFLOAT3 const& position)
 	{
-		1, 4, 0,
-		4, 9, 0,
-		4, 5, 9,
-		8, 5, 4,
-		1, 8, 4,
+		mesh_data.vertices[ids[index]].position = position;
+	});
 
-		1, 10, 8,
-		0, 3, 8,
-		8, 3, 5,
-		3, 2, 5,
-		3, 7, 2,
+	mesh_data.indices_32.resize(lattice.triangleCount(n_subdivisions) * 3);
 
-		3, 10, 7,
-		10, 6, 7,
-		6, 11, 7,
-		6, 0, 11,
-		6, 1, 0,
+	std::size_t k = 0;
 
-		10, 1, 6,
-		11, 0, 9,
-		2, 11, 9,
-		5, 2, 9,
-		11, 2, 7
-	};
+	lattice.forEachTriangle(n_subdivisions, [&](
+		std::uint32_t face,
+		GeosphereLattice::Point a,
+		GeosphereLattice::Point b,
+		GeosphereLattice::Point c)
+	{
+		mesh_data.indices_32[k + 0] = ids[lattice.index(face, a)];
+		mesh_data.indices_32[k + 1] = ids[lattice.index(face, b)];
+		mesh_data.indices_32[k + 2] = ids[lattice.index(face, c)];
 
-	mesh_data.vertices.resize(12);
-	mesh_data.indices_32.assign(&k[0], &k[60]);
+		k += 3;
+	});
 
-	for (std::uint32_t i = 0; i < 12; ++i)
-		mesh_data.vertices[i].position = pos[i];
+	projectOntoSphere(radius, mesh_data);
 
-	for (std::uint32_t i = 0; i < n_subdivisions; ++i)
-		subdivide(mesh_data);
+	computeBounds(mesh_data);
 
-	for (std::uint32_t i = 0; i < mesh_data.vertices.size(); ++i)
+	return mesh_data;
+}
+
+void GeometryGenerator::projectOntoSphere(float radius, MeshData& mesh_data)
+{
+	for (std::size_t i = 0; i < mesh_data.vertices.size(); ++i)
 	{
 		XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&mesh_data.vertices[i].position));
 		XMVECTOR p = radius * n;
@@ -330,8 +887,6 @@ GeometryGenerator::MeshData GeometryGenerator::createGeosphere(
 		XMVECTOR T = XMLoadFloat3(&mesh_data.vertices[i].tangent_u);
 		XMStoreFloat3(&mesh_data.vertices[i].tangent_u, XMVector3Normalize(T));
 	}
-
-	return mesh_data;
 }
 
 GeometryGenerator::MeshData GeometryGenerator::createCylinder(
@@ -381,26 +936,36 @@ GeometryGenerator::MeshData GeometryGenerator::createCylinder(
 		}
 	}
 
+	buildCylinderSideIndices(slice_count, stack_count, mesh_data.indices_32);
+
+	buildCylinderTopCap(bottom_radius, top_radius, height, slice_count, stack_count, mesh_data);
+	buildCylinderBottomCap(bottom_radius, top_radius, height, slice_count, stack_count, mesh_data);
+
+	computeBounds(mesh_data);
+
+	return mesh_data;
+}
+
+void GeometryGenerator::buildCylinderSideIndices(
+	std::uint32_t slice_count,
+	std::uint32_t stack_count,
+	std::vector<std::uint32_t>& indices)
+{
 	std::uint32_t ring_vertex_count = slice_count + 1;
 
 	for (std::uint32_t i = 0; i < stack_count; ++i)
 	{
 		for (std::uint32_t j = 0; j < slice_count; ++j)
 		{
-			mesh_data.indices_32.push_back(i * ring_vertex_count + j);
-			mesh_data.indices_32.push_back((i + 1) * ring_vertex_count + j);
-			mesh_data.indices_32.push_back((i + 1) * ring_vertex_count + j + 1);
+			indices.push_back(i * ring_vertex_count + j);
+			indices.push_back((i + 1) * ring_vertex_count + j);
+			indices.push_back((i + 1) * ring_vertex_count + j + 1);
 
-			mesh_data.indices_32.push_back(i * ring_vertex_count + j);
-			mesh_data.indices_32.push_back((i + 1) * ring_vertex_count + j + 1);
-			mesh_data.indices_32.push_back(i * ring_vertex_count + j + 1);
+			indices.push_back(i * ring_vertex_count + j);
+			indices.push_back((i + 1) * ring_vertex_count + j + 1);
+			indices.push_back(i * ring_vertex_count + j + 1);
 		}
 	}
-
-	buildCylinderTopCap(bottom_radius, top_radius, height, slice_count, stack_count, mesh_data);
-	buildCylinderBottomCap(bottom_radius, top_radius, height, slice_count, stack_count, mesh_data);
-
-	return mesh_data;
 }
 
 void GeometryGenerator::buildCylinderTopCap(
@@ -483,9 +1048,58 @@ GeometryGenerator::MeshData GeometryGenerator::createGrid(
 {
 	MeshData mesh_data;
 
-	std::uint32_t vertex_count = m * n;
-	std::uint32_t face_count = (m - 1) * (n - 1) * 2;
+	mesh_data.vertices.resize(m * n);
+
+	for (std::uint32_t i = 0; i < m; ++i)
+	{
+		buildGridRow(width, depth, m, n, i, mesh_data);
+	}
+
+	buildGridIndices(m, n, mesh_data.indices_32);
+
+	computeBounds(mesh_data);
+
+	return mesh_data;
+}
+
+GeometryGenerator::MeshData GeometryGenerator::createGrid(
+	float width,
+	float depth,
+	std::uint32_t m,
+	std::uint32_t n,
+	ThreadPool& thread_pool)
+{
+	MeshData mesh_data;
+
+	mesh_data.vertices.resize(m * n);
+	mesh_data.indices_32.resize(gridIndexCount(m, n));
 
+	thread_pool.parallelFor(m, [&](std::uint32_t begin, std::uint32_t end)
+	{
+		for (std::uint32_t i = begin; i < end; ++i)
+		{
+			buildGridRow(width, depth, m, n, i, mesh_data);
+
+			if (i < m - 1)
+			{
+				buildGridIndexRow(n, i, mesh_data.indices_32);
+			}
+		}
+	});
+
+	computeBounds(mesh_data);
+
+	return mesh_data;
+}
+
+void GeometryGenerator::buildGridRow(
+	float width,
+	float depth,
+	std::uint32_t m,
+	std::uint32_t n,
+	std::uint32_t i,
+	MeshData& mesh_data)
+{
 	float half_width = 0.5f * width;
 	float half_depth = 0.5f * depth;
 
@@ -495,46 +1109,58 @@ GeometryGenerator::MeshData GeometryGenerator::createGrid(
 	float du = 1.0f / (n - 1);
 	float dv = 1.0f / (m - 1);
 
-	mesh_data.vertices.resize(vertex_count);
+	float z = half_depth - i * dz;
 
-	for (std::uint32_t i = 0; i < m; ++i)
+	for (std::uint32_t j = 0; j < n; ++j)
 	{
-		float z = half_depth - i * dz;
-
-		for (std::uint32_t j = 0; j < n; ++j)
-		{
-			float x = -half_width + j * dx;
+		float x = -half_width + j * dx;
 
-			mesh_data.vertices[i * n + j].position = XMFLOAT3(x, 0.0f, z);
-			mesh_data.vertices[i * n + j].normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
-			mesh_data.vertices[i * n + j].tangent_u= XMFLOAT3(1.0f, 0.0f, 0.0f);
+		mesh_data.vertices[i * n + j].position = XMFLOAT3(x, 0.0f, z);
+		mesh_data.vertices[i * n + j].normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+		mesh_data.vertices[i * n + j].tangent_u= XMFLOAT3(1.0f, 0.0f, 0.0f);
 
-			mesh_data.vertices[i * n + j].tex_c.x = j * du;
-			mesh_data.vertices[i * n + j].tex_c.y = i * dv;
-		}
+		mesh_data.vertices[i * n + j].tex_c.x = j * du;
+		mesh_data.vertices[i * n + j].tex_c.y = i * dv;
 	}
+}
 
-	mesh_data.indices_32.resize(face_count * 3);
+std::size_t GeometryGenerator::gridIndexCount(std::uint32_t m, std::uint32_t n)
+{
+	return 6 * (std::size_t)(m - 1) * (n - 1);
+}
 
-	std::uint32_t k = 0;
+void GeometryGenerator::buildGridIndices(
+	std::uint32_t m,
+	std::uint32_t n,
+	std::vector<std::uint32_t>& indices)
+{
+	indices.resize(gridIndexCount(m, n));
 
 	for (std::uint32_t i = 0; i < m - 1; ++i)
 	{
-		for (std::uint32_t j = 0; j < n - 1; ++j)
-		{
-			mesh_data.indices_32[k] = i * n + j;
-			mesh_data.indices_32[k + 1] = i * n + j + 1;
-			mesh_data.indices_32[k + 2] = (i + 1) * n + j;
+		buildGridIndexRow(n, i, indices);
+	}
+}
 
-			mesh_data.indices_32[k + 3] = (i + 1) * n + j;
-			mesh_data.indices_32[k + 4] = i * n + j + 1;
-			mesh_data.indices_32[k + 5] = (i + 1) * n + j + 1;
+void GeometryGenerator::buildGridIndexRow(
+	std::uint32_t n,
+	std::uint32_t i,
+	std::vector<std::uint32_t>& indices)
+{
+	std::size_t k = 6 * (std::size_t)i * (n - 1);
 
-			k += 6;
-		}
-	}
+	for (std::uint32_t j = 0; j < n - 1; ++j)
+	{
+		indices[k] = i * n + j;
+		indices[k + 1] = i * n + j + 1;
+		indices[k + 2] = (i + 1) * n + j;
 
-	return mesh_data;
+		indices[k + 3] = (i + 1) * n + j;
+		indices[k + 4] = i * n + j + 1;
+		indices[k + 5] = (i + 1) * n + j + 1;
+
+		k += 6;
+	}
 }
 
 GeometryGenerator::MeshData GeometryGenerator::createQuad(
@@ -581,5 +1207,328 @@ GeometryGenerator::MeshData GeometryGenerator::createQuad(
 	mesh_data.indices_32[4] = 2;
 	mesh_data.indices_32[5] = 3;
 
+	computeBounds(mesh_data);
+
+	return mesh_data;
+}
+
+GeometryGenerator::MeshDataSoA GeometryGenerator::createSphereSoA(
+	float radius,
+	std::uint32_t slice_count,
+	std::uint32_t stack_count)
+{
+	MeshDataSoA mesh_data;
+
+	std::uint32_t ring_vertex_count = slice_count + 1;
+	std::uint32_t vertex_count = 2 + (stack_count - 1) * ring_vertex_count;
+
+	mesh_data.resize(vertex_count);
+
+	float phi_step = XM_PI / stack_count;
+	float theta_step = 2.0f * XM_PI / slice_count;
+
+	// Every ring shares the same slice angles, so the trigonometry along
+	// theta is evaluated once instead of once per vertex.
+	std::vector<float> cos_theta;
+	std::vector<float> sin_theta;
+	buildSinCosTable(ring_vertex_count, theta_step, cos_theta, sin_theta);
+
+	mesh_data.positions[0] = XMFLOAT3(0.0f, +radius, 0.0f);
+	mesh_data.normals[0] = XMFLOAT3(0.0f, +1.0f, 0.0f);
+	mesh_data.tangents_u[0] = XMFLOAT3(1.0f, 0.0f, 0.0f);
+	mesh_data.tex_cs[0] = XMFLOAT2(0.0f, 0.0f);
+
+	XMVECTOR zero = XMVectorZero();
+	XMVECTOR lane = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+	XMVECTOR u_step = XMVectorReplicate(theta_step / XM_2PI);
+
+	for (std::uint32_t i = 1; i <= stack_count - 1; ++i)
+	{
+		float phi = i * phi_step;
+		float sin_phi = sinf(phi);
+		float cos_phi = cosf(phi);
+
+		XMVECTOR r_sin_phi = XMVectorReplicate(radius * sin_phi);
+		XMVECTOR v_sin_phi = XMVectorReplicate(sin_phi);
+		XMVECTOR y = XMVectorReplicate(radius * cos_phi);
+		XMVECTOR n_y = XMVectorReplicate(cos_phi);
+		XMVECTOR v = XMVectorReplicate(phi / XM_PI);
+
+		std::uint32_t base = 1 + (i - 1) * ring_vertex_count;
+		std::uint32_t j = 0;
+
+		for (; j + 4 <= ring_vertex_count; j += 4)
+		{
+			XMVECTOR c = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const*>(&cos_theta[j]));
+			XMVECTOR s = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const*>(&sin_theta[j]));
+			XMVECTOR u = (XMVectorReplicate((float)j) + lane) * u_step;
+
+			storeFloat3x4(&mesh_data.positions[base + j], r_sin_phi * c, y, r_sin_phi * s);
+			storeFloat3x4(&mesh_data.normals[base + j], v_sin_phi * c, n_y, v_sin_phi * s);
+			storeFloat3x4(&mesh_data.tangents_u[base + j], -s, zero, c);
+			storeFloat2x4(&mesh_data.tex_cs[base + j], u, v);
+		}
+
+		for (; j < ring_vertex_count; ++j)
+		{
+			float c = cos_theta[j];
+			float s = sin_theta[j];
+
+			mesh_data.positions[base + j] = XMFLOAT3(radius * sin_phi * c, radius * cos_phi, radius * sin_phi * s);
+			mesh_data.normals[base + j] = XMFLOAT3(sin_phi * c, cos_phi, sin_phi * s);
+			mesh_data.tangents_u[base + j] = XMFLOAT3(-s, 0.0f, c);
+			mesh_data.tex_cs[base + j] = XMFLOAT2(j * theta_step / XM_2PI, phi / XM_PI);
+		}
+	}
+
+	mesh_data.positions[vertex_count - 1] = XMFLOAT3(0.0f, -radius, 0.0f);
+	mesh_data.normals[vertex_count - 1] = XMFLOAT3(0.0f, -1.0f, 0.0f);
+	mesh_data.tangents_u[vertex_count - 1] = XMFLOAT3(1.0f, 0.0f, 0.0f);
+	mesh_data.tex_cs[vertex_count - 1] = XMFLOAT2(0.0f, 1.0f);
+
+	buildSphereIndices(slice_count, stack_count, mesh_data.indices_32);
+
+	computeBounds(mesh_data);
+
+	return mesh_data;
+}
+
+GeometryGenerator::MeshDataSoA GeometryGenerator::createCylinderSoA(
+	float bottom_radius,
+	float top_radius,
+	float height,
+	std::uint32_t slice_count,
+	std::uint32_t stack_count)
+{
+	MeshDataSoA mesh_data;
+
+	float stack_height = height / stack_count;
+	float radius_step = (top_radius - bottom_radius) / stack_count;
+
+	std::uint32_t ring_count = stack_count + 1;
+	std::uint32_t ring_vertex_count = slice_count + 1;
+
+	std::uint32_t side_vertex_count = ring_count * ring_vertex_count;
+	std::uint32_t cap_vertex_count = ring_vertex_count + 1;
+
+	mesh_data.resize(side_vertex_count + 2 * cap_vertex_count);
+
+	float d_theta = 2.0f * XM_PI / slice_count;
+
+	std::vector<float> cos_theta;
+	std::vector<float> sin_theta;
+	buildSinCosTable(ring_vertex_count, d_theta, cos_theta, sin_theta);
+
+	// T x B with T = (-s, 0, c) and B = (dr * c, -height, dr * s) is
+	// (height * c, dr, height * s), whose length is the same for every vertex.
+	float dr = bottom_radius - top_radius;
+	float inv_length = 1.0f / sqrtf(height * height + dr * dr);
+
+	XMVECTOR zero = XMVectorZero();
+	XMVECTOR lane = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+	XMVECTOR u_step = XMVectorReplicate(1.0f / slice_count);
+	XMVECTOR n_xz = XMVectorReplicate(height * inv_length);
+	XMVECTOR n_y = XMVectorReplicate(dr * inv_length);
+
+	for (std::uint32_t i = 0; i < ring_count; ++i)
+	{
+		float y = -0.5f * height + i * stack_height;
+		float r = bottom_radius + i * radius_step;
+
+		XMVECTOR v_y = XMVectorReplicate(y);
+		XMVECTOR v_r = XMVectorReplicate(r);
+		XMVECTOR v = XMVectorReplicate(1.0f - (float)i / stack_count);
+
+		std::uint32_t base = i * ring_vertex_count;
+		std::uint32_t j = 0;
+
+		for (; j + 4 <= ring_vertex_count; j += 4)
+		{
+			XMVECTOR c = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const*>(&cos_theta[j]));
+			XMVECTOR s = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const*>(&sin_theta[j]));
+			XMVECTOR u = (XMVectorReplicate((float)j) + lane) * u_step;
+
+			storeFloat3x4(&mesh_data.positions[base + j], v_r * c, v_y, v_r * s);
+			storeFloat3x4(&mesh_data.normals[base + j], n_xz * c, n_y, n_xz * s);
+			storeFloat3x4(&mesh_data.tangents_u[base + j], -s, zero, c);
+			storeFloat2x4(&mesh_data.tex_cs[base + j], u, v);
+		}
+
+		for (; j < ring_vertex_count; ++j)
+		{
+			float c = cos_theta[j];
+			float s = sin_theta[j];
+
+			mesh_data.positions[base + j] = XMFLOAT3(r * c, y, r * s);
+			mesh_data.normals[base + j] = XMFLOAT3(height * inv_length * c, dr * inv_length, height * inv_length * s);
+			mesh_data.tangents_u[base + j] = XMFLOAT3(-s, 0.0f, c);
+			mesh_data.tex_cs[base + j] = XMFLOAT2((float)j / slice_count, 1.0f - (float)i / stack_count);
+		}
+	}
+
+	buildCylinderSideIndices(slice_count, stack_count, mesh_data.indices_32);
+
+	buildCylinderCapSoA(top_radius, height, true, slice_count, side_vertex_count, mesh_data);
+	buildCylinderCapSoA(bottom_radius, height, false, slice_count, side_vertex_count + cap_vertex_count, mesh_data);
+
+	computeBounds(mesh_data);
+
 	return mesh_data;
 }
+
+void GeometryGenerator::buildCylinderCapSoA(
+	float radius,
+	float height,
+	bool top,
+	std::uint32_t slice_count,
+	std::uint32_t base_index,
+	MeshDataSoA& mesh_data)
+{
+	float y = top ? 0.5f * height : -0.5f * height;
+	float n_y = top ? 1.0f : -1.0f;
+	float d_theta = 2.0f * XM_PI / slice_count;
+
+	for (std::uint32_t i = 0; i <= slice_count; ++i)
+	{
+		float x = radius * cosf(i * d_theta);
+		float z = radius * sinf(i * d_theta);
+
+		mesh_data.positions[base_index + i] = XMFLOAT3(x, y, z);
+		mesh_data.normals[base_index + i] = XMFLOAT3(0.0f, n_y, 0.0f);
+		mesh_data.tangents_u[base_index + i] = XMFLOAT3(1.0f, 0.0f, 0.0f);
+		mesh_data.tex_cs[base_index + i] = XMFLOAT2(x / height + 0.5f, z / height + 0.5f);
+	}
+
+	std::uint32_t center_index = base_index + slice_count + 1;
+
+	mesh_data.positions[center_index] = XMFLOAT3(0.0f, y, 0.0f);
+	mesh_data.normals[center_index] = XMFLOAT3(0.0f, n_y, 0.0f);
+	mesh_data.tangents_u[center_index] = XMFLOAT3(1.0f, 0.0f, 0.0f);
+	mesh_data.tex_cs[center_index] = XMFLOAT2(0.5f, 0.5f);
+
+	for (std::uint32_t i = 0; i < slice_count; ++i)
+	{
+		mesh_data.indices_32.push_back(center_index);
+		mesh_data.indices_32.push_back(base_index + (top ? i + 1 : i));
+		mesh_data.indices_32.push_back(base_index + (top ? i : i + 1));
+	}
+}
+
+GeometryGenerator::MeshDataSoA GeometryGenerator::createGridSoA(
+	float width,
+	float depth,
+	std::uint32_t m,
+	std::uint32_t n)
+{
+	MeshDataSoA mesh_data;
+
+	mesh_data.resize(m * n);
+
+	float half_width = 0.5f * width;
+	float half_depth = 0.5f * depth;
+
+	float dx = width / (n - 1);
+	float dz = depth / (m - 1);
+
+	float du = 1.0f / (n - 1);
+	float dv = 1.0f / (m - 1);
+
+	std::fill(mesh_data.normals.begin(), mesh_data.normals.end(), XMFLOAT3(0.0f, 1.0f, 0.0f));
+	std::fill(mesh_data.tangents_u.begin(), mesh_data.tangents_u.end(), XMFLOAT3(1.0f, 0.0f, 0.0f));
+
+	XMVECTOR zero = XMVectorZero();
+	XMVECTOR lane = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+	XMVECTOR v_dx = XMVectorReplicate(dx);
+	XMVECTOR v_du = XMVectorReplicate(du);
+	XMVECTOR x_0 = XMVectorReplicate(-half_width);
+
+	for (std::uint32_t i = 0; i < m; ++i)
+	{
+		float z = half_depth - i * dz;
+
+		XMVECTOR v_z = XMVectorReplicate(z);
+		XMVECTOR v = XMVectorReplicate(i * dv);
+
+		std::uint32_t base = i * n;
+		std::uint32_t j = 0;
+
+		for (; j + 4 <= n; j += 4)
+		{
+			XMVECTOR column = XMVectorReplicate((float)j) + lane;
+
+			storeFloat3x4(&mesh_data.positions[base + j], x_0 + column * v_dx, zero, v_z);
+			storeFloat2x4(&mesh_data.tex_cs[base + j], column * v_du, v);
+		}
+
+		for (; j < n; ++j)
+		{
+			mesh_data.positions[base + j] = XMFLOAT3(-half_width + j * dx, 0.0f, z);
+			mesh_data.tex_cs[base + j] = XMFLOAT2(j * du, i * dv);
+		}
+	}
+
+	buildGridIndices(m, n, mesh_data.indices_32);
+
+	computeBounds(mesh_data);
+
+	return mesh_data;
+}
+
+GeometryGenerator::MeshData GeometryGenerator::merge(
+	std::vector<MeshData const*> const& meshes,
+	std::vector<SubmeshRange>& submeshes)
+{
+	MeshData mesh_data;
+
+	std::size_t vertex_count = 0;
+	std::size_t index_count = 0;
+
+	for (auto mesh : meshes)
+	{
+		vertex_count += mesh->vertices.size();
+		index_count += mesh->indices_32.size();
+	}
+
+	mesh_data.vertices.reserve(vertex_count);
+	mesh_data.indices_32.reserve(index_count);
+
+	submeshes.clear();
+	submeshes.reserve(meshes.size());
+
+	for (auto mesh : meshes)
+	{
+		SubmeshRange submesh;
+		submesh.index_count = static_cast<std::uint32_t>(mesh->indices_32.size());
+		submesh.start_index_location = static_cast<std::uint32_t>(mesh_data.indices_32.size());
+		submesh.base_vertex_location = static_cast<std::int32_t>(mesh_data.vertices.size());
+		submesh.bounds = mesh->bounds;
+		submesh.sphere_bounds = mesh->sphere_bounds;
+
+		submeshes.push_back(submesh);
+
+		mesh_data.vertices.insert(mesh_data.vertices.end(), mesh->vertices.begin(), mesh->vertices.end());
+		mesh_data.indices_32.insert(mesh_data.indices_32.end(), mesh->indices_32.begin(), mesh->indices_32.end());
+	}
+
+	computeBounds(mesh_data);
+
+	return mesh_data;
+}
+
+void GeometryGenerator::computeBounds(MeshData& mesh_data)
+{
+	BoundsBuilder bounds_builder;
+
+	XMFLOAT3 const* positions = mesh_data.vertices.empty() ? nullptr : &mesh_data.vertices[0].position;
+
+	mesh_data.bounds = bounds_builder.computeBox(positions, mesh_data.vertices.size(), sizeof(Vertex));
+	mesh_data.sphere_bounds = bounds_builder.computeSphere(positions, mesh_data.vertices.size(), sizeof(Vertex));
+}
+
+void GeometryGenerator::computeBounds(MeshDataSoA& mesh_data)
+{
+	BoundsBuilder bounds_builder;
+
+	mesh_data.bounds = bounds_builder.computeBox(mesh_data.positions.data(), mesh_data.positions.size());
+	mesh_data.sphere_bounds = bounds_builder.computeSphere(mesh_data.positions.data(), mesh_data.positions.size());
+}
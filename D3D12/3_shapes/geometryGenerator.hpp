@@ -1,13 +1,25 @@
 #pragma once
 
+#include <DirectXCollision.h>
 #include <DirectXMath.h>
 
+#include "threadPool.hpp"
+
+#include <algorithm>
 #include <cstdint>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 class GeometryGenerator
 {
 public:
+	enum class SubdivisionMode
+	{
+		Split,
+		Welded
+	};
+
 	struct Vertex
 	{
 		Vertex()
@@ -54,16 +66,47 @@ public:
 		std::vector<Vertex> vertices;
 		std::vector<std::uint32_t> indices_32;
 
-		std::vector<std::uint16_t>& getIndices16()
+		// Filled by every generator; computeBounds refreshes them after the
+		// positions are edited.
+		DirectX::BoundingBox bounds;
+		DirectX::BoundingSphere sphere_bounds;
+
+		std::uint32_t maxIndex() const
 		{
-			if (indices_16.empty())
+			std::uint32_t result = 0;
+
+			for (auto index : indices_32)
 			{
-				indices_16.resize(indices_32.size());
+				result = std::max(result, index);
+			}
+
+			return result;
+		}
+
+		bool fitsIndices16() const
+		{
+			return maxIndex() <= UINT16_MAX;
+		}
 
-				for (size_t i = 0; i < indices_32.size(); ++i)
+		// Rebuilt on every call so it never goes stale after indices_32
+		// changes. Throws instead of truncating indices that do not fit;
+		// IndexPacker splits such meshes into 16 bit addressable pieces.
+		std::vector<std::uint16_t>& getIndices16()
+		{
+			indices_16.resize(indices_32.size());
+
+			for (size_t i = 0; i < indices_32.size(); ++i)
+			{
+				if (indices_32[i] > UINT16_MAX)
 				{
-					indices_16[i] = static_cast<std::uint16_t>(indices_32[i]);
+					indices_16.clear();
+
+					throw std::out_of_range(
+						"MeshData::getIndices16: index " + std::to_string(indices_32[i]) +
+						" at position " + std::to_string(i) + " does not fit in 16 bits");
 				}
+
+				indices_16[i] = static_cast<std::uint16_t>(indices_32[i]);
 			}
 
 			return indices_16;
@@ -73,18 +116,74 @@ public:
 		std::vector<std::uint16_t> indices_16;
 	};
 
+	// Same mesh as MeshData, with one contiguous stream per attribute so
+	// passes that only read positions do not drag the other 32 bytes of
+	// every vertex through the cache.
+	struct MeshDataSoA
+	{
+		std::vector<DirectX::XMFLOAT3> positions;
+		std::vector<DirectX::XMFLOAT3> normals;
+		std::vector<DirectX::XMFLOAT3> tangents_u;
+		std::vector<DirectX::XMFLOAT2> tex_cs;
+		std::vector<std::uint32_t> indices_32;
+
+		DirectX::BoundingBox bounds;
+		DirectX::BoundingSphere sphere_bounds;
+
+		std::size_t vertexCount() const
+		{
+			return positions.size();
+		}
+
+		void resize(std::size_t vertex_count)
+		{
+			positions.resize(vertex_count);
+			normals.resize(vertex_count);
+			tangents_u.resize(vertex_count);
+			tex_cs.resize(vertex_count);
+		}
+	};
+
+	// Where merge placed one of its meshes; mirrors SubmeshGeometry.
+	struct SubmeshRange
+	{
+		std::uint32_t index_count = 0;
+		std::uint32_t start_index_location = 0;
+		std::int32_t base_vertex_location = 0;
+
+		DirectX::BoundingBox bounds;
+		DirectX::BoundingSphere sphere_bounds;
+	};
+
 	MeshData createBox(
 		float width,
 		float height,
 		float depth,
-		std::uint32_t n_subdivisions);
+		std::uint32_t n_subdivisions,
+		SubdivisionMode mode = SubdivisionMode::Split);
 
 	MeshData createSphere(
 		float radius,
 		std::uint32_t slice_count,
 		std::uint32_t stack_count);
 
+	// Rings and index bands are written into pre-sized arrays by the
+	// threads of thread_pool. The output matches the single-threaded call.
+	MeshData createSphere(
+		float radius,
+		std::uint32_t slice_count,
+		std::uint32_t stack_count,
+		ThreadPool& thread_pool);
+
 	MeshData createGeosphere(
+		float radius,
+		std::uint32_t n_subdivisions,
+		SubdivisionMode mode = SubdivisionMode::Split);
+
+	// Builds the level n_subdivisions geosphere straight from a lattice over
+	// the icosahedron faces. Topology matches createGeosphere with
+	// SubdivisionMode::Welded, but the level is capped at 12 instead of 6.
+	MeshData createGeosphereDirect(
 		float radius,
 		std::uint32_t n_subdivisions);
 
@@ -101,6 +200,34 @@ public:
 		std::uint32_t m,
 		std::uint32_t n);
 
+	MeshData createGrid(
+		float width,
+		float depth,
+		std::uint32_t m,
+		std::uint32_t n,
+		ThreadPool& thread_pool);
+
+	// Structure-of-arrays versions of createSphere, createCylinder and
+	// createGrid. Vertices are filled four at a time with DirectXMath
+	// vectors; the index buffers are identical to the AoS versions.
+	MeshDataSoA createSphereSoA(
+		float radius,
+		std::uint32_t slice_count,
+		std::uint32_t stack_count);
+
+	MeshDataSoA createCylinderSoA(
+		float bottom_radius,
+		float top_radius,
+		float height,
+		std::uint32_t slice_count,
+		std::uint32_t stack_count);
+
+	MeshDataSoA createGridSoA(
+		float width,
+		float depth,
+		std::uint32_t m,
+		std::uint32_t n);
+
 	MeshData createQuad(
 		float x,
 		float y,
@@ -108,9 +235,83 @@ public:
 		float h,
 		float depth);
 
+	// Concatenates meshes into one vertex and one index buffer. Indices
+	// stay local to their mesh; submeshes receives the base_vertex_location
+	// and bounds of each one, in order.
+	MeshData merge(
+		std::vector<MeshData const*> const& meshes,
+		std::vector<SubmeshRange>& submeshes);
+
+	void computeBounds(MeshData& mesh_data);
+	void computeBounds(MeshDataSoA& mesh_data);
+
 private:
 	void subdivide(MeshData& mesh_data);
+	void subdivideWelded(MeshData& mesh_data);
+	void subdivide(MeshData& mesh_data, SubdivisionMode mode);
 	Vertex midPoint(Vertex const& v0, Vertex const& v1);
+	void projectOntoSphere(float radius, MeshData& mesh_data);
+
+	void beginSphere(
+		float radius,
+		std::uint32_t slice_count,
+		std::uint32_t stack_count,
+		MeshData& mesh_data);
+
+	void buildSphereRing(
+		float radius,
+		std::uint32_t slice_count,
+		std::uint32_t stack_count,
+		std::uint32_t ring,
+		MeshData& mesh_data);
+
+	std::size_t sphereIndexCount(
+		std::uint32_t slice_count,
+		std::uint32_t stack_count);
+
+	void buildSphereIndexBand(
+		std::uint32_t slice_count,
+		std::uint32_t stack_count,
+		std::uint32_t band,
+		std::vector<std::uint32_t>& indices);
+
+	void buildSphereIndices(
+		std::uint32_t slice_count,
+		std::uint32_t stack_count,
+		std::vector<std::uint32_t>& indices);
+
+	void buildCylinderSideIndices(
+		std::uint32_t slice_count,
+		std::uint32_t stack_count,
+		std::vector<std::uint32_t>& indices);
+
+	void buildGridRow(
+		float width,
+		float depth,
+		std::uint32_t m,
+		std::uint32_t n,
+		std::uint32_t i,
+		MeshData& mesh_data);
+
+	std::size_t gridIndexCount(std::uint32_t m, std::uint32_t n);
+
+	void buildGridIndexRow(
+		std::uint32_t n,
+		std::uint32_t i,
+		std::vector<std::uint32_t>& indices);
+
+	void buildGridIndices(
+		std::uint32_t m,
+		std::uint32_t n,
+		std::vector<std::uint32_t>& indices);
+
+	void buildCylinderCapSoA(
+		float radius,
+		float height,
+		bool top,
+		std::uint32_t slice_count,
+		std::uint32_t base_index,
+		MeshDataSoA& mesh_data);
 
 	void buildCylinderTopCap(
 		float bottom_radius,
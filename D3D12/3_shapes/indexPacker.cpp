@@ -0,0 +1,147 @@
+#include "indexPacker.hpp"
+#include "boundsBuilder.hpp"
+
+#include <climits>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+	std::uint32_t const invalid_index = ~0u;
+}
+
+IndexPacker::PackedMesh IndexPacker::pack(GeometryGenerator::MeshData const& mesh_data, bool allow_split)
+{
+	if (mesh_data.indices_32.size() % 3 != 0)
+	{
+		throw std::invalid_argument("IndexPacker::pack: index count is not a multiple of 3");
+	}
+
+	std::uint32_t max_index = mesh_data.maxIndex();
+
+	if (!mesh_data.indices_32.empty() && max_index >= mesh_data.vertices.size())
+	{
+		throw std::out_of_range(
+			"IndexPacker::pack: index " + std::to_string(max_index) +
+			" is past the " + std::to_string(mesh_data.vertices.size()) + " vertices");
+	}
+
+	PackedMesh packed;
+
+	if (max_index <= UINT16_MAX)
+	{
+		packed.vertices = mesh_data.vertices;
+		packed.indices_16.assign(mesh_data.indices_32.begin(), mesh_data.indices_32.end());
+		packed.index_format = DXGI_FORMAT_R16_UINT;
+	}
+	else if (allow_split)
+	{
+		split16(mesh_data, packed);
+		computeRangeBounds(packed);
+
+		return packed;
+	}
+	else
+	{
+		packed.vertices = mesh_data.vertices;
+		packed.indices_32 = mesh_data.indices_32;
+		packed.index_format = DXGI_FORMAT_R32_UINT;
+	}
+
+	Range range;
+	range.index_count = static_cast<std::uint32_t>(mesh_data.indices_32.size());
+	range.bounds = mesh_data.bounds;
+	packed.ranges.push_back(range);
+
+	return packed;
+}
+
+void IndexPacker::split16(GeometryGenerator::MeshData const& mesh_data, PackedMesh& packed)
+{
+	auto const& indices = mesh_data.indices_32;
+
+	packed.index_format = DXGI_FORMAT_R16_UINT;
+	packed.indices_16.reserve(indices.size());
+	packed.vertices.reserve(mesh_data.vertices.size());
+
+	// A vertex belongs to the current piece when its stamp is the piece
+	// number, so starting a piece never has to clear the local indices.
+	std::vector<std::uint32_t> stamps(mesh_data.vertices.size(), invalid_index);
+	std::vector<std::uint16_t> local_indices(mesh_data.vertices.size());
+
+	std::uint32_t piece = 0;
+	std::uint32_t piece_vertex_count = 0;
+
+	Range range;
+
+	auto closeRange = [&]
+	{
+		range.index_count = static_cast<std::uint32_t>(packed.indices_16.size()) - range.start_index_location;
+
+		if (range.index_count > 0)
+		{
+			packed.ranges.push_back(range);
+		}
+
+		if (packed.vertices.size() > static_cast<std::size_t>(INT_MAX))
+		{
+			throw std::out_of_range("IndexPacker::pack: base_vertex_location does not fit in INT");
+		}
+
+		range.start_index_location = static_cast<std::uint32_t>(packed.indices_16.size());
+		range.base_vertex_location = static_cast<std::int32_t>(packed.vertices.size());
+
+		++piece;
+		piece_vertex_count = 0;
+	};
+
+	for (std::size_t t = 0; t < indices.size(); t += 3)
+	{
+		std::uint32_t a = indices[t + 0];
+		std::uint32_t b = indices[t + 1];
+		std::uint32_t c = indices[t + 2];
+
+		std::uint32_t new_vertices =
+			(stamps[a] != piece) +
+			(stamps[b] != piece && b != a) +
+			(stamps[c] != piece && c != a && c != b);
+
+		if (piece_vertex_count + new_vertices > max_vertices_16)
+		{
+			closeRange();
+		}
+
+		for (auto v : { a, b, c })
+		{
+			if (stamps[v] != piece)
+			{
+				stamps[v] = piece;
+				local_indices[v] = static_cast<std::uint16_t>(piece_vertex_count++);
+				packed.vertices.push_back(mesh_data.vertices[v]);
+			}
+
+			packed.indices_16.push_back(local_indices[v]);
+		}
+	}
+
+	closeRange();
+}
+
+void IndexPacker::computeRangeBounds(PackedMesh& packed)
+{
+	BoundsBuilder bounds_builder;
+
+	// Pieces own consecutive runs of the vertex buffer.
+	for (std::size_t i = 0; i < packed.ranges.size(); ++i)
+	{
+		std::size_t first = packed.ranges[i].base_vertex_location;
+		std::size_t last = i + 1 < packed.ranges.size() ?
+			packed.ranges[i + 1].base_vertex_location :
+			packed.vertices.size();
+
+		packed.ranges[i].bounds = bounds_builder.computeBox(
+			&packed.vertices[first].position,
+			last - first,
+			sizeof(GeometryGenerator::Vertex));
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "geometryGenerator.hpp"
+
+#include <dxgiformat.h>
+
+#include <cstdint>
+#include <vector>
+
+// Chooses the smallest index format a mesh can use. Meshes that address
+// more than 65536 vertices can be split into pieces of at most 65536
+// vertices each, every piece drawn with 16 bit indices and its own
+// base_vertex_location, which halves index bandwidth against R32_UINT.
+class IndexPacker
+{
+public:
+	static std::uint32_t const max_vertices_16 = UINT16_MAX + 1;
+
+	// Mirrors SubmeshGeometry; every range is one DrawIndexedInstanced call.
+	struct Range
+	{
+		std::uint32_t index_count = 0;
+		std::uint32_t start_index_location = 0;
+		std::int32_t base_vertex_location = 0;
+
+		DirectX::BoundingBox bounds;
+	};
+
+	struct PackedMesh
+	{
+		std::vector<GeometryGenerator::Vertex> vertices;
+
+		// Only the one matching index_format is filled.
+		std::vector<std::uint16_t> indices_16;
+		std::vector<std::uint32_t> indices_32;
+
+		DXGI_FORMAT index_format = DXGI_FORMAT_R16_UINT;
+		std::vector<Range> ranges;
+
+		void const* indexData() const
+		{
+			return index_format == DXGI_FORMAT_R16_UINT ?
+				static_cast<void const*>(indices_16.data()) :
+				static_cast<void const*>(indices_32.data());
+		}
+
+		std::uint32_t indexBufferSizeInBytes() const
+		{
+			return static_cast<std::uint32_t>(index_format == DXGI_FORMAT_R16_UINT ?
+				indices_16.size() * sizeof(std::uint16_t) :
+				indices_32.size() * sizeof(std::uint32_t));
+		}
+	};
+
+	// Uses R16_UINT with a single range whenever every index fits. Otherwise
+	// splits the mesh when allow_split is set, keeping triangle order and
+	// duplicating the vertices shared between pieces, or falls back to
+	// R32_UINT. Throws std::out_of_range for indices past the vertex buffer.
+	PackedMesh pack(GeometryGenerator::MeshData const& mesh_data, bool allow_split = true);
+
+private:
+	void split16(GeometryGenerator::MeshData const& mesh_data, PackedMesh& packed);
+	void computeRangeBounds(PackedMesh& packed);
+};
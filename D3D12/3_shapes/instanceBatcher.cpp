@@ -0,0 +1,106 @@
+#include "instanceBatcher.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+
+using namespace DirectX;
+
+void InstanceBatcher::clear()
+{
+	objects.clear();
+	batches.clear();
+	instances.clear();
+	instance_slots.clear();
+}
+
+std::uint32_t InstanceBatcher::addObject(std::uint32_t mesh, std::uint32_t submesh, XMFLOAT4X4 const& world)
+{
+	objects.push_back({ mesh, submesh, world });
+
+	return static_cast<std::uint32_t>(objects.size() - 1);
+}
+
+std::uint32_t InstanceBatcher::objectCount() const
+{
+	return static_cast<std::uint32_t>(objects.size());
+}
+
+void InstanceBatcher::build(std::uint32_t max_instances_per_batch)
+{
+	assert(max_instances_per_batch > 0);
+
+	std::uint32_t object_count = objectCount();
+
+	// Counting sort on the group of each object, groups numbered in order of
+	// first appearance, which keeps the output stable and deterministic.
+	std::unordered_map<std::uint64_t, std::uint32_t> groups;
+	std::vector<std::uint32_t> object_groups(object_count);
+	std::vector<std::uint32_t> group_first;
+	std::vector<std::uint32_t> group_objects;
+
+	groups.reserve(object_count);
+
+	for (std::uint32_t i = 0; i < object_count; ++i)
+	{
+		std::uint64_t key = static_cast<std::uint64_t>(objects[i].mesh) << 32 | objects[i].submesh;
+		auto inserted = groups.emplace(key, static_cast<std::uint32_t>(group_objects.size()));
+
+		if (inserted.second)
+		{
+			group_objects.push_back(0);
+		}
+
+		object_groups[i] = inserted.first->second;
+		++group_objects[object_groups[i]];
+	}
+
+	std::uint32_t group_count = static_cast<std::uint32_t>(group_objects.size());
+	group_first.resize(group_count);
+
+	std::uint32_t first = 0;
+
+	for (std::uint32_t group = 0; group < group_count; ++group)
+	{
+		group_first[group] = first;
+		first += group_objects[group];
+	}
+
+	instances.resize(object_count);
+	instance_slots.resize(object_count);
+
+	std::vector<std::uint32_t> cursors = group_first;
+	std::vector<std::uint32_t> group_leaders(group_count);
+
+	for (std::uint32_t i = 0; i < object_count; ++i)
+	{
+		std::uint32_t group = object_groups[i];
+		std::uint32_t slot = cursors[group]++;
+
+		if (slot == group_first[group])
+		{
+			group_leaders[group] = i;
+		}
+
+		XMStoreFloat4x4(&instances[slot].world, XMMatrixTranspose(XMLoadFloat4x4(&objects[i].world)));
+		instance_slots[i] = slot;
+	}
+
+	batches.clear();
+
+	for (std::uint32_t group = 0; group < group_count; ++group)
+	{
+		Object const& leader = objects[group_leaders[group]];
+
+		for (std::uint32_t done = 0; done < group_objects[group]; done += max_instances_per_batch)
+		{
+			Batch batch;
+			batch.mesh = leader.mesh;
+			batch.submesh = leader.submesh;
+			batch.first_instance = group_first[group] + done;
+			batch.instance_count = std::min(max_instances_per_batch, group_objects[group] - done);
+
+			batches.push_back(batch);
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+// Groups the objects of a frame that draw the same submesh of the same mesh
+// into instanced draws. Meshes and submeshes are plain ids chosen by the
+// renderer (e.g. indices into its Mesh array and into a per-mesh list of
+// SubmeshGeometry), which keeps this free of any D3D12 state.
+//
+// The instances of all batches are packed into one array meant for a
+// StructuredBuffer<InstanceData>. SV_InstanceID does not include
+// StartInstanceLocation, so each batch passes first_instance to the shader
+// in a root constant and the shader reads instances[first + SV_InstanceID]:
+//
+//	SetGraphicsRoot32BitConstant(base_slot, batch.first_instance, 0);
+//	DrawIndexedInstanced(submesh.index_count, batch.instance_count,
+//		submesh.start_index_location, submesh.base_vertex_location, 0);
+class InstanceBatcher
+{
+public:
+	// Element of the instance buffer, transposed for HLSL as ObjectConstants.
+	struct InstanceData
+	{
+		DirectX::XMFLOAT4X4 world;
+	};
+
+	struct Batch
+	{
+		std::uint32_t mesh = 0;
+		std::uint32_t submesh = 0;
+
+		// Range of the batch in getInstances().
+		std::uint32_t first_instance = 0;
+		std::uint32_t instance_count = 0;
+	};
+
+	void clear();
+
+	// world is row-vector, as stored before transposing into ObjectConstants.
+	// Returns the object index.
+	std::uint32_t addObject(std::uint32_t mesh, std::uint32_t submesh, DirectX::XMFLOAT4X4 const& world);
+
+	// Builds the batches, in order of the first object of each submesh, and
+	// packs the instances of every batch contiguously, in object order.
+	// Batches are split at max_instances_per_batch.
+	void build(std::uint32_t max_instances_per_batch = UINT32_MAX);
+
+	std::uint32_t objectCount() const;
+
+	std::vector<Batch> const& getBatches() const
+	{
+		return batches;
+	}
+
+	std::vector<InstanceData> const& getInstances() const
+	{
+		return instances;
+	}
+
+	// Position of each object in getInstances().
+	std::vector<std::uint32_t> const& getInstanceSlots() const
+	{
+		return instance_slots;
+	}
+
+private:
+	struct Object
+	{
+		std::uint32_t mesh;
+		std::uint32_t submesh;
+		DirectX::XMFLOAT4X4 world;
+	};
+
+	std::vector<Object> objects;
+
+	std::vector<Batch> batches;
+	std::vector<InstanceData> instances;
+	std::vector<std::uint32_t> instance_slots;
+};
@@ -1,8 +1,31 @@
+#include "batchTransform.hpp"
+#include "boundsBuilder.hpp"
 #include "d3d12App.hpp"
+#include "d3d12ConstantAllocator.hpp"
+#include "d3d12HeapSuballocator.hpp"
 #include "dataDescription.hpp"
+#include "frameRing.hpp"
 #include "math.hpp"
 #include "mesh.hpp"
-#include "uploadBuffer.hpp"
+
+// Per-frame state of the cube. Its constants come from constant_allocator,
+// which frees them when the frame's fence completes.
+struct CubeFrameResource
+{
+	CubeFrameResource(ID3D12Device* device)
+	{
+		THROW_IF_FAILED(device->CreateCommandAllocator(
+			D3D12_COMMAND_LIST_TYPE_DIRECT,
+			IID_PPV_ARGS(&command_list_allocator)));
+	}
+
+	CubeFrameResource(CubeFrameResource const&) = delete;
+	CubeFrameResource& operator=(CubeFrameResource const&) = delete;
+
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> command_list_allocator;
+
+	UINT64 fence = 0;
+};
 
 class App : public D3D12App
 {
@@ -11,7 +34,14 @@ public:
 		:
 		D3D12App(instance) {}
 
-	~App() {}
+	~App()
+	{
+		// Frame resources may still be in use by the GPU.
+		if (device)
+		{
+			flushCommandQueue();
+		}
+	}
 
 	virtual bool init() override
 	{
@@ -20,8 +50,7 @@ public:
 
 		THROW_IF_FAILED(command_list->Reset(command_allocator.Get(), nullptr));
 
-		buildDescriptorHeaps();
-		buildConstantBuffers();
+		buildFrameResources();
 		buildRootSignature();
 		buildShadersAndInputLayout();
 		buildGeometry();
@@ -36,49 +65,26 @@ public:
 
 		command_queue->ExecuteCommandLists(1, command_lists);
 
+		// Later frames are queued behind this wait, so it is enough to make
+		// the direct queue wait once for the geometry copies.
+		queue_scheduler->submit(QueueType::Direct, nullptr, 0, &geometry_upload, 1);
+
 		flushCommandQueue();
 
 		return true;
 	}
 
 private:
-	void buildDescriptorHeaps()
+	void buildFrameResources()
 	{
-		D3D12_DESCRIPTOR_HEAP_DESC cbv_heap_desc;
-		cbv_heap_desc.NumDescriptors = 1;
-		cbv_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-		cbv_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-		cbv_heap_desc.NodeMask = 0;
-
-		THROW_IF_FAILED(device->CreateDescriptorHeap(&cbv_heap_desc, IID_PPV_ARGS(&cbv_heap)));
-	}
-
-	void buildConstantBuffers()
-	{
-		object_cb = std::make_unique<UploadBuffer<ObjectConstants>>(device, 1, true);
-		
-		UINT object_cb_size_in_bytes = calcConstantBufferSizeInBytes(sizeof(ObjectConstants));
-		D3D12_GPU_VIRTUAL_ADDRESS cb_address = object_cb->resource()->GetGPUVirtualAddress();
-
-		int cube_cb_index = 0;
-		cb_address += cube_cb_index * object_cb_size_in_bytes;
-
-		D3D12_CONSTANT_BUFFER_VIEW_DESC cbv_desc;
-		cbv_desc.BufferLocation = cb_address;
-		cbv_desc.SizeInBytes = object_cb_size_in_bytes;
-
-		device->CreateConstantBufferView(
-			&cbv_desc,
-			cbv_heap->GetCPUDescriptorHandleForHeapStart());
+		frame_ring = std::make_unique<FrameRing<CubeFrameResource>>(n_frame_resources, device.Get());
+		constant_allocator = std::make_unique<D3D12ConstantAllocator>(device.Get(), constant_ring_size_in_bytes);
 	}
 
 	void buildRootSignature()
 	{
 		CD3DX12_ROOT_PARAMETER slot_root_parameter[1];
-
-		CD3DX12_DESCRIPTOR_RANGE cbv_table;
-		cbv_table.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);
-		slot_root_parameter[0].InitAsDescriptorTable(1, &cbv_table);
+		slot_root_parameter[0].InitAsConstantBufferView(0);
 
 		CD3DX12_ROOT_SIGNATURE_DESC root_signature_desc(
 			1,
@@ -123,6 +129,11 @@ private:
 		UINT const vertex_buffer_size_in_bytes = (UINT)sizeof(vertices);
 		UINT const index_buffer_size_in_bytes = (UINT)sizeof(indices);
 
+		buffer_heap = std::make_unique<D3D12HeapSuballocator>(
+			device,
+			D3D12HeapSuballocator::Mode::PlacedResources,
+			buffer_heap_page_size_in_bytes);
+
 		cube = std::make_unique<Mesh>();
 		cube->name = "cube";
 
@@ -135,12 +146,11 @@ private:
 			vertices,
 			vertex_buffer_size_in_bytes);
 
-		cube->vertex_buffer_gpu = createDefaultBuffer(
-			device,
-			command_list,
-			vertices,
-			vertex_buffer_size_in_bytes,
-			cube->vertex_buffer_uploader);
+		cube->vertex_buffer_gpu = buffer_heap->createPlacedBuffer(
+			buffer_heap->allocate(vertex_buffer_size_in_bytes),
+			D3D12_RESOURCE_STATE_COMMON);
+
+		upload_manager->uploadBuffer(cube->vertex_buffer_gpu.Get(), 0, vertices, vertex_buffer_size_in_bytes);
 
 		THROW_IF_FAILED(D3DCreateBlob(
 			index_buffer_size_in_bytes,
@@ -151,12 +161,13 @@ private:
 			indices,
 			index_buffer_size_in_bytes);
 
-		cube->index_buffer_gpu = createDefaultBuffer(
-			device,
-			command_list,
-			indices,
-			index_buffer_size_in_bytes,
-			cube->index_buffer_uploader);
+		cube->index_buffer_gpu = buffer_heap->createPlacedBuffer(
+			buffer_heap->allocate(index_buffer_size_in_bytes),
+			D3D12_RESOURCE_STATE_COMMON);
+
+		upload_manager->uploadBuffer(cube->index_buffer_gpu.Get(), 0, indices, index_buffer_size_in_bytes);
+
+		geometry_upload = upload_manager->submit();
 
 		cube->vertex_buffer_stride_in_bytes = sizeof(Vertex);
 		cube->vertex_buffer_size_in_bytes = vertex_buffer_size_in_bytes;
@@ -167,6 +178,7 @@ private:
 		submesh.index_count = _countof(indices);
 		submesh.start_index_location = 0;
 		submesh.base_vertex_location = 0;
+		submesh.bounds = BoundsBuilder().computeBox(&vertices[0].position, _countof(vertices), sizeof(Vertex));
 
 		cube->draw_args["cube"] = submesh;
 	}
@@ -210,6 +222,16 @@ private:
 
 	virtual void update(GameTimer const& timer) override
 	{
+		// Only blocks when the GPU is n_frame_resources frames behind. The
+		// cached completed value usually answers without querying the fence.
+		frame_ring->beginFrame(fence_timeline->lastCompletedValue(), [this](UINT64 value)
+		{
+			waitForFence(value);
+		});
+
+		// The wait above, if any, updated the cached value.
+		constant_allocator->get().beginFrame(fence_timeline->lastCompletedValue());
+
 		float x = radius * sinf(phi) * cosf(theta);
 		float y = radius * cosf(phi);
 		float z = radius * sinf(phi) * sinf(theta);
@@ -221,23 +243,26 @@ private:
 		DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(pos, target, up);
 		DirectX::XMStoreFloat4x4(&view_matrix, view);
 
-		DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&world_matrix);
 		DirectX::XMMATRIX proj = DirectX::XMLoadFloat4x4(&proj_matrix);
-		DirectX::XMMATRIX world_view_proj = world * view * proj;
 
-		ObjectConstants object_constants;
+		DirectX::XMFLOAT4X4 view_proj;
+		DirectX::XMStoreFloat4x4(&view_proj, view * proj);
 
-		DirectX::XMStoreFloat4x4(
-			&object_constants.world_view_proj,
-			DirectX::XMMatrixTranspose(world_view_proj));
+		ConstantAllocator::Allocation object_cb = constant_allocator->get().allocate(sizeof(ObjectConstants));
+		assert(object_cb.data != nullptr);
 
-		object_cb->copyData(0, object_constants);
+		// world_view_proj is the first member of ObjectConstants.
+		transformTransposed(&world_matrix, 1, view_proj, object_cb.data, ConstantAllocator::alignment);
+
+		object_cb_address = object_cb.gpu_address;
 	}
 
 	virtual void draw(GameTimer const& timer) override
 	{
-		THROW_IF_FAILED(command_allocator->Reset());
-		THROW_IF_FAILED(command_list->Reset(command_allocator.Get(), pso.Get()));
+		CubeFrameResource& frame = frame_ring->current();
+
+		THROW_IF_FAILED(frame.command_list_allocator->Reset());
+		THROW_IF_FAILED(command_list->Reset(frame.command_list_allocator.Get(), pso.Get()));
 
 		command_list->RSSetViewports(1, &viewport);
 		command_list->RSSetScissorRects(1, &scissor);
@@ -256,20 +281,14 @@ private:
 		command_list->ClearDepthStencilView(dsv, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 		command_list->OMSetRenderTargets(1, &rtv, TRUE, &dsv);
 
-		ID3D12DescriptorHeap* descriptor_heaps[]
-		{
-			cbv_heap.Get()
-		};
-
 		auto vbv = cube->vertexBufferView();
 		auto ibv = cube->indexBufferView();
 
-		command_list->SetDescriptorHeaps(_countof(descriptor_heaps), descriptor_heaps);
 		command_list->SetGraphicsRootSignature(root_signature.Get());
 		command_list->IASetVertexBuffers(0, 1, &vbv);
 		command_list->IASetIndexBuffer(&ibv);
 		command_list->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		command_list->SetGraphicsRootDescriptorTable(0, cbv_heap->GetGPUDescriptorHandleForHeapStart());
+		command_list->SetGraphicsRootConstantBufferView(0, object_cb_address);
 		command_list->DrawIndexedInstanced(cube->draw_args["cube"].index_count, 1, 0, 0, 0);
 
 		transition = CD3DX12_RESOURCE_BARRIER::Transition(
@@ -292,7 +311,12 @@ private:
 
 		current_swap_chain_buffer = swap_chain->GetCurrentBackBufferIndex();
 
-		flushCommandQueue();
+		++fence_value;
+
+		THROW_IF_FAILED(command_queue->Signal(fence.Get(), fence_value));
+
+		frame_ring->endFrame(fence_value);
+		constant_allocator->get().endFrame(fence_value);
 	}
 
 	virtual void onMouseDown(WPARAM state, int x, int y) override
@@ -337,10 +361,20 @@ private:
 	FLOAT const clear_color[4] = { 0.1f, 0.3f, 0.1f, 1.0f };
 
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> root_signature;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> cbv_heap;
 
-	std::unique_ptr<UploadBuffer<ObjectConstants>> object_cb;
+	static UINT const n_frame_resources = 3;
+	std::unique_ptr<FrameRing<CubeFrameResource>> frame_ring;
+
+	// Room for a few hundred objects' constants per frame in flight.
+	static UINT64 const constant_ring_size_in_bytes = n_frame_resources * 64 * 1024;
+	std::unique_ptr<D3D12ConstantAllocator> constant_allocator;
+	D3D12_GPU_VIRTUAL_ADDRESS object_cb_address = 0;
+
+	static UINT64 const buffer_heap_page_size_in_bytes = 4ull << 20;
+	std::unique_ptr<D3D12HeapSuballocator> buffer_heap;
+
 	std::unique_ptr<Mesh> cube;
+	UploadManager::Ticket geometry_upload;
 
 	Microsoft::WRL::ComPtr<ID3DBlob> vertex_shader_byte_code;
 	Microsoft::WRL::ComPtr<ID3DBlob> pixel_shader_byte_code;
@@ -0,0 +1,705 @@
+#include "meshOptimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+using namespace DirectX;
+
+namespace
+{
+	std::uint32_t const forsyth_cache_size = 32;
+	std::uint32_t const forsyth_max_valence = 32;
+
+	float const cache_decay_power = 1.5f;
+	float const last_triangle_score = 0.75f;
+	float const valence_boost_scale = 2.0f;
+	float const valence_boost_power = 0.5f;
+
+	std::uint32_t const invalid_index = ~0u;
+
+	std::uint32_t const overdraw_cache_size = 16;
+
+	class VertexScoreTable
+	{
+	public:
+		VertexScoreTable()
+		{
+			for (std::uint32_t i = 0; i < forsyth_cache_size; ++i)
+			{
+				if (i < 3)
+				{
+					cache[i] = last_triangle_score;
+				}
+				else
+				{
+					float scaler = 1.0f / (forsyth_cache_size - 3);
+					cache[i] = powf(1.0f - (i - 3) * scaler, cache_decay_power);
+				}
+			}
+
+			valence[0] = 0.0f;
+
+			for (std::uint32_t i = 1; i <= forsyth_max_valence; ++i)
+			{
+				valence[i] = valence_boost_scale * powf((float)i, -valence_boost_power);
+			}
+		}
+
+		float score(std::uint32_t cache_position, std::uint32_t live_triangles) const
+		{
+			if (live_triangles == 0)
+			{
+				return -1.0f;
+			}
+
+			float result = valence[std::min(live_triangles, forsyth_max_valence)];
+
+			if (cache_position < forsyth_cache_size)
+			{
+				result += cache[cache_position];
+			}
+
+			return result;
+		}
+
+	private:
+		float cache[forsyth_cache_size];
+		float valence[forsyth_max_valence + 1];
+	};
+
+	// FIFO cache model shared by the overdraw clustering passes.
+	class FifoCache
+	{
+	public:
+		FifoCache(std::uint32_t vertex_count, std::uint32_t cache_size)
+			:
+			load_times(vertex_count, 0),
+			cache_size{ cache_size },
+			time{ cache_size + 1 }
+		{
+
+		}
+
+		std::uint32_t triangleMisses(std::uint32_t const* triangle)
+		{
+			std::uint32_t misses = 0;
+
+			for (std::uint32_t k = 0; k < 3; ++k)
+			{
+				if (time - load_times[triangle[k]] > cache_size)
+				{
+					load_times[triangle[k]] = time++;
+					++misses;
+				}
+			}
+
+			return misses;
+		}
+
+		void flush()
+		{
+			time += cache_size + 1;
+		}
+
+	private:
+		std::vector<std::uint32_t> load_times;
+		std::uint32_t cache_size;
+		std::uint32_t time;
+	};
+
+	class DepthRasterizer
+	{
+	public:
+		DepthRasterizer(std::uint32_t resolution)
+			:
+			resolution{ resolution },
+			depth(resolution * resolution)
+		{
+
+		}
+
+		void clear()
+		{
+			std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::infinity());
+		}
+
+		// Vertices are (x, y) in pixels and z as depth; returns the number of
+		// fragments that passed the depth test.
+		std::uint64_t drawTriangle(XMFLOAT3 a, XMFLOAT3 b, XMFLOAT3 c)
+		{
+			float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+
+			if (area == 0.0f)
+			{
+				return 0;
+			}
+
+			if (area < 0.0f)
+			{
+				std::swap(b, c);
+				area = -area;
+			}
+
+			int min_x = std::max(0, (int)floorf(std::min({ a.x, b.x, c.x })));
+			int min_y = std::max(0, (int)floorf(std::min({ a.y, b.y, c.y })));
+			int max_x = std::min((int)resolution - 1, (int)ceilf(std::max({ a.x, b.x, c.x })));
+			int max_y = std::min((int)resolution - 1, (int)ceilf(std::max({ a.y, b.y, c.y })));
+
+			std::uint64_t shaded = 0;
+
+			for (int y = min_y; y <= max_y; ++y)
+			{
+				for (int x = min_x; x <= max_x; ++x)
+				{
+					float px = x + 0.5f;
+					float py = y + 0.5f;
+
+					float w0 = edge(b, c, px, py);
+					float w1 = edge(c, a, px, py);
+					float w2 = edge(a, b, px, py);
+
+					if (!inside(w0, b, c) || !inside(w1, c, a) || !inside(w2, a, b))
+					{
+						continue;
+					}
+
+					float z = (w0 * a.z + w1 * b.z + w2 * c.z) / area;
+					float& stored = depth[y * resolution + x];
+
+					if (z < stored)
+					{
+						stored = z;
+						++shaded;
+					}
+				}
+			}
+
+			return shaded;
+		}
+
+		std::uint64_t coveredPixels() const
+		{
+			return std::count_if(depth.begin(), depth.end(), [](float z)
+			{
+				return z != std::numeric_limits<float>::infinity();
+			});
+		}
+
+	private:
+		static float edge(XMFLOAT3 const& a, XMFLOAT3 const& b, float px, float py)
+		{
+			return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+		}
+
+		// Top-left rule, so pixels on an edge shared by two triangles are
+		// only counted once.
+		static bool inside(float w, XMFLOAT3 const& a, XMFLOAT3 const& b)
+		{
+			if (w != 0.0f)
+			{
+				return w > 0.0f;
+			}
+
+			return (a.y == b.y && b.x < a.x) || b.y > a.y;
+		}
+
+		std::uint32_t resolution;
+		std::vector<float> depth;
+	};
+}
+
+void MeshOptimizer::optimizeVertexCache(GeometryGenerator::MeshData& mesh_data)
+{
+	static VertexScoreTable const scores;
+
+	std::vector<std::uint32_t>& indices = mesh_data.indices_32;
+
+	std::uint32_t n_tris = (std::uint32_t)indices.size() / 3;
+	std::uint32_t vertex_count = (std::uint32_t)mesh_data.vertices.size();
+
+	if (n_tris == 0)
+	{
+		return;
+	}
+
+	// Per vertex list of the triangles that still have to be emitted.
+	std::vector<std::uint32_t> live_triangles(vertex_count, 0);
+
+	for (std::uint32_t i = 0; i < n_tris * 3; ++i)
+	{
+		++live_triangles[indices[i]];
+	}
+
+	std::vector<std::uint32_t> adjacency_offsets(vertex_count + 1, 0);
+
+	for (std::uint32_t v = 0; v < vertex_count; ++v)
+	{
+		adjacency_offsets[v + 1] = adjacency_offsets[v] + live_triangles[v];
+	}
+
+	std::vector<std::uint32_t> adjacency(n_tris * 3);
+	std::vector<std::uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+
+	for (std::uint32_t i = 0; i < n_tris * 3; ++i)
+	{
+		adjacency[fill[indices[i]]++] = i / 3;
+	}
+
+	std::vector<std::uint32_t> cache_positions(vertex_count, invalid_index);
+	std::vector<float> vertex_scores(vertex_count);
+
+	for (std::uint32_t v = 0; v < vertex_count; ++v)
+	{
+		vertex_scores[v] = scores.score(invalid_index, live_triangles[v]);
+	}
+
+	std::vector<float> triangle_scores(n_tris);
+	std::vector<bool> emitted(n_tris, false);
+
+	for (std::uint32_t t = 0; t < n_tris; ++t)
+	{
+		triangle_scores[t] =
+			vertex_scores[indices[t * 3 + 0]] +
+			vertex_scores[indices[t * 3 + 1]] +
+			vertex_scores[indices[t * 3 + 2]];
+	}
+
+	std::uint32_t best_triangle = (std::uint32_t)(
+		std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin());
+
+	std::vector<std::uint32_t> cache;
+	std::vector<std::uint32_t> next_cache;
+
+	cache.reserve(forsyth_cache_size + 3);
+	next_cache.reserve(forsyth_cache_size + 3);
+
+	std::vector<std::uint32_t> output(n_tris * 3);
+	std::uint32_t output_triangles = 0;
+	std::uint32_t input_cursor = 0;
+
+	while (output_triangles < n_tris)
+	{
+		if (best_triangle == invalid_index)
+		{
+			// Nothing adjacent to the cache is left: restart from the next
+			// triangle in input order, which keeps the whole pass linear.
+			while (emitted[input_cursor])
+			{
+				++input_cursor;
+			}
+
+			best_triangle = input_cursor;
+		}
+
+		std::uint32_t const* triangle = &indices[best_triangle * 3];
+
+		output[output_triangles * 3 + 0] = triangle[0];
+		output[output_triangles * 3 + 1] = triangle[1];
+		output[output_triangles * 3 + 2] = triangle[2];
+
+		++output_triangles;
+		emitted[best_triangle] = true;
+
+		next_cache.clear();
+
+		for (std::uint32_t k = 0; k < 3; ++k)
+		{
+			std::uint32_t v = triangle[k];
+
+			std::uint32_t* begin = &adjacency[adjacency_offsets[v]];
+			std::uint32_t* end = begin + live_triangles[v];
+			std::uint32_t* it = std::find(begin, end, best_triangle);
+
+			if (it != end)
+			{
+				*it = *(end - 1);
+				--live_triangles[v];
+			}
+
+			if (std::find(next_cache.begin(), next_cache.end(), v) == next_cache.end())
+			{
+				next_cache.push_back(v);
+			}
+		}
+
+		std::size_t emitted_count = next_cache.size();
+
+		for (std::uint32_t v : cache)
+		{
+			auto emitted_end = next_cache.begin() + emitted_count;
+
+			if (std::find(next_cache.begin(), emitted_end, v) == emitted_end)
+			{
+				next_cache.push_back(v);
+			}
+		}
+
+		for (std::uint32_t i = 0; i < next_cache.size(); ++i)
+		{
+			std::uint32_t v = next_cache[i];
+
+			cache_positions[v] = i < forsyth_cache_size ? i : invalid_index;
+
+			float score = scores.score(cache_positions[v], live_triangles[v]);
+			float delta = score - vertex_scores[v];
+
+			vertex_scores[v] = score;
+
+			for (std::uint32_t a = 0; a < live_triangles[v]; ++a)
+			{
+				triangle_scores[adjacency[adjacency_offsets[v] + a]] += delta;
+			}
+		}
+
+		best_triangle = invalid_index;
+		float best_score = -1.0f;
+
+		for (std::uint32_t v : next_cache)
+		{
+			for (std::uint32_t a = 0; a < live_triangles[v]; ++a)
+			{
+				std::uint32_t t = adjacency[adjacency_offsets[v] + a];
+
+				if (triangle_scores[t] > best_score)
+				{
+					best_score = triangle_scores[t];
+					best_triangle = t;
+				}
+			}
+		}
+
+		if (next_cache.size() > forsyth_cache_size)
+		{
+			next_cache.resize(forsyth_cache_size);
+		}
+
+		cache.swap(next_cache);
+	}
+
+	indices.swap(output);
+}
+
+void MeshOptimizer::optimizeVertexFetch(GeometryGenerator::MeshData& mesh_data)
+{
+	std::uint32_t vertex_count = (std::uint32_t)mesh_data.vertices.size();
+
+	std::vector<std::uint32_t> remap(vertex_count, invalid_index);
+	std::uint32_t next_vertex = 0;
+
+	for (std::uint32_t& index : mesh_data.indices_32)
+	{
+		if (remap[index] == invalid_index)
+		{
+			remap[index] = next_vertex++;
+		}
+
+		index = remap[index];
+	}
+
+	for (std::uint32_t v = 0; v < vertex_count; ++v)
+	{
+		if (remap[v] == invalid_index)
+		{
+			remap[v] = next_vertex++;
+		}
+	}
+
+	std::vector<GeometryGenerator::Vertex> vertices(vertex_count);
+
+	for (std::uint32_t v = 0; v < vertex_count; ++v)
+	{
+		vertices[remap[v]] = mesh_data.vertices[v];
+	}
+
+	mesh_data.vertices.swap(vertices);
+}
+
+void MeshOptimizer::optimizeOverdraw(GeometryGenerator::MeshData& mesh_data, float threshold)
+{
+	std::vector<std::uint32_t>& indices = mesh_data.indices_32;
+
+	std::uint32_t n_tris = (std::uint32_t)indices.size() / 3;
+	std::uint32_t vertex_count = (std::uint32_t)mesh_data.vertices.size();
+
+	if (n_tris == 0)
+	{
+		return;
+	}
+
+	FifoCache cache(vertex_count, overdraw_cache_size);
+
+	// Hard boundaries: triangles where the cache starts over, which the
+	// ordering can move freely without costing any extra misses.
+	std::vector<std::uint32_t> hard_boundaries;
+
+	for (std::uint32_t t = 0; t < n_tris; ++t)
+	{
+		// The first run starts at triangle 0 even if it hits the cache, as a
+		// degenerate triangle does.
+		if (cache.triangleMisses(&indices[t * 3]) == 3 || t == 0)
+		{
+			hard_boundaries.push_back(t);
+		}
+	}
+
+	hard_boundaries.push_back(n_tris);
+
+	// Soft boundaries: split each run wherever the ACMR so far is already
+	// within threshold of the whole run.
+	std::vector<std::uint32_t> clusters;
+
+	for (std::size_t h = 0; h + 1 < hard_boundaries.size(); ++h)
+	{
+		std::uint32_t begin = hard_boundaries[h];
+		std::uint32_t end = hard_boundaries[h + 1];
+
+		cache.flush();
+
+		std::uint32_t run_misses = 0;
+
+		for (std::uint32_t t = begin; t < end; ++t)
+		{
+			run_misses += cache.triangleMisses(&indices[t * 3]);
+		}
+
+		float run_threshold = threshold * run_misses / (end - begin);
+
+		clusters.push_back(begin);
+
+		cache.flush();
+
+		std::uint32_t misses = 0;
+		std::uint32_t tris = 0;
+
+		for (std::uint32_t t = begin; t < end; ++t)
+		{
+			misses += cache.triangleMisses(&indices[t * 3]);
+			++tris;
+
+			if ((float)misses / tris <= run_threshold && t + 1 < end)
+			{
+				clusters.push_back(t + 1);
+
+				cache.flush();
+				misses = 0;
+				tris = 0;
+			}
+		}
+	}
+
+	clusters.push_back(n_tris);
+
+	XMVECTOR mesh_center = XMVectorZero();
+
+	for (auto const& vertex : mesh_data.vertices)
+	{
+		mesh_center += XMLoadFloat3(&vertex.position);
+	}
+
+	mesh_center = mesh_center / (float)std::max(vertex_count, 1u);
+
+	// Clusters whose area-weighted normal points away from the mesh center
+	// are likely to occlude the others, so they go first.
+	std::uint32_t n_clusters = (std::uint32_t)clusters.size() - 1;
+	std::vector<float> sort_keys(n_clusters);
+
+	for (std::uint32_t c = 0; c < n_clusters; ++c)
+	{
+		XMVECTOR center = XMVectorZero();
+		XMVECTOR normal = XMVectorZero();
+		float area = 0.0f;
+
+		for (std::uint32_t t = clusters[c]; t < clusters[c + 1]; ++t)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&mesh_data.vertices[indices[t * 3 + 0]].position);
+			XMVECTOR p1 = XMLoadFloat3(&mesh_data.vertices[indices[t * 3 + 1]].position);
+			XMVECTOR p2 = XMLoadFloat3(&mesh_data.vertices[indices[t * 3 + 2]].position);
+
+			XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+			float triangle_area = XMVectorGetX(XMVector3Length(n));
+
+			center += (p0 + p1 + p2) * (triangle_area / 3.0f);
+			normal += n;
+			area += triangle_area;
+		}
+
+		if (area > 0.0f)
+		{
+			center = center / area;
+		}
+
+		sort_keys[c] = XMVectorGetX(XMVector3Dot(center - mesh_center, XMVector3Normalize(normal)));
+	}
+
+	std::vector<std::uint32_t> order(n_clusters);
+	std::iota(order.begin(), order.end(), 0);
+
+	std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b)
+	{
+		return sort_keys[a] > sort_keys[b];
+	});
+
+	std::vector<std::uint32_t> output;
+	output.reserve(indices.size());
+
+	for (std::uint32_t c : order)
+	{
+		output.insert(
+			output.end(),
+			indices.begin() + clusters[c] * 3,
+			indices.begin() + clusters[c + 1] * 3);
+	}
+
+	assert(output.size() == indices.size());
+
+	indices.swap(output);
+}
+
+MeshOptimizer::VertexCacheStatistics MeshOptimizer::analyzeVertexCache(
+	std::vector<std::uint32_t> const& indices,
+	std::uint32_t vertex_count,
+	std::uint32_t cache_size)
+{
+	VertexCacheStatistics statistics;
+
+	// A vertex is still cached while fewer than cache_size misses happened
+	// since it was last loaded.
+	std::vector<std::uint32_t> load_times(vertex_count, 0);
+	std::uint32_t time = cache_size + 1;
+
+	std::vector<bool> referenced(vertex_count, false);
+	std::uint32_t unique_vertices = 0;
+
+	for (std::uint32_t index : indices)
+	{
+		if (time - load_times[index] > cache_size)
+		{
+			load_times[index] = time++;
+			++statistics.vertices_transformed;
+		}
+
+		if (!referenced[index])
+		{
+			referenced[index] = true;
+			++unique_vertices;
+		}
+	}
+
+	std::size_t n_tris = indices.size() / 3;
+
+	if (n_tris > 0)
+	{
+		statistics.acmr = (float)statistics.vertices_transformed / n_tris;
+	}
+
+	if (unique_vertices > 0)
+	{
+		statistics.atvr = (float)statistics.vertices_transformed / unique_vertices;
+	}
+
+	return statistics;
+}
+
+MeshOptimizer::VertexCacheStatistics MeshOptimizer::analyzeVertexCache(
+	GeometryGenerator::MeshData const& mesh_data,
+	std::uint32_t cache_size)
+{
+	return analyzeVertexCache(
+		mesh_data.indices_32,
+		(std::uint32_t)mesh_data.vertices.size(),
+		cache_size);
+}
+
+MeshOptimizer::OverdrawStatistics MeshOptimizer::analyzeOverdraw(
+	GeometryGenerator::MeshData const& mesh_data,
+	std::uint32_t n_directions,
+	std::uint32_t resolution)
+{
+	OverdrawStatistics statistics;
+
+	if (mesh_data.vertices.empty() || mesh_data.indices_32.empty())
+	{
+		return statistics;
+	}
+
+	DepthRasterizer rasterizer(resolution);
+
+	std::vector<XMFLOAT3> projected(mesh_data.vertices.size());
+
+	for (std::uint32_t d = 0; d < n_directions; ++d)
+	{
+		// Fibonacci sphere, so the views are spread evenly.
+		float y = 1.0f - 2.0f * (d + 0.5f) / n_directions;
+		float r = sqrtf(std::max(0.0f, 1.0f - y * y));
+		float theta = d * XM_PI * (3.0f - sqrtf(5.0f));
+
+		XMVECTOR forward = XMVectorSet(r * cosf(theta), y, r * sinf(theta), 0.0f);
+		XMVECTOR up = fabsf(y) < 0.99f ? XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) : XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+		XMVECTOR right = XMVector3Normalize(XMVector3Cross(up, forward));
+		up = XMVector3Cross(forward, right);
+
+		XMFLOAT3 min_p(FLT_MAX, FLT_MAX, FLT_MAX);
+		XMFLOAT3 max_p(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+		for (std::size_t v = 0; v < mesh_data.vertices.size(); ++v)
+		{
+			XMVECTOR p = XMLoadFloat3(&mesh_data.vertices[v].position);
+
+			projected[v] = XMFLOAT3(
+				XMVectorGetX(XMVector3Dot(p, right)),
+				XMVectorGetX(XMVector3Dot(p, up)),
+				XMVectorGetX(XMVector3Dot(p, forward)));
+
+			min_p.x = std::min(min_p.x, projected[v].x);
+			min_p.y = std::min(min_p.y, projected[v].y);
+			max_p.x = std::max(max_p.x, projected[v].x);
+			max_p.y = std::max(max_p.y, projected[v].y);
+		}
+
+		float extent = std::max(max_p.x - min_p.x, max_p.y - min_p.y);
+		float scale = extent > 0.0f ? resolution / extent : 0.0f;
+
+		for (auto& p : projected)
+		{
+			p.x = (p.x - min_p.x) * scale;
+			p.y = (p.y - min_p.y) * scale;
+		}
+
+		rasterizer.clear();
+
+		for (std::size_t i = 0; i + 2 < mesh_data.indices_32.size(); i += 3)
+		{
+			std::uint32_t i0 = mesh_data.indices_32[i + 0];
+			std::uint32_t i1 = mesh_data.indices_32[i + 1];
+			std::uint32_t i2 = mesh_data.indices_32[i + 2];
+
+			XMVECTOR p0 = XMLoadFloat3(&mesh_data.vertices[i0].position);
+			XMVECTOR p1 = XMLoadFloat3(&mesh_data.vertices[i1].position);
+			XMVECTOR p2 = XMLoadFloat3(&mesh_data.vertices[i2].position);
+
+			// Clockwise triangles are front facing, so (p1 - p0) x (p2 - p0)
+			// points towards the viewer.
+			XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+
+			if (XMVectorGetX(XMVector3Dot(n, forward)) >= 0.0f)
+			{
+				continue;
+			}
+
+			statistics.pixels_shaded += rasterizer.drawTriangle(projected[i0], projected[i1], projected[i2]);
+		}
+
+		statistics.pixels_covered += rasterizer.coveredPixels();
+	}
+
+	if (statistics.pixels_covered > 0)
+	{
+		statistics.overdraw = (float)statistics.pixels_shaded / statistics.pixels_covered;
+	}
+
+	return statistics;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "geometryGenerator.hpp"
+
+#include <cstdint>
+#include <vector>
+
+class MeshOptimizer
+{
+public:
+	struct VertexCacheStatistics
+	{
+		std::uint32_t vertices_transformed = 0;
+
+		// Average cache miss ratio: transformed vertices per triangle.
+		float acmr = 0.0f;
+
+		// Average transform to vertex ratio: 1.0 is the best possible.
+		float atvr = 0.0f;
+	};
+
+	struct OverdrawStatistics
+	{
+		std::uint64_t pixels_covered = 0;
+		std::uint64_t pixels_shaded = 0;
+
+		// Shaded fragments per covered pixel: 1.0 means no overdraw.
+		float overdraw = 0.0f;
+	};
+
+	// Reorders triangles for the post-transform vertex cache, following
+	// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+	void optimizeVertexCache(GeometryGenerator::MeshData& mesh_data);
+
+	// Renumbers vertices in the order the index buffer first uses them, so
+	// vertex fetches walk the vertex buffer mostly sequentially. Vertices
+	// the index buffer never references are moved to the end.
+	void optimizeVertexFetch(GeometryGenerator::MeshData& mesh_data);
+
+	// Splits an already cache-optimized index buffer into clusters and
+	// draws the clusters that face away from the mesh center first, so they
+	// occlude the rest (Sander et al., "Fast Triangle Reordering for Vertex
+	// Locality and Reduced Overdraw"). threshold bounds how much worse the
+	// ACMR may get in exchange for smaller clusters: 1.05 allows 5%.
+	void optimizeOverdraw(GeometryGenerator::MeshData& mesh_data, float threshold = 1.05f);
+
+	// Simulates a FIFO post-transform cache of cache_size entries.
+	VertexCacheStatistics analyzeVertexCache(
+		std::vector<std::uint32_t> const& indices,
+		std::uint32_t vertex_count,
+		std::uint32_t cache_size = 16);
+
+	VertexCacheStatistics analyzeVertexCache(
+		GeometryGenerator::MeshData const& mesh_data,
+		std::uint32_t cache_size = 16);
+
+	// Rasterizes the mesh with back-face culling and a depth test from
+	// n_directions orthographic views spread over the sphere, into a
+	// resolution x resolution depth buffer per view.
+	OverdrawStatistics analyzeOverdraw(
+		GeometryGenerator::MeshData const& mesh_data,
+		std::uint32_t n_directions = 16,
+		std::uint32_t resolution = 256);
+};
@@ -0,0 +1,612 @@
+#include "meshSimplifier.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+using namespace DirectX;
+
+namespace
+{
+	std::uint32_t const invalid_index = ~0u;
+
+	// Collapses may not turn a surviving triangle by more than about 60
+	// degrees, stored as the squared cosine.
+	float const max_normal_turn_cos_sq = 0.25f;
+
+	// sum(w * (n.p + d)^2) over the accumulated planes, stored as the
+	// symmetric matrix A = sum(w * n * n^T), b = sum(w * d * n) and
+	// c = sum(w * d^2), so that error(p) = p^T A p + 2 b.p + c.
+	struct Quadric
+	{
+		float a00 = 0.0f, a11 = 0.0f, a22 = 0.0f;
+		float a01 = 0.0f, a02 = 0.0f, a12 = 0.0f;
+		float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f;
+		float c = 0.0f;
+		float w = 0.0f;
+
+		void addPlane(XMFLOAT3 const& n, float d, float weight)
+		{
+			a00 += weight * n.x * n.x;
+			a11 += weight * n.y * n.y;
+			a22 += weight * n.z * n.z;
+			a01 += weight * n.x * n.y;
+			a02 += weight * n.x * n.z;
+			a12 += weight * n.y * n.z;
+			b0 += weight * n.x * d;
+			b1 += weight * n.y * d;
+			b2 += weight * n.z * d;
+			c += weight * d * d;
+			w += weight;
+		}
+
+		Quadric& operator+=(Quadric const& q)
+		{
+			a00 += q.a00; a11 += q.a11; a22 += q.a22;
+			a01 += q.a01; a02 += q.a02; a12 += q.a12;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2;
+			c += q.c;
+			w += q.w;
+
+			return *this;
+		}
+
+		// Area weighted mean of the squared distances to the planes.
+		float error(XMFLOAT3 const& p) const
+		{
+			float rx = a00 * p.x + a01 * p.y + a02 * p.z;
+			float ry = a01 * p.x + a11 * p.y + a12 * p.z;
+			float rz = a02 * p.x + a12 * p.y + a22 * p.z;
+
+			float r = p.x * rx + p.y * ry + p.z * rz
+				+ 2.0f * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+
+			return w > 0.0f ? fabsf(r) / w : fabsf(r);
+		}
+	};
+
+	struct Collapse
+	{
+		std::uint32_t from;
+		std::uint32_t to;
+		float error;
+	};
+
+	// Errors are never negative, so their bit patterns sort like the floats
+	// themselves: three stable 11 bit counting passes sort by error.
+	void sortByError(std::vector<Collapse>& collapses, std::vector<Collapse>& scratch)
+	{
+		scratch.resize(collapses.size());
+
+		for (std::uint32_t shift = 0; shift < 32; shift += 11)
+		{
+			std::uint32_t histogram[2048] = {};
+
+			auto digit = [shift](Collapse const& collapse)
+			{
+				std::uint32_t key;
+				std::memcpy(&key, &collapse.error, sizeof(key));
+
+				return (key >> shift) & 2047;
+			};
+
+			for (auto const& collapse : collapses)
+			{
+				++histogram[digit(collapse)];
+			}
+
+			std::uint32_t sum = 0;
+
+			for (auto& count : histogram)
+			{
+				std::uint32_t c = count;
+				count = sum;
+				sum += c;
+			}
+
+			for (auto const& collapse : collapses)
+			{
+				scratch[histogram[digit(collapse)]++] = collapse;
+			}
+
+			collapses.swap(scratch);
+		}
+	}
+
+	// Triangles around each vertex, as offsets into one flat list.
+	struct Adjacency
+	{
+		std::vector<std::uint32_t> offsets;
+		std::vector<std::uint32_t> triangles;
+
+		void build(std::vector<std::uint32_t> const& indices, std::vector<std::uint32_t> const& remap)
+		{
+			offsets.assign(remap.size() + 1, 0);
+			triangles.resize(indices.size());
+
+			for (auto index : indices)
+			{
+				++offsets[remap[index] + 1];
+			}
+
+			std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+			std::vector<std::uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+
+			for (std::size_t i = 0; i < indices.size(); ++i)
+			{
+				triangles[cursor[remap[indices[i]]]++] = static_cast<std::uint32_t>(i / 3);
+			}
+		}
+
+		std::uint32_t const* begin(std::uint32_t vertex) const
+		{
+			return triangles.data() + offsets[vertex];
+		}
+
+		std::uint32_t const* end(std::uint32_t vertex) const
+		{
+			return triangles.data() + offsets[vertex + 1];
+		}
+	};
+
+	// Maps every vertex to the first vertex with the same position, or with
+	// the same position and attributes when compare_attributes is set.
+	std::vector<std::uint32_t> buildRemap(
+		std::vector<GeometryGenerator::Vertex> const& vertices,
+		bool compare_attributes)
+	{
+		std::size_t table_size = 1;
+
+		while (table_size < vertices.size() * 2)
+		{
+			table_size *= 2;
+		}
+
+		std::vector<std::uint32_t> table(table_size, invalid_index);
+		std::vector<std::uint32_t> remap(vertices.size());
+
+		auto bits = [](float f)
+		{
+			// Adding zero folds -0 into +0.
+			f += 0.0f;
+
+			std::uint32_t u;
+			std::memcpy(&u, &f, sizeof(u));
+
+			return u;
+		};
+
+		auto equal = [&](GeometryGenerator::Vertex const& a, GeometryGenerator::Vertex const& b)
+		{
+			if (a.position.x != b.position.x || a.position.y != b.position.y || a.position.z != b.position.z)
+			{
+				return false;
+			}
+
+			return !compare_attributes ||
+				(a.normal.x == b.normal.x && a.normal.y == b.normal.y && a.normal.z == b.normal.z &&
+				a.tangent_u.x == b.tangent_u.x && a.tangent_u.y == b.tangent_u.y && a.tangent_u.z == b.tangent_u.z &&
+				a.tex_c.x == b.tex_c.x && a.tex_c.y == b.tex_c.y);
+		};
+
+		for (std::uint32_t i = 0; i < vertices.size(); ++i)
+		{
+			XMFLOAT3 const& p = vertices[i].position;
+
+			std::uint32_t hash =
+				(bits(p.x) * 73856093u) ^ (bits(p.y) * 19349663u) ^ (bits(p.z) * 83492791u);
+
+			std::size_t slot = (hash ^ (hash >> 16)) & (table_size - 1);
+
+			while (true)
+			{
+				std::uint32_t candidate = table[slot];
+
+				if (candidate == invalid_index)
+				{
+					table[slot] = i;
+					remap[i] = i;
+					break;
+				}
+
+				if (equal(vertices[i], vertices[candidate]))
+				{
+					remap[i] = candidate;
+					break;
+				}
+
+				slot = (slot + 1) & (table_size - 1);
+			}
+		}
+
+		return remap;
+	}
+
+	XMFLOAT3 triangleNormal(XMFLOAT3 const& p0, XMFLOAT3 const& p1, XMFLOAT3 const& p2)
+	{
+		float e1x = p1.x - p0.x, e1y = p1.y - p0.y, e1z = p1.z - p0.z;
+		float e2x = p2.x - p0.x, e2y = p2.y - p0.y, e2z = p2.z - p0.z;
+
+		return XMFLOAT3(
+			e1y * e2z - e1z * e2y,
+			e1z * e2x - e1x * e2z,
+			e1x * e2y - e1y * e2x);
+	}
+}
+
+std::vector<std::uint32_t> MeshSimplifier::simplify(
+	std::vector<GeometryGenerator::Vertex> const& vertices,
+	std::vector<std::uint32_t> const& indices,
+	std::size_t target_index_count,
+	float target_error,
+	float* result_error)
+{
+	assert(indices.size() % 3 == 0);
+
+	std::vector<std::uint32_t> result = indices;
+	float max_error = 0.0f;
+
+	if (result.size() <= target_index_count || vertices.empty())
+	{
+		if (result_error)
+		{
+			*result_error = 0.0f;
+		}
+
+		return result;
+	}
+
+	std::uint32_t vertex_count = static_cast<std::uint32_t>(vertices.size());
+
+	// Errors are measured in a copy scaled to the unit cube, which keeps
+	// the quadrics well conditioned and makes target_error relative.
+	XMFLOAT3 p_min(FLT_MAX, FLT_MAX, FLT_MAX);
+	XMFLOAT3 p_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	for (auto const& v : vertices)
+	{
+		p_min.x = std::min(p_min.x, v.position.x);
+		p_min.y = std::min(p_min.y, v.position.y);
+		p_min.z = std::min(p_min.z, v.position.z);
+		p_max.x = std::max(p_max.x, v.position.x);
+		p_max.y = std::max(p_max.y, v.position.y);
+		p_max.z = std::max(p_max.z, v.position.z);
+	}
+
+	float extent = std::max(p_max.x - p_min.x, std::max(p_max.y - p_min.y, p_max.z - p_min.z));
+	float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+	std::vector<XMFLOAT3> positions(vertex_count);
+
+	for (std::uint32_t i = 0; i < vertex_count; ++i)
+	{
+		positions[i] = XMFLOAT3(
+			(vertices[i].position.x - p_min.x) * scale,
+			(vertices[i].position.y - p_min.y) * scale,
+			(vertices[i].position.z - p_min.z) * scale);
+	}
+
+	// Exact duplicates (as left by GeometryGenerator::SubdivisionMode::Split)
+	// are drawn identically, so the result indexes the first copy only.
+	std::vector<std::uint32_t> duplicate_remap = buildRemap(vertices, true);
+
+	for (auto& index : result)
+	{
+		index = duplicate_remap[index];
+	}
+
+	std::vector<std::uint32_t> remap = buildRemap(vertices, false);
+
+	// Locking is decided per position: every position more than one
+	// referenced vertex shares (a seam) and both ends of every edge without
+	// a twin stay where they are.
+	std::vector<std::uint32_t> first_referenced(vertex_count, invalid_index);
+	std::vector<std::uint8_t> locked(vertex_count, 0);
+
+	for (auto index : result)
+	{
+		std::uint32_t& first = first_referenced[remap[index]];
+
+		if (first == invalid_index)
+		{
+			first = index;
+		}
+		else if (first != index)
+		{
+			locked[remap[index]] = 1;
+		}
+	}
+
+	Adjacency adjacency;
+	adjacency.build(result, remap);
+
+	for (std::size_t t = 0; t < result.size(); t += 3)
+	{
+		for (std::uint32_t k = 0; k < 3; ++k)
+		{
+			std::uint32_t a = remap[result[t + k]];
+			std::uint32_t b = remap[result[t + (k + 1) % 3]];
+
+			bool twin = false;
+
+			for (auto it = adjacency.begin(b); it != adjacency.end(b) && !twin; ++it)
+			{
+				std::uint32_t const* triangle = &result[*it * 3];
+
+				for (std::uint32_t j = 0; j < 3; ++j)
+				{
+					if (remap[triangle[j]] == b && remap[triangle[(j + 1) % 3]] == a)
+					{
+						twin = true;
+						break;
+					}
+				}
+			}
+
+			if (!twin)
+			{
+				locked[a] = 1;
+				locked[b] = 1;
+			}
+		}
+	}
+
+	std::vector<Quadric> quadrics(vertex_count);
+
+	for (std::size_t t = 0; t < result.size(); t += 3)
+	{
+		XMFLOAT3 const& p0 = positions[result[t + 0]];
+		XMFLOAT3 n = triangleNormal(p0, positions[result[t + 1]], positions[result[t + 2]]);
+
+		float length = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+
+		if (length == 0.0f)
+		{
+			continue;
+		}
+
+		n = XMFLOAT3(n.x / length, n.y / length, n.z / length);
+		float d = -(n.x * p0.x + n.y * p0.y + n.z * p0.z);
+
+		for (std::uint32_t k = 0; k < 3; ++k)
+		{
+			quadrics[remap[result[t + k]]].addPlane(n, d, 0.5f * length);
+		}
+	}
+
+	float error_limit = target_error * target_error;
+
+	std::vector<Collapse> collapses;
+	std::vector<Collapse> scratch;
+	std::vector<std::uint32_t> collapse_remap(vertex_count);
+	std::vector<std::uint8_t> touched(vertex_count);
+
+	// Each pass sorts every possible collapse by error and performs the
+	// cheapest ones, at most one per vertex, before compacting the index
+	// buffer and starting over with the merged quadrics.
+	while (result.size() > target_index_count)
+	{
+		adjacency.build(result, remap);
+
+		collapses.clear();
+
+		for (std::size_t t = 0; t < result.size(); t += 3)
+		{
+			for (std::uint32_t k = 0; k < 3; ++k)
+			{
+				std::uint32_t v0 = result[t + k];
+				std::uint32_t v1 = result[t + (k + 1) % 3];
+
+				std::uint32_t c0 = remap[v0];
+				std::uint32_t c1 = remap[v1];
+
+				// Interior edges show up once in each direction.
+				if (c0 >= c1 || (locked[c0] && locked[c1]))
+				{
+					continue;
+				}
+
+				Quadric q = quadrics[c0];
+				q += quadrics[c1];
+
+				float e01 = locked[c0] ? FLT_MAX : q.error(positions[v1]);
+				float e10 = locked[c1] ? FLT_MAX : q.error(positions[v0]);
+
+				if (e01 <= e10)
+				{
+					collapses.push_back({ v0, v1, e01 });
+				}
+				else
+				{
+					collapses.push_back({ v1, v0, e10 });
+				}
+			}
+		}
+
+		sortByError(collapses, scratch);
+
+		std::iota(collapse_remap.begin(), collapse_remap.end(), 0);
+		std::fill(touched.begin(), touched.end(), 0);
+
+		std::size_t triangle_count = result.size() / 3;
+		std::size_t target_triangle_count = target_index_count / 3;
+		std::size_t performed = 0;
+
+		for (auto const& collapse : collapses)
+		{
+			if (collapse.error > error_limit || triangle_count <= target_triangle_count)
+			{
+				break;
+			}
+
+			std::uint32_t from = remap[collapse.from];
+			std::uint32_t to = remap[collapse.to];
+
+			if (touched[from] || touched[to])
+			{
+				continue;
+			}
+
+			// Triangles around from that survive must not turn over, and
+			// the ones sharing the edge disappear. Corners go through
+			// collapse_remap so earlier collapses of this pass are seen.
+			bool flips = false;
+			std::size_t removed = 0;
+
+			for (auto it = adjacency.begin(from); it != adjacency.end(from); ++it)
+			{
+				std::uint32_t corners[3];
+
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					corners[k] = collapse_remap[result[*it * 3 + k]];
+				}
+
+				std::uint32_t c0 = remap[corners[0]];
+				std::uint32_t c1 = remap[corners[1]];
+				std::uint32_t c2 = remap[corners[2]];
+
+				if (c0 == c1 || c1 == c2 || c2 == c0)
+				{
+					continue;
+				}
+
+				if (c0 == to || c1 == to || c2 == to)
+				{
+					++removed;
+					continue;
+				}
+
+				XMFLOAT3 n_before = triangleNormal(
+					positions[corners[0]], positions[corners[1]], positions[corners[2]]);
+
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					if (corners[k] == collapse.from)
+					{
+						corners[k] = collapse.to;
+					}
+				}
+
+				XMFLOAT3 n_after = triangleNormal(
+					positions[corners[0]], positions[corners[1]], positions[corners[2]]);
+
+				float dot = n_before.x * n_after.x + n_before.y * n_after.y + n_before.z * n_after.z;
+				float length_before = n_before.x * n_before.x + n_before.y * n_before.y + n_before.z * n_before.z;
+				float length_after = n_after.x * n_after.x + n_after.y * n_after.y + n_after.z * n_after.z;
+
+				if (dot <= 0.0f || dot * dot < max_normal_turn_cos_sq * length_before * length_after)
+				{
+					flips = true;
+					break;
+				}
+			}
+
+			if (flips)
+			{
+				continue;
+			}
+
+			collapse_remap[collapse.from] = collapse.to;
+			quadrics[to] += quadrics[from];
+
+			touched[from] = 1;
+			touched[to] = 1;
+
+			triangle_count -= std::min(removed, triangle_count);
+			max_error = std::max(max_error, collapse.error);
+			++performed;
+		}
+
+		if (performed == 0)
+		{
+			break;
+		}
+
+		std::size_t write = 0;
+
+		for (std::size_t t = 0; t < result.size(); t += 3)
+		{
+			std::uint32_t i0 = collapse_remap[result[t + 0]];
+			std::uint32_t i1 = collapse_remap[result[t + 1]];
+			std::uint32_t i2 = collapse_remap[result[t + 2]];
+
+			if (remap[i0] == remap[i1] || remap[i1] == remap[i2] || remap[i2] == remap[i0])
+			{
+				continue;
+			}
+
+			result[write++] = i0;
+			result[write++] = i1;
+			result[write++] = i2;
+		}
+
+		result.resize(write);
+	}
+
+	if (result_error)
+	{
+		*result_error = sqrtf(max_error);
+	}
+
+	return result;
+}
+
+MeshSimplifier::LodChain MeshSimplifier::buildLodChain(
+	GeometryGenerator::MeshData const& mesh_data,
+	std::uint32_t n_levels,
+	float reduction,
+	float target_error)
+{
+	assert(reduction > 0.0f && reduction < 1.0f);
+
+	LodChain chain;
+	chain.mesh_data.vertices = mesh_data.vertices;
+	chain.mesh_data.indices_32 = mesh_data.indices_32;
+
+	if (n_levels == 0)
+	{
+		chain.mesh_data.indices_32.clear();
+		return chain;
+	}
+
+	LodLevel level;
+	level.index_count = static_cast<std::uint32_t>(mesh_data.indices_32.size());
+	chain.levels.push_back(level);
+
+	std::vector<std::uint32_t> level_indices = mesh_data.indices_32;
+
+	for (std::uint32_t i = 1; i < n_levels; ++i)
+	{
+		std::size_t target_index_count =
+			static_cast<std::size_t>(level_indices.size() / 3 * reduction) * 3;
+
+		float step_error = 0.0f;
+
+		std::vector<std::uint32_t> next = simplify(
+			mesh_data.vertices, level_indices, target_index_count, target_error, &step_error);
+
+		// Nothing left to collapse within target_error.
+		if (next.size() == level_indices.size())
+		{
+			break;
+		}
+
+		// Every level is simplified from the previous one, so the sum of the
+		// step errors bounds the distance to the original mesh.
+		level.start_index_location = static_cast<std::uint32_t>(chain.mesh_data.indices_32.size());
+		level.index_count = static_cast<std::uint32_t>(next.size());
+		level.error += step_error;
+		chain.levels.push_back(level);
+
+		chain.mesh_data.indices_32.insert(chain.mesh_data.indices_32.end(), next.begin(), next.end());
+
+		level_indices = std::move(next);
+	}
+
+	return chain;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "geometryGenerator.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Edge collapse simplification driven by quadric error metrics (Garland and
+// Heckbert). Vertices only ever collapse onto other existing vertices, so
+// every level of detail indexes the original vertex buffer. Vertices on an
+// open border or on an attribute seam (several vertices sharing a position,
+// as along the UV seam of createSphere) are locked, which keeps borders and
+// seams intact.
+class MeshSimplifier
+{
+public:
+	// Mirrors SubmeshGeometry, so each level can be registered in
+	// Mesh::draw_args and drawn out of one vertex and one index buffer.
+	struct LodLevel
+	{
+		std::uint32_t index_count = 0;
+		std::uint32_t start_index_location = 0;
+		std::int32_t base_vertex_location = 0;
+
+		// Reached error, relative to the extent of the mesh.
+		float error = 0.0f;
+	};
+
+	struct LodChain
+	{
+		// Original vertices and the index buffers of all the levels, one
+		// after the other.
+		GeometryGenerator::MeshData mesh_data;
+		std::vector<LodLevel> levels;
+	};
+
+	// Collapses edges of indices, cheapest first, until at most
+	// target_index_count indices are left or the next collapse would exceed
+	// target_error (relative to the extent of the mesh).
+	std::vector<std::uint32_t> simplify(
+		std::vector<GeometryGenerator::Vertex> const& vertices,
+		std::vector<std::uint32_t> const& indices,
+		std::size_t target_index_count,
+		float target_error,
+		float* result_error = nullptr);
+
+	// Level 0 is mesh_data itself; every following level is simplified from
+	// the previous one down to reduction times its triangle count.
+	LodChain buildLodChain(
+		GeometryGenerator::MeshData const& mesh_data,
+		std::uint32_t n_levels,
+		float reduction = 0.5f,
+		float target_error = 0.05f);
+};
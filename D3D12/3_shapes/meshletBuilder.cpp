@@ -0,0 +1,217 @@
+#include "meshletBuilder.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+MeshletBuilder::MeshletData MeshletBuilder::build(
+	GeometryGenerator::MeshData const& mesh_data,
+	std::uint32_t vertex_limit,
+	std::uint32_t triangle_limit)
+{
+	assert(vertex_limit >= 3 && vertex_limit <= 256);
+	assert(triangle_limit >= 1);
+
+	MeshletData meshlet_data;
+
+	std::uint32_t n_tris = (std::uint32_t)mesh_data.indices_32.size() / 3;
+
+	// Local index of every mesh vertex in the meshlet being filled.
+	std::vector<std::uint8_t> local_indices(mesh_data.vertices.size());
+	std::vector<std::uint32_t> owners(mesh_data.vertices.size(), ~0u);
+
+	Meshlet meshlet;
+
+	auto flush = [&]()
+	{
+		if (meshlet.triangle_count == 0)
+		{
+			return;
+		}
+
+		meshlet_data.meshlets.push_back(meshlet);
+
+		meshlet.vertex_offset += meshlet.vertex_count;
+		meshlet.triangle_offset += meshlet.triangle_count * 3;
+		meshlet.vertex_count = 0;
+		meshlet.triangle_count = 0;
+	};
+
+	for (std::uint32_t t = 0; t < n_tris; ++t)
+	{
+		std::uint32_t const* triangle = &mesh_data.indices_32[t * 3];
+
+		std::uint32_t meshlet_index = (std::uint32_t)meshlet_data.meshlets.size();
+		std::uint32_t new_vertices = 0;
+
+		for (std::uint32_t k = 0; k < 3; ++k)
+		{
+			bool seen = owners[triangle[k]] == meshlet_index;
+
+			for (std::uint32_t j = 0; j < k; ++j)
+			{
+				seen = seen || triangle[j] == triangle[k];
+			}
+
+			new_vertices += seen ? 0 : 1;
+		}
+
+		if (meshlet.vertex_count + new_vertices > vertex_limit ||
+			meshlet.triangle_count + 1 > triangle_limit)
+		{
+			flush();
+			meshlet_index = (std::uint32_t)meshlet_data.meshlets.size();
+		}
+
+		for (std::uint32_t k = 0; k < 3; ++k)
+		{
+			std::uint32_t v = triangle[k];
+
+			if (owners[v] != meshlet_index)
+			{
+				owners[v] = meshlet_index;
+				local_indices[v] = (std::uint8_t)meshlet.vertex_count++;
+
+				meshlet_data.meshlet_vertices.push_back(v);
+			}
+
+			meshlet_data.meshlet_triangles.push_back(local_indices[v]);
+		}
+
+		++meshlet.triangle_count;
+	}
+
+	flush();
+
+	meshlet_data.bounds.reserve(meshlet_data.meshlets.size());
+
+	for (auto const& m : meshlet_data.meshlets)
+	{
+		meshlet_data.bounds.push_back(computeBounds(mesh_data, meshlet_data, m));
+	}
+
+	return meshlet_data;
+}
+
+MeshletBuilder::MeshletBounds MeshletBuilder::computeBounds(
+	GeometryGenerator::MeshData const& mesh_data,
+	MeshletData const& meshlet_data,
+	Meshlet const& meshlet)
+{
+	MeshletBounds bounds;
+
+	auto position = [&](std::uint32_t local_index)
+	{
+		std::uint32_t v = meshlet_data.meshlet_vertices[meshlet.vertex_offset + local_index];
+		return XMLoadFloat3(&mesh_data.vertices[v].position);
+	};
+
+	// Bounding sphere around the box of the meshlet vertices.
+	XMVECTOR min_p = position(0);
+	XMVECTOR max_p = min_p;
+
+	for (std::uint32_t i = 1; i < meshlet.vertex_count; ++i)
+	{
+		min_p = XMVectorMin(min_p, position(i));
+		max_p = XMVectorMax(max_p, position(i));
+	}
+
+	XMVECTOR center = 0.5f * (min_p + max_p);
+	float radius = 0.0f;
+
+	for (std::uint32_t i = 0; i < meshlet.vertex_count; ++i)
+	{
+		radius = std::max(radius, XMVectorGetX(XMVector3Length(position(i) - center)));
+	}
+
+	XMStoreFloat3(&bounds.center, center);
+	bounds.radius = radius;
+
+	// Normal cone: the average triangle normal, opened just enough to
+	// contain every triangle normal.
+	std::uint8_t const* triangles = &meshlet_data.meshlet_triangles[meshlet.triangle_offset];
+
+	std::vector<XMVECTOR> normals(meshlet.triangle_count);
+	std::vector<XMVECTOR> corners(meshlet.triangle_count);
+
+	XMVECTOR axis = XMVectorZero();
+
+	for (std::uint32_t t = 0; t < meshlet.triangle_count; ++t)
+	{
+		XMVECTOR p0 = position(triangles[t * 3 + 0]);
+		XMVECTOR p1 = position(triangles[t * 3 + 1]);
+		XMVECTOR p2 = position(triangles[t * 3 + 2]);
+
+		normals[t] = XMVector3Normalize(XMVector3Cross(p1 - p0, p2 - p0));
+		corners[t] = p0;
+
+		axis += normals[t];
+	}
+
+	axis = XMVector3Normalize(axis);
+
+	float min_dot = 1.0f;
+
+	for (std::uint32_t t = 0; t < meshlet.triangle_count; ++t)
+	{
+		min_dot = std::min(min_dot, XMVectorGetX(XMVector3Dot(axis, normals[t])));
+	}
+
+	// Past ~85 degrees the cone can hardly ever reject the meshlet and the
+	// apex below moves off to infinity.
+	if (min_dot <= 0.1f)
+	{
+		return bounds;
+	}
+
+	// Apex on the axis behind every triangle plane, so that any viewer
+	// inside the cone sees all the triangles from behind.
+	float max_t = 0.0f;
+
+	for (std::uint32_t t = 0; t < meshlet.triangle_count; ++t)
+	{
+		float dc = XMVectorGetX(XMVector3Dot(center - corners[t], normals[t]));
+		float dn = XMVectorGetX(XMVector3Dot(axis, normals[t]));
+
+		max_t = std::max(max_t, dc / dn);
+	}
+
+	XMStoreFloat3(&bounds.cone_apex, center - axis * max_t);
+	XMStoreFloat3(&bounds.cone_axis, axis);
+	bounds.cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+
+	return bounds;
+}
+
+void MeshletBuilder::cull(
+	MeshletData const& meshlet_data,
+	Frustum const& frustum,
+	XMFLOAT3 const& camera_position,
+	std::vector<std::uint32_t>& visible)
+{
+	XMVECTOR camera = XMLoadFloat3(&camera_position);
+
+	for (std::uint32_t i = 0; i < meshlet_data.bounds.size(); ++i)
+	{
+		MeshletBounds const& bounds = meshlet_data.bounds[i];
+
+		if (!frustum.intersectsSphere(bounds.center, bounds.radius))
+		{
+			continue;
+		}
+
+		if (bounds.cone_cutoff < 1.0f)
+		{
+			XMVECTOR view = XMVector3Normalize(XMLoadFloat3(&bounds.cone_apex) - camera);
+
+			if (XMVectorGetX(XMVector3Dot(view, XMLoadFloat3(&bounds.cone_axis))) >= bounds.cone_cutoff)
+			{
+				continue;
+			}
+		}
+
+		visible.push_back(i);
+	}
+}
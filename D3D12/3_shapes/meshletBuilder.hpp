@@ -0,0 +1,70 @@
+#pragma once
+
+#include "frustum.hpp"
+#include "geometryGenerator.hpp"
+
+#include <cstdint>
+#include <vector>
+
+class MeshletBuilder
+{
+public:
+	static std::uint32_t const max_vertices = 64;
+	static std::uint32_t const max_triangles = 124;
+
+	struct Meshlet
+	{
+		std::uint32_t vertex_offset = 0;
+		std::uint32_t triangle_offset = 0;
+		std::uint32_t vertex_count = 0;
+		std::uint32_t triangle_count = 0;
+	};
+
+	// A meshlet is back facing for every viewer at position p when
+	// dot(normalize(cone_apex - p), cone_axis) >= cone_cutoff. Meshlets too
+	// curved to be culled this way have cone_cutoff = 1.
+	struct MeshletBounds
+	{
+		DirectX::XMFLOAT3 center = { 0.0f, 0.0f, 0.0f };
+		float radius = 0.0f;
+
+		DirectX::XMFLOAT3 cone_apex = { 0.0f, 0.0f, 0.0f };
+		DirectX::XMFLOAT3 cone_axis = { 0.0f, 0.0f, 0.0f };
+		float cone_cutoff = 1.0f;
+	};
+
+	struct MeshletData
+	{
+		std::vector<Meshlet> meshlets;
+		std::vector<MeshletBounds> bounds;
+
+		// Mesh vertex indices, meshlet_vertices[meshlet.vertex_offset + i].
+		std::vector<std::uint32_t> meshlet_vertices;
+
+		// Three local vertex indices per triangle, starting at
+		// meshlet_triangles[meshlet.triangle_offset].
+		std::vector<std::uint8_t> meshlet_triangles;
+	};
+
+	// Greedily packs consecutive triangles, so feeding a cache-optimized
+	// index buffer gives meshlets with more shared vertices.
+	MeshletData build(
+		GeometryGenerator::MeshData const& mesh_data,
+		std::uint32_t vertex_limit = max_vertices,
+		std::uint32_t triangle_limit = max_triangles);
+
+	// Appends to visible the meshlets that intersect frustum and are not
+	// entirely back facing. frustum and camera_position are in the space of
+	// the mesh vertices.
+	void cull(
+		MeshletData const& meshlet_data,
+		Frustum const& frustum,
+		DirectX::XMFLOAT3 const& camera_position,
+		std::vector<std::uint32_t>& visible);
+
+private:
+	MeshletBounds computeBounds(
+		GeometryGenerator::MeshData const& mesh_data,
+		MeshletData const& meshlet_data,
+		Meshlet const& meshlet);
+};
@@ -0,0 +1,476 @@
+#include "occlusionCuller.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	// Triangles are clipped to this many viewport half sizes around the
+	// center, which keeps screen coordinates small enough for the edge
+	// functions to stay precise.
+	float const guard_band = 2.0f;
+
+	// Vertices are snapped to a 1/16 pixel grid, so a point lying exactly on
+	// an edge shared by two triangles evaluates to exactly zero for both and
+	// the top-left rule alone decides which one owns it.
+	float const subpixel_scale = 16.0f;
+
+	int const clip_plane_count = 5;
+
+	// Inside when dot(plane, clip position) >= 0.
+	XMFLOAT4 const clip_planes[clip_plane_count] =
+	{
+		XMFLOAT4(0.0f, 0.0f, 1.0f, 0.0f),
+		XMFLOAT4(1.0f, 0.0f, 0.0f, guard_band),
+		XMFLOAT4(-1.0f, 0.0f, 0.0f, guard_band),
+		XMFLOAT4(0.0f, 1.0f, 0.0f, guard_band),
+		XMFLOAT4(0.0f, -1.0f, 0.0f, guard_band)
+	};
+
+	float planeDistance(XMFLOAT4 const& plane, XMFLOAT4 const& v)
+	{
+		return plane.x * v.x + plane.y * v.y + plane.z * v.z + plane.w * v.w;
+	}
+
+	float snap(float x)
+	{
+		return floorf(x * subpixel_scale + 0.5f) / subpixel_scale;
+	}
+
+	std::uint32_t roundUp(std::uint32_t x, std::uint32_t multiple)
+	{
+		return (std::max(x, 1u) + multiple - 1) / multiple * multiple;
+	}
+}
+
+OcclusionCuller::OcclusionCuller(std::uint32_t width, std::uint32_t height)
+	:
+	width(roundUp(width, tile_size)),
+	height(roundUp(height, tile_size)),
+	depth(this->width * this->height, 1.0f)
+{
+	XMStoreFloat4x4(&view_proj, XMMatrixIdentity());
+
+	std::uint32_t level_width = this->width;
+	std::uint32_t level_height = this->height;
+
+	while (level_width > 1 || level_height > 1)
+	{
+		level_width = (level_width + 1) / 2;
+		level_height = (level_height + 1) / 2;
+
+		levels.push_back({ level_width, level_height, std::vector<float>(level_width * level_height, 1.0f) });
+	}
+}
+
+void OcclusionCuller::beginFrame(XMFLOAT4X4 const& view_proj)
+{
+	this->view_proj = view_proj;
+
+	std::fill(depth.begin(), depth.end(), 1.0f);
+
+	triangles_rasterized = 0;
+}
+
+void OcclusionCuller::renderOccluder(GeometryGenerator::MeshData const& mesh_data, XMFLOAT4X4 const& world)
+{
+	if (mesh_data.vertices.empty())
+	{
+		return;
+	}
+
+	renderOccluder(
+		&mesh_data.vertices[0].position,
+		sizeof(GeometryGenerator::Vertex),
+		mesh_data.indices_32,
+		world);
+}
+
+void OcclusionCuller::renderOccluder(
+	XMFLOAT3 const* positions,
+	std::size_t stride_in_bytes,
+	std::vector<std::uint32_t> const& indices,
+	XMFLOAT4X4 const& world)
+{
+	assert(indices.size() % 3 == 0);
+
+	XMMATRIX world_view_proj = XMMatrixMultiply(XMLoadFloat4x4(&world), XMLoadFloat4x4(&view_proj));
+
+	std::uint32_t vertex_count = 0;
+
+	for (auto index : indices)
+	{
+		vertex_count = std::max(vertex_count, index + 1);
+	}
+
+	clip_positions.resize(vertex_count);
+
+	auto bytes = reinterpret_cast<unsigned char const*>(positions);
+
+	for (std::uint32_t i = 0; i < vertex_count; ++i)
+	{
+		XMVECTOR position = XMLoadFloat3(reinterpret_cast<XMFLOAT3 const*>(bytes + i * stride_in_bytes));
+		XMStoreFloat4(&clip_positions[i], XMVector3Transform(position, world_view_proj));
+	}
+
+	for (std::size_t i = 0; i < indices.size(); i += 3)
+	{
+		XMFLOAT4 triangle[3] =
+		{
+			clip_positions[indices[i + 0]],
+			clip_positions[indices[i + 1]],
+			clip_positions[indices[i + 2]]
+		};
+
+		rasterizeTriangle(triangle);
+	}
+}
+
+void OcclusionCuller::rasterizeTriangle(XMFLOAT4 const* clip)
+{
+	bool needs_clipping = false;
+
+	for (auto const& plane : clip_planes)
+	{
+		int outside = 0;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			outside += planeDistance(plane, clip[i]) < 0.0f;
+		}
+
+		if (outside == 3)
+		{
+			return;
+		}
+
+		needs_clipping |= outside > 0;
+	}
+
+	// Each plane adds at most one vertex.
+	XMFLOAT4 polygons[2][3 + clip_plane_count] = { { clip[0], clip[1], clip[2] } };
+	int current = 0;
+	int count = 3;
+
+	if (needs_clipping)
+	{
+		for (auto const& plane : clip_planes)
+		{
+			XMFLOAT4 const* in = polygons[current];
+			XMFLOAT4* out = polygons[1 - current];
+			int out_count = 0;
+
+			for (int i = 0; i < count; ++i)
+			{
+				XMFLOAT4 const& a = in[i];
+				XMFLOAT4 const& b = in[(i + 1) % count];
+
+				float distance_a = planeDistance(plane, a);
+				float distance_b = planeDistance(plane, b);
+
+				if (distance_a >= 0.0f)
+				{
+					out[out_count++] = a;
+				}
+
+				if ((distance_a >= 0.0f) != (distance_b >= 0.0f))
+				{
+					float t = distance_a / (distance_a - distance_b);
+
+					XMStoreFloat4(&out[out_count++], XMVectorLerp(XMLoadFloat4(&a), XMLoadFloat4(&b), t));
+				}
+			}
+
+			current = 1 - current;
+			count = out_count;
+
+			if (count < 3)
+			{
+				return;
+			}
+		}
+	}
+
+	XMFLOAT3 screen[3 + clip_plane_count];
+
+	for (int i = 0; i < count; ++i)
+	{
+		XMFLOAT4 const& v = polygons[current][i];
+		float inv_w = 1.0f / v.w;
+
+		screen[i].x = snap((v.x * inv_w * 0.5f + 0.5f) * width);
+		screen[i].y = snap((0.5f - v.y * inv_w * 0.5f) * height);
+		screen[i].z = v.z * inv_w;
+	}
+
+	for (int i = 1; i + 1 < count; ++i)
+	{
+		rasterizeScreenTriangle(screen[0], screen[i], screen[i + 1]);
+	}
+}
+
+void OcclusionCuller::rasterizeScreenTriangle(XMFLOAT3 v0, XMFLOAT3 v1, XMFLOAT3 v2)
+{
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+
+	// D3D front faces are clockwise on screen, which with y pointing down is
+	// a positive area. Back faces of closed occluders are always hidden.
+	if (!(area > 0.0f))
+	{
+		return;
+	}
+
+	// Pixels whose center lies within the bounding rectangle.
+	int min_x = std::max(0, static_cast<int>(ceilf(std::min({ v0.x, v1.x, v2.x }) - 0.5f)));
+	int min_y = std::max(0, static_cast<int>(ceilf(std::min({ v0.y, v1.y, v2.y }) - 0.5f)));
+	int max_x = std::min(static_cast<int>(width) - 1, static_cast<int>(floorf(std::max({ v0.x, v1.x, v2.x }) - 0.5f)));
+	int max_y = std::min(static_cast<int>(height) - 1, static_cast<int>(floorf(std::max({ v0.y, v1.y, v2.y }) - 0.5f)));
+
+	if (min_x > max_x || min_y > max_y)
+	{
+		return;
+	}
+
+	++triangles_rasterized;
+
+	// Edge i runs from vertex i to the next and is positive inside:
+	// e(p) = a * (p.x - origin.x) + b * (p.y - origin.y).
+	XMFLOAT3 const* vertices[3] = { &v0, &v1, &v2 };
+
+	float edge_a[3], edge_b[3];
+	XMFLOAT2 edge_origin[3];
+	XMVECTOR top_left[3];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		XMFLOAT3 const& from = *vertices[i];
+		XMFLOAT3 const& to = *vertices[(i + 1) % 3];
+
+		edge_a[i] = from.y - to.y;
+		edge_b[i] = to.x - from.x;
+		edge_origin[i] = XMFLOAT2(from.x, from.y);
+
+		// Pixel centers exactly on a top or left edge are inside.
+		bool is_top_left = edge_a[i] > 0.0f || (edge_a[i] == 0.0f && edge_b[i] > 0.0f);
+		top_left[i] = is_top_left ? XMVectorTrueInt() : XMVectorFalseInt();
+	}
+
+	float dz_dx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+	float dz_dy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+
+	XMVECTOR const lane_offsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+	XMVECTOR const zero = XMVectorZero();
+
+	for (int tile_y = min_y / tile_size * tile_size; tile_y <= max_y; tile_y += tile_size)
+	{
+		for (int tile_x = min_x / tile_size * tile_size; tile_x <= max_x; tile_x += tile_size)
+		{
+			// Edge values at the tile's outermost pixel centers: the tile is
+			// skipped when one edge is negative at all of them, and needs no
+			// edge tests when all edges are positive at all of them.
+			float center_x0 = tile_x + 0.5f;
+			float center_x1 = center_x0 + (tile_size - 1);
+			float center_y0 = tile_y + 0.5f;
+			float center_y1 = center_y0 + (tile_size - 1);
+
+			bool rejected = false;
+			bool covered = true;
+
+			for (int i = 0; i < 3; ++i)
+			{
+				float near_x = edge_a[i] > 0.0f ? center_x1 : center_x0;
+				float far_x = edge_a[i] > 0.0f ? center_x0 : center_x1;
+				float near_y = edge_b[i] > 0.0f ? center_y1 : center_y0;
+				float far_y = edge_b[i] > 0.0f ? center_y0 : center_y1;
+
+				float edge_max = edge_a[i] * (near_x - edge_origin[i].x) + edge_b[i] * (near_y - edge_origin[i].y);
+				float edge_min = edge_a[i] * (far_x - edge_origin[i].x) + edge_b[i] * (far_y - edge_origin[i].y);
+
+				rejected |= edge_max < 0.0f;
+				covered &= edge_min > 0.0f;
+			}
+
+			if (rejected)
+			{
+				continue;
+			}
+
+			int row_begin = std::max(tile_y, min_y);
+			int row_end = std::min(tile_y + static_cast<int>(tile_size) - 1, max_y);
+
+			for (int y = row_begin; y <= row_end; ++y)
+			{
+				float center_y = y + 0.5f;
+				float* row = depth.data() + y * width;
+
+				XMVECTOR row_edge[3];
+
+				for (int i = 0; i < 3; ++i)
+				{
+					row_edge[i] = XMVectorReplicate(edge_b[i] * (center_y - edge_origin[i].y));
+				}
+
+				XMVECTOR row_z = XMVectorReplicate(v0.z + dz_dy * (center_y - v0.y));
+
+				for (int x = tile_x; x < tile_x + static_cast<int>(tile_size); x += 4)
+				{
+					if (x + 3 < min_x || x > max_x)
+					{
+						continue;
+					}
+
+					XMVECTOR center_x = XMVectorAdd(XMVectorReplicate(static_cast<float>(x)), lane_offsets);
+
+					XMVECTOR z = XMVectorMultiplyAdd(
+						XMVectorReplicate(dz_dx),
+						XMVectorSubtract(center_x, XMVectorReplicate(v0.x)),
+						row_z);
+
+					XMVECTOR inside = XMVectorTrueInt();
+
+					if (!covered)
+					{
+						for (int i = 0; i < 3; ++i)
+						{
+							XMVECTOR edge = XMVectorMultiplyAdd(
+								XMVectorReplicate(edge_a[i]),
+								XMVectorSubtract(center_x, XMVectorReplicate(edge_origin[i].x)),
+								row_edge[i]);
+
+							inside = XMVectorAndInt(inside, XMVectorSelect(
+								XMVectorGreater(edge, zero),
+								XMVectorGreaterOrEqual(edge, zero),
+								top_left[i]));
+						}
+					}
+
+					auto pixels = reinterpret_cast<XMFLOAT4*>(row + x);
+					XMVECTOR old_z = XMLoadFloat4(pixels);
+
+					XMStoreFloat4(pixels, XMVectorSelect(old_z, XMVectorMin(old_z, z), inside));
+				}
+			}
+		}
+	}
+}
+
+void OcclusionCuller::endOccluders()
+{
+	std::vector<float> const* source = &depth;
+	std::uint32_t source_width = width;
+	std::uint32_t source_height = height;
+
+	for (auto& level : levels)
+	{
+		for (std::uint32_t y = 0; y < level.height; ++y)
+		{
+			std::uint32_t y0 = 2 * y;
+			std::uint32_t y1 = std::min(y0 + 1, source_height - 1);
+
+			for (std::uint32_t x = 0; x < level.width; ++x)
+			{
+				std::uint32_t x0 = 2 * x;
+				std::uint32_t x1 = std::min(x0 + 1, source_width - 1);
+
+				level.max_depth[y * level.width + x] = std::max(
+					std::max((*source)[y0 * source_width + x0], (*source)[y0 * source_width + x1]),
+					std::max((*source)[y1 * source_width + x0], (*source)[y1 * source_width + x1]));
+			}
+		}
+
+		source = &level.max_depth;
+		source_width = level.width;
+		source_height = level.height;
+	}
+}
+
+bool OcclusionCuller::isVisible(BoundingBox const& world_bounds) const
+{
+	XMMATRIX m = XMLoadFloat4x4(&view_proj);
+
+	XMVECTOR center = XMLoadFloat3(&world_bounds.Center);
+	XMVECTOR extents = XMLoadFloat3(&world_bounds.Extents);
+
+	XMVECTOR screen_min = XMVectorReplicate(FLT_MAX);
+	XMVECTOR screen_max = XMVectorReplicate(-FLT_MAX);
+
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		XMVECTOR sign = XMVectorSet(
+			corner & 1 ? 1.0f : -1.0f,
+			corner & 2 ? 1.0f : -1.0f,
+			corner & 4 ? 1.0f : -1.0f,
+			0.0f);
+
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector3Transform(XMVectorMultiplyAdd(sign, extents, center), m));
+
+		if (clip.z < 0.0f)
+		{
+			return true;
+		}
+
+		XMVECTOR ndc = XMVectorScale(XMLoadFloat4(&clip), 1.0f / clip.w);
+
+		screen_min = XMVectorMin(screen_min, ndc);
+		screen_max = XMVectorMax(screen_max, ndc);
+	}
+
+	XMFLOAT3 ndc_min, ndc_max;
+	XMStoreFloat3(&ndc_min, screen_min);
+	XMStoreFloat3(&ndc_max, screen_max);
+
+	// Outside the viewport or beyond the far plane.
+	if (ndc_max.x < -1.0f || ndc_min.x > 1.0f || ndc_max.y < -1.0f || ndc_min.y > 1.0f || ndc_min.z > 1.0f)
+	{
+		return false;
+	}
+
+	float nearest_z = ndc_min.z;
+
+	int x0 = std::max(0, static_cast<int>(floorf((ndc_min.x * 0.5f + 0.5f) * width)));
+	int x1 = std::min(static_cast<int>(width) - 1, static_cast<int>(floorf((ndc_max.x * 0.5f + 0.5f) * width)));
+	int y0 = std::max(0, static_cast<int>(floorf((0.5f - ndc_max.y * 0.5f) * height)));
+	int y1 = std::min(static_cast<int>(height) - 1, static_cast<int>(floorf((0.5f - ndc_min.y * 0.5f) * height)));
+
+	// Coarsest level that still covers the rectangle with at most 4x4 texels.
+	std::uint32_t level = 0;
+
+	while ((x1 >> level) - (x0 >> level) > 3 || (y1 >> level) - (y0 >> level) > 3)
+	{
+		++level;
+	}
+
+	std::vector<float> const& max_depth = level == 0 ? depth : levels[level - 1].max_depth;
+	std::uint32_t level_width = level == 0 ? width : levels[level - 1].width;
+
+	for (int y = y0 >> level; y <= y1 >> level; ++y)
+	{
+		for (int x = x0 >> level; x <= x1 >> level; ++x)
+		{
+			if (max_depth[y * level_width + x] >= nearest_z)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void OcclusionCuller::cull(std::vector<BoundingBox> const& world_bounds, std::vector<std::uint32_t>& visible) const
+{
+	visible.clear();
+
+	for (std::uint32_t i = 0; i < world_bounds.size(); ++i)
+	{
+		if (isVisible(world_bounds[i]))
+		{
+			visible.push_back(i);
+		}
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "geometryGenerator.hpp"
+
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+// Software occlusion culling. Occluders (closed, low detail meshes) are
+// rasterized into a small depth buffer, which is then reduced into a
+// hierarchy of max-depth levels. Object bounds are projected to a screen
+// rectangle and nearest depth, and are hidden when every texel of a level
+// coarse enough to cover the rectangle in a few reads is nearer still.
+// Depth follows D3D: [0, 1], smaller is nearer, cleared to 1.
+class OcclusionCuller
+{
+public:
+	static std::uint32_t const tile_size = 8;
+
+	// width and height are rounded up to multiples of tile_size.
+	OcclusionCuller(std::uint32_t width = 256, std::uint32_t height = 128);
+
+	// Clears the depth buffer. view_proj is row-vector, as
+	// PassConstants::view_proj before it is transposed for HLSL.
+	void beginFrame(DirectX::XMFLOAT4X4 const& view_proj);
+
+	void renderOccluder(GeometryGenerator::MeshData const& mesh_data, DirectX::XMFLOAT4X4 const& world);
+
+	void renderOccluder(
+		DirectX::XMFLOAT3 const* positions,
+		std::size_t stride_in_bytes,
+		std::vector<std::uint32_t> const& indices,
+		DirectX::XMFLOAT4X4 const& world);
+
+	// Builds the depth hierarchy; call once after the last occluder.
+	void endOccluders();
+
+	// Conservative: boxes crossing the near plane are always visible. Boxes
+	// outside the viewport or beyond the far plane are reported hidden.
+	bool isVisible(DirectX::BoundingBox const& world_bounds) const;
+
+	// Replaces visible with the indices of the boxes that pass isVisible.
+	void cull(std::vector<DirectX::BoundingBox> const& world_bounds, std::vector<std::uint32_t>& visible) const;
+
+	std::uint32_t getWidth() const
+	{
+		return width;
+	}
+
+	std::uint32_t getHeight() const
+	{
+		return height;
+	}
+
+	// Row-major, one depth per pixel, sampled at pixel centers.
+	std::vector<float> const& getDepthBuffer() const
+	{
+		return depth;
+	}
+
+	std::uint32_t getTrianglesRasterized() const
+	{
+		return triangles_rasterized;
+	}
+
+private:
+	struct Level
+	{
+		std::uint32_t width;
+		std::uint32_t height;
+		std::vector<float> max_depth;
+	};
+
+	// Clips against the near plane and a guard band around the viewport.
+	void rasterizeTriangle(DirectX::XMFLOAT4 const* clip);
+	void rasterizeScreenTriangle(DirectX::XMFLOAT3 v0, DirectX::XMFLOAT3 v1, DirectX::XMFLOAT3 v2);
+
+	std::uint32_t width;
+	std::uint32_t height;
+
+	DirectX::XMFLOAT4X4 view_proj;
+
+	std::vector<float> depth;
+
+	// Halved per level, starting at half resolution; depth is level 0.
+	std::vector<Level> levels;
+
+	std::vector<DirectX::XMFLOAT4> clip_positions;
+
+	std::uint32_t triangles_rasterized = 0;
+};
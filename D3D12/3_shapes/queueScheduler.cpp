@@ -0,0 +1,136 @@
+#include "queueScheduler.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+QueueScheduler::QueueScheduler(QueueBackend* direct, QueueBackend* compute, QueueBackend* copy)
+{
+	assert(direct != nullptr);
+
+	QueueBackend* backends[queue_count] = { direct, compute, copy };
+
+	for (std::uint32_t i = 0; i < queue_count; ++i)
+	{
+		timelines[i].backend = backends[i];
+		targets[i] = backends[i] != nullptr ? i : static_cast<std::uint32_t>(QueueType::Direct);
+	}
+}
+
+QueueScheduler::Point QueueScheduler::submit(
+	QueueType queue,
+	void* const* command_lists,
+	std::uint32_t command_list_count,
+	Point const* dependencies,
+	std::uint32_t dependency_count)
+{
+	std::uint32_t target = resolve(queue);
+	Timeline& timeline = timelines[target];
+
+	// Only the latest point per queue needs a wait.
+	Clock required = {};
+
+	for (std::uint32_t i = 0; i < dependency_count; ++i)
+	{
+		std::uint32_t other = resolve(dependencies[i].queue);
+
+		assert(dependencies[i].value <= timelines[other].last_value);
+
+		required[other] = std::max(required[other], dependencies[i].value);
+	}
+
+	std::uint32_t waits_inserted = 0;
+
+	for (std::uint32_t other = 0; other < queue_count; ++other)
+	{
+		std::uint64_t value = required[other];
+
+		if (other == target ||
+			value <= timeline.clock[other] ||
+			value <= timelines[other].backend->fence().lastCompletedValue())
+		{
+			continue;
+		}
+
+		timeline.backend->wait(*timelines[other].backend, value);
+		mergeClock(timeline.clock, other, value);
+
+		++waits_inserted;
+	}
+
+	statistics.waits_inserted += waits_inserted;
+	statistics.waits_skipped += dependency_count - waits_inserted;
+
+	if (command_list_count > 0)
+	{
+		timeline.backend->executeCommandLists(command_lists, command_list_count);
+	}
+
+	++timeline.last_value;
+	timeline.backend->signal(timeline.last_value);
+	timeline.clock[target] = timeline.last_value;
+
+	timeline.history.emplace_back(timeline.last_value, timeline.clock);
+
+	if (timeline.history.size() > history_size)
+	{
+		timeline.history.pop_front();
+	}
+
+	++statistics.submissions;
+
+	Point point;
+	point.queue = static_cast<QueueType>(target);
+	point.value = timeline.last_value;
+
+	return point;
+}
+
+QueueScheduler::Point QueueScheduler::lastPoint(QueueType queue) const
+{
+	std::uint32_t target = resolve(queue);
+
+	Point point;
+	point.queue = static_cast<QueueType>(target);
+	point.value = timelines[target].last_value;
+
+	return point;
+}
+
+bool QueueScheduler::isComplete(Point point)
+{
+	return timelines[resolve(point.queue)].backend->fence().isComplete(point.value);
+}
+
+FenceWaiter::Wait QueueScheduler::fenceWait(Point point)
+{
+	return { &timelines[resolve(point.queue)].backend->fence(), point.value };
+}
+
+std::uint32_t QueueScheduler::resolve(QueueType queue) const
+{
+	return targets[static_cast<std::uint32_t>(queue)];
+}
+
+void QueueScheduler::mergeClock(Clock& clock, std::uint32_t other, std::uint64_t value) const
+{
+	clock[other] = std::max(clock[other], value);
+
+	auto const& history = timelines[other].history;
+
+	auto entry = std::lower_bound(history.begin(), history.end(), value,
+		[](std::pair<std::uint64_t, Clock> const& a, std::uint64_t b)
+		{
+			return a.first < b;
+		});
+
+	// Without the exact entry (too old), only the direct wait is known.
+	if (entry == history.end() || entry->first != value)
+	{
+		return;
+	}
+
+	for (std::uint32_t i = 0; i < queue_count; ++i)
+	{
+		clock[i] = std::max(clock[i], entry->second[i]);
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "fenceWaiter.hpp"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+
+enum class QueueType
+{
+	Direct,
+	Compute,
+	Copy,
+
+	Count
+};
+
+// A command queue with its own fence, as QueueScheduler drives it.
+// d3d12Queue.hpp wraps ID3D12CommandQueue; tests can record the calls.
+class QueueBackend
+{
+public:
+	virtual ~QueueBackend() = default;
+
+	virtual void executeCommandLists(void* const* command_lists, std::uint32_t count) = 0;
+
+	// Signals this queue's fence once the work submitted so far is done.
+	virtual void signal(std::uint64_t value) = 0;
+
+	// Stalls this queue on the GPU until other's fence reaches value.
+	virtual void wait(QueueBackend& other, std::uint64_t value) = 0;
+
+	virtual FenceTimeline& fence() = 0;
+};
+
+// Direct, compute and copy queues as timelines of fence values. Every
+// submission signals the next value of its queue, and the point it returns
+// can be passed as a dependency of later submissions on any queue; the
+// scheduler inserts the cross-queue waits, skipping the ones that are
+// already implied. A queue waited on at point p also covers everything
+// that queue had waited for before p, which is tracked with one vector
+// clock per submission.
+class QueueScheduler
+{
+public:
+	static std::uint32_t const queue_count = static_cast<std::uint32_t>(QueueType::Count);
+
+	// Submissions remembered per queue for transitive waits.
+	static std::uint32_t const history_size = 64;
+
+	struct Point
+	{
+		QueueType queue = QueueType::Direct;
+		std::uint64_t value = 0;
+	};
+
+	struct Statistics
+	{
+		std::uint64_t submissions = 0;
+		std::uint64_t waits_inserted = 0;
+
+		// Dependencies on the same queue, already waited for (directly or
+		// transitively), or known complete on the CPU.
+		std::uint64_t waits_skipped = 0;
+	};
+
+	// compute and copy may be null; their work then goes to direct.
+	QueueScheduler(QueueBackend* direct, QueueBackend* compute, QueueBackend* copy);
+
+	Point submit(
+		QueueType queue,
+		void* const* command_lists,
+		std::uint32_t command_list_count,
+		Point const* dependencies = nullptr,
+		std::uint32_t dependency_count = 0);
+
+	// Point of the last submission to queue.
+	Point lastPoint(QueueType queue) const;
+
+	// Uses the cached completed value of the queue's fence.
+	bool isComplete(Point point);
+
+	// For CPU waits through FenceWaiter.
+	FenceWaiter::Wait fenceWait(Point point);
+
+	Statistics getStatistics() const
+	{
+		return statistics;
+	}
+
+private:
+	using Clock = std::array<std::uint64_t, queue_count>;
+
+	struct Timeline
+	{
+		QueueBackend* backend = nullptr;
+		std::uint64_t last_value = 0;
+
+		// Values of every queue this queue has waited for so far.
+		Clock clock = {};
+
+		// (value, clock after the submission that signaled it), oldest first.
+		std::deque<std::pair<std::uint64_t, Clock>> history;
+	};
+
+	std::uint32_t resolve(QueueType queue) const;
+
+	// What a queue knows once it has waited for point on queue other.
+	void mergeClock(Clock& clock, std::uint32_t other, std::uint64_t value) const;
+
+	std::array<Timeline, queue_count> timelines;
+
+	// Queue that actually runs each queue type's work.
+	std::array<std::uint32_t, queue_count> targets;
+
+	Statistics statistics;
+};
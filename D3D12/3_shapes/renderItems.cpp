@@ -0,0 +1,75 @@
+#include "renderItems.hpp"
+
+#include <cassert>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+RenderItemSet::RenderItemSet(std::uint32_t frame_resource_count)
+	:
+	frame_resource_count{ frame_resource_count }
+{
+	assert(frame_resource_count > 0);
+}
+
+std::uint32_t RenderItemSet::add(std::uint32_t mesh, std::uint32_t submesh, DirectX::XMFLOAT4X4 const& world)
+{
+	std::uint32_t index = size();
+
+	RenderItem item;
+	item.mesh = mesh;
+	item.submesh = submesh;
+	item.world = world;
+
+	items.push_back(item);
+
+	if (index % 64 == 0)
+	{
+		dirty_words.push_back(0);
+	}
+
+	markDirty(index);
+
+	return index;
+}
+
+void RenderItemSet::setWorld(std::uint32_t index, DirectX::XMFLOAT4X4 const& world)
+{
+	assert(index < size());
+
+	items[index].world = world;
+	markDirty(index);
+}
+
+void RenderItemSet::markDirty(std::uint32_t index)
+{
+	assert(index < size());
+
+	if (items[index].frames_dirty == 0)
+	{
+		dirty_words[index / 64] |= std::uint64_t(1) << (index % 64);
+		++dirty_count;
+	}
+
+	items[index].frames_dirty = frame_resource_count;
+}
+
+void RenderItemSet::clear()
+{
+	items.clear();
+	dirty_words.clear();
+	dirty_count = 0;
+}
+
+std::uint32_t RenderItemSet::lowestBit(std::uint64_t word)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, word);
+
+	return index;
+#else
+	return static_cast<std::uint32_t>(__builtin_ctzll(word));
+#endif
+}
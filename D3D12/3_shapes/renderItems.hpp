@@ -0,0 +1,101 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+// Objects of a scene with their world matrices, tracking which ones every
+// frame resource still has to receive. Changing an object sets its dirty
+// counter to the number of frame resources and its bit in a dirty bitset;
+// each frame's update writes only the objects whose bit is set into the
+// current frame resource and decrements their counters, clearing the bit
+// at zero. Static objects cost nothing once every frame resource has them.
+//
+// The update must run exactly once per frame resource in ring order (as
+// FrameRing::beginFrame hands them out), since a counter does not remember
+// which frame resources it was decremented for.
+class RenderItemSet
+{
+public:
+	struct RenderItem
+	{
+		// Ids chosen by the renderer, as in InstanceBatcher.
+		std::uint32_t mesh = 0;
+		std::uint32_t submesh = 0;
+
+		// Row-vector, as stored before transposing into ObjectConstants.
+		DirectX::XMFLOAT4X4 world;
+
+		// Frame resources whose copy is stale.
+		std::uint32_t frames_dirty = 0;
+	};
+
+	explicit RenderItemSet(std::uint32_t frame_resource_count);
+
+	// Returns the item's index, which is also its element in object_cb.
+	std::uint32_t add(std::uint32_t mesh, std::uint32_t submesh, DirectX::XMFLOAT4X4 const& world);
+
+	void setWorld(std::uint32_t index, DirectX::XMFLOAT4X4 const& world);
+
+	// For changes to constants kept outside the set.
+	void markDirty(std::uint32_t index);
+
+	// Calls write(index, world) for every item the current frame resource
+	// has a stale copy of, in index order. Returns the number of calls.
+	template <typename Write>
+	std::uint32_t updateFrame(Write&& write)
+	{
+		std::uint32_t written = 0;
+
+		for (std::uint32_t word_index = 0; word_index < dirty_words.size(); ++word_index)
+		{
+			std::uint64_t word = dirty_words[word_index];
+
+			while (word != 0)
+			{
+				std::uint32_t index = word_index * 64 + lowestBit(word);
+				word &= word - 1;
+
+				RenderItem& item = items[index];
+				write(index, item.world);
+				++written;
+
+				if (--item.frames_dirty == 0)
+				{
+					dirty_words[word_index] &= ~(std::uint64_t(1) << (index % 64));
+					--dirty_count;
+				}
+			}
+		}
+
+		return written;
+	}
+
+	void clear();
+
+	std::vector<RenderItem> const& getItems() const
+	{
+		return items;
+	}
+
+	std::uint32_t size() const
+	{
+		return static_cast<std::uint32_t>(items.size());
+	}
+
+	// Items some frame resource still has to receive.
+	std::uint32_t dirtyCount() const
+	{
+		return dirty_count;
+	}
+
+private:
+	static std::uint32_t lowestBit(std::uint64_t word);
+
+	std::uint32_t frame_resource_count;
+
+	std::vector<RenderItem> items;
+	std::vector<std::uint64_t> dirty_words;
+	std::uint32_t dirty_count = 0;
+};
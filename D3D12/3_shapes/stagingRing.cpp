@@ -0,0 +1,101 @@
+#include "stagingRing.hpp"
+
+#include <cassert>
+
+namespace
+{
+	std::uint64_t alignUp(std::uint64_t x, std::uint64_t alignment)
+	{
+		return (x + alignment - 1) / alignment * alignment;
+	}
+}
+
+StagingRing::StagingRing(std::uint64_t capacity)
+	:
+	size{ capacity }
+{
+	assert(capacity > 0);
+}
+
+std::uint64_t StagingRing::allocate(std::uint64_t bytes, std::uint64_t alignment)
+{
+	assert(alignment > 0);
+
+	// Start over at the beginning whenever the ring is empty, so large
+	// allocations are not split by a stale head.
+	if (used == 0)
+	{
+		head = 0;
+		tail = 0;
+	}
+
+	std::uint64_t offset = alignUp(head, alignment);
+	std::uint64_t new_head = 0;
+
+	if (head >= tail && (used == 0 || head != tail))
+	{
+		// Free space is [head, size) and [0, tail).
+		if (offset + bytes <= size)
+		{
+			new_head = offset + bytes;
+		}
+		else if (bytes <= tail)
+		{
+			offset = 0;
+			new_head = bytes;
+		}
+		else
+		{
+			return invalid_offset;
+		}
+	}
+	else
+	{
+		// Free space is [head, tail), or nothing when head == tail.
+		if (head == tail || offset + bytes > tail)
+		{
+			return invalid_offset;
+		}
+
+		new_head = offset + bytes;
+	}
+
+	// The padding before offset, or the end skipped by wrapping, stays
+	// allocated until the block is released.
+	std::uint64_t consumed = new_head > head ? new_head - head : size - head + new_head;
+
+	used += consumed;
+	open_bytes += consumed;
+	head = new_head == size ? 0 : new_head;
+
+	return offset;
+}
+
+void StagingRing::close(std::uint64_t fence_value)
+{
+	if (open_bytes == 0)
+	{
+		return;
+	}
+
+	assert(blocks.empty() || blocks.back().fence_value <= fence_value);
+
+	blocks.push_back({ head, open_bytes, fence_value });
+	open_bytes = 0;
+}
+
+void StagingRing::release(std::uint64_t completed_value)
+{
+	while (!blocks.empty() && blocks.front().fence_value <= completed_value)
+	{
+		tail = blocks.front().end;
+		used -= blocks.front().size;
+
+		blocks.pop_front();
+	}
+}
+
+std::uint64_t StagingRing::oldestFenceValue() const
+{
+	return blocks.empty() ? 0 : blocks.front().fence_value;
+}
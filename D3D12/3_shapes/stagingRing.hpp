@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+// Bookkeeping of a ring of staging memory whose allocations are freed in
+// the order they were submitted. Allocations since the last close() form
+// a block owned by the fence value passed to it; release() frees every
+// block whose fence value has completed. Only offsets are handed out, so
+// the same ring serves a mapped upload heap or plain host memory.
+class StagingRing
+{
+public:
+	static std::uint64_t const invalid_offset = UINT64_MAX;
+
+	explicit StagingRing(std::uint64_t capacity);
+
+	// Returns invalid_offset when no contiguous free range is large enough;
+	// releasing completed blocks may make room.
+	std::uint64_t allocate(std::uint64_t bytes, std::uint64_t alignment);
+
+	// Hands the allocations made since the last close to fence_value.
+	void close(std::uint64_t fence_value);
+
+	void release(std::uint64_t completed_value);
+
+	// Fence value to wait for to free the oldest block, 0 if none is closed.
+	std::uint64_t oldestFenceValue() const;
+
+	// Includes alignment padding and the space skipped when wrapping.
+	std::uint64_t usedBytes() const
+	{
+		return used;
+	}
+
+	std::uint64_t capacity() const
+	{
+		return size;
+	}
+
+	// Bytes allocated since the last close.
+	std::uint64_t openBytes() const
+	{
+		return open_bytes;
+	}
+
+private:
+	struct Block
+	{
+		std::uint64_t end;
+		std::uint64_t size;
+		std::uint64_t fence_value;
+	};
+
+	std::uint64_t size;
+
+	// Next allocation starts at head; the oldest live byte is at tail.
+	std::uint64_t head = 0;
+	std::uint64_t tail = 0;
+	std::uint64_t used = 0;
+	std::uint64_t open_bytes = 0;
+
+	std::deque<Block> blocks;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <emmintrin.h>
+
+// Copies into write-combined memory, such as a mapped upload heap, with
+// non-temporal 16-byte stores: whole write-combining lines go out to the
+// bus without the destination being read into or kept in the cache.
+// Unaligned head and tail bytes fall back to memcpy. Call streamFence once
+// after a sequence of copies, before the data is used by the GPU.
+inline void streamCopy(void* destination, void const* source, std::size_t size_in_bytes)
+{
+	auto dst = static_cast<unsigned char*>(destination);
+	auto src = static_cast<unsigned char const*>(source);
+
+	std::size_t head = (16 - (reinterpret_cast<std::uintptr_t>(dst) & 15)) & 15;
+
+	if (head > size_in_bytes)
+	{
+		head = size_in_bytes;
+	}
+
+	std::memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	size_in_bytes -= head;
+
+	for (; size_in_bytes >= 64; size_in_bytes -= 64, dst += 64, src += 64)
+	{
+		__m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 16));
+		__m128i c = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 32));
+		__m128i d = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 48));
+
+		_mm_stream_si128(reinterpret_cast<__m128i*>(dst), a);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), b);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), d);
+	}
+
+	for (; size_in_bytes >= 16; size_in_bytes -= 16, dst += 16, src += 16)
+	{
+		_mm_stream_si128(
+			reinterpret_cast<__m128i*>(dst),
+			_mm_loadu_si128(reinterpret_cast<__m128i const*>(src)));
+	}
+
+	std::memcpy(dst, src, size_in_bytes);
+}
+
+// Streams count elements of element_size bytes from source to destination,
+// each side advancing by its own stride; one streamCopy when both are
+// packed. Does not fence. UploadBuffer's bulk writes are built on this, so
+// they can be measured against host memory.
+inline void streamCopyElements(
+	void* destination,
+	std::size_t destination_stride,
+	void const* source,
+	std::size_t source_stride,
+	std::size_t element_size,
+	std::size_t count)
+{
+	auto dst = static_cast<unsigned char*>(destination);
+	auto src = static_cast<unsigned char const*>(source);
+
+	if (destination_stride == element_size && source_stride == element_size)
+	{
+		streamCopy(dst, src, count * element_size);
+		return;
+	}
+
+	for (std::size_t i = 0; i < count; ++i, dst += destination_stride, src += source_stride)
+	{
+		streamCopy(dst, src, element_size);
+	}
+}
+
+// Calls write(first_index + i, element) for count elements of type T built
+// on the stack and streams each to destination + i * destination_stride,
+// so the destination is never read. Does not fence.
+template <typename T, typename Write>
+void streamFillElements(
+	void* destination,
+	std::size_t destination_stride,
+	std::uint32_t first_index,
+	std::uint32_t count,
+	Write&& write)
+{
+	auto dst = static_cast<unsigned char*>(destination);
+
+	for (std::uint32_t i = 0; i < count; ++i, dst += destination_stride)
+	{
+		T element;
+		write(first_index + i, element);
+
+		streamCopy(dst, &element, sizeof(T));
+	}
+}
+
+// Orders the streaming stores before any later store, e.g. the one that
+// submits the command list reading them.
+inline void streamFence()
+{
+	_mm_sfence();
+}
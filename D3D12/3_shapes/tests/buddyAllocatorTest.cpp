@@ -0,0 +1,166 @@
+// Randomized host-side test of BuddyAllocator: no two live blocks overlap,
+// blocks honor their alignment, statistics match the live set, and
+// defragmentation only moves blocks down and leaves everything consistent.
+// Builds without a device, e.g. from D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. tests\buddyAllocatorTest.cpp buddyAllocator.cpp
+//	g++ -std=c++17 -O2 -I. tests/buddyAllocatorTest.cpp buddyAllocator.cpp
+
+#include "buddyAllocator.hpp"
+
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <random>
+
+namespace
+{
+	int failures = 0;
+
+	void expect(bool condition, char const* what)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", what);
+			++failures;
+		}
+	}
+
+	// live maps offsets to block sizes.
+	void checkConsistent(BuddyAllocator const& allocator, std::map<std::uint64_t, std::uint64_t> const& live)
+	{
+		std::uint64_t end = 0;
+		std::uint64_t allocated = 0;
+
+		for (auto const& block : live)
+		{
+			expect(block.first >= end, "blocks do not overlap");
+			expect(block.first % block.second == 0, "blocks are aligned to their size");
+
+			end = block.first + block.second;
+			allocated += block.second;
+		}
+
+		expect(end <= allocator.capacity(), "blocks are inside the capacity");
+
+		BuddyAllocator::Statistics statistics = allocator.getStatistics();
+
+		expect(statistics.allocation_count == live.size(), "allocation count");
+		expect(statistics.allocated_bytes == allocated, "allocated bytes");
+		expect(statistics.free_bytes + allocated == allocator.capacity(), "free bytes");
+	}
+}
+
+int main()
+{
+	std::uint64_t const capacity = 1 << 24;
+	std::uint64_t const min_block_size = 256;
+
+	BuddyAllocator allocator(capacity, min_block_size);
+	std::map<std::uint64_t, std::uint64_t> live;
+
+	std::mt19937 random(5);
+	std::uint32_t out_of_space = 0;
+
+	for (int step = 0; step < 200000; ++step)
+	{
+		if (live.empty() || random() % 100 < 55)
+		{
+			// Mostly small buffers, some up to 1 MB.
+			std::uint64_t size = 1 + random() % (random() % 8 == 0 ? 1 << 20 : 4096);
+			std::uint64_t alignment = std::uint64_t(1) << (random() % 10);
+
+			std::uint64_t offset = allocator.allocate(size, alignment);
+
+			if (offset == BuddyAllocator::invalid_offset)
+			{
+				++out_of_space;
+				continue;
+			}
+
+			expect(offset % alignment == 0, "offset honors the requested alignment");
+			expect(allocator.blockSize(offset) >= size, "block holds the requested size");
+
+			live[offset] = allocator.blockSize(offset);
+		}
+		else
+		{
+			auto it = live.begin();
+			std::advance(it, random() % live.size());
+
+			allocator.free(it->first);
+			live.erase(it);
+		}
+
+		if (step % 1000 == 0)
+		{
+			checkConsistent(allocator, live);
+		}
+	}
+
+	checkConsistent(allocator, live);
+
+	// Scatter the free space, then compact it.
+	for (auto it = live.begin(); it != live.end();)
+	{
+		if (random() % 3 != 0)
+		{
+			allocator.free(it->first);
+			it = live.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	BuddyAllocator::Statistics before = allocator.getStatistics();
+
+	std::vector<BuddyAllocator::Move> moves = allocator.beginDefragment(UINT32_MAX);
+
+	for (auto const& move : moves)
+	{
+		expect(move.to_offset < move.from_offset, "moves go to lower offsets");
+		expect(live.count(move.to_offset) == 0, "moves go to free blocks");
+
+		live[move.to_offset] = live[move.from_offset];
+	}
+
+	allocator.endDefragment();
+
+	for (auto const& move : moves)
+	{
+		live.erase(move.from_offset);
+	}
+
+	checkConsistent(allocator, live);
+
+	BuddyAllocator::Statistics after = allocator.getStatistics();
+
+	expect(after.largest_free_block >= before.largest_free_block, "defragmentation grows the largest free block");
+	expect(after.external_fragmentation <= before.external_fragmentation, "defragmentation lowers fragmentation");
+
+	std::printf(
+		"%u allocations out of space, %zu live, %zu moves, external fragmentation %.3f -> %.3f, largest free block %llu -> %llu\n",
+		out_of_space,
+		live.size(),
+		moves.size(),
+		before.external_fragmentation,
+		after.external_fragmentation,
+		static_cast<unsigned long long>(before.largest_free_block),
+		static_cast<unsigned long long>(after.largest_free_block));
+
+	// Freeing everything merges back into one block.
+	for (auto const& block : live)
+	{
+		allocator.free(block.first);
+	}
+
+	BuddyAllocator::Statistics empty = allocator.getStatistics();
+
+	expect(empty.free_block_count == 1 && empty.free_bytes == capacity, "all blocks merge when freed");
+	expect(empty.requested_bytes == 0 && empty.allocated_bytes == 0, "nothing left allocated");
+
+	std::printf(failures == 0 ? "passed\n" : "FAILED\n");
+
+	return failures == 0 ? 0 : 1;
+}
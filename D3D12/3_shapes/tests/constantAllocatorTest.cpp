@@ -0,0 +1,263 @@
+// Host-side test of ConstantAllocator over host memory: allocations are
+// 256-byte aligned and map to the matching GPU address, no allocation
+// overlaps one of a frame still in flight, across wraps included, a frame's
+// memory is untouched until its fence completes, and a full ring returns
+// null data until a frame is freed. Builds without a device, e.g. from
+// D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. tests\constantAllocatorTest.cpp constantAllocator.cpp stagingRing.cpp
+//	g++ -std=c++17 -O2 -I. tests/constantAllocatorTest.cpp constantAllocator.cpp stagingRing.cpp
+
+#include "constantAllocator.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace
+{
+	int failures = 0;
+
+	void expect(bool condition, char const* what)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", what);
+			++failures;
+		}
+	}
+
+	std::uint64_t const gpu_base = 0x7F0000100000;
+
+	struct ObjectConstants
+	{
+		float world[16];
+	};
+
+	struct Range
+	{
+		std::uint64_t begin;
+		std::uint64_t end;
+	};
+
+	struct Frame
+	{
+		std::uint64_t fence_value;
+		unsigned char tag;
+		std::vector<Range> ranges;
+	};
+
+	bool overlaps(Range const& a, Range const& b)
+	{
+		return a.begin < b.end && b.begin < a.end;
+	}
+
+	// Checks an allocation against the ring and returns its byte range.
+	Range checkAllocation(
+		ConstantAllocator::Allocation const& allocation,
+		std::uint64_t requested,
+		std::vector<unsigned char> const& memory)
+	{
+		std::uint64_t offset = static_cast<unsigned char const*>(allocation.data) - memory.data();
+
+		expect(allocation.gpu_address % ConstantAllocator::alignment == 0, "GPU addresses are 256-byte aligned");
+		expect(allocation.gpu_address == gpu_base + offset, "the GPU address matches the CPU pointer");
+		expect(allocation.size % ConstantAllocator::alignment == 0, "sizes are rounded to 256 bytes");
+		expect(allocation.size >= requested && allocation.size < requested + ConstantAllocator::alignment, "sizes are rounded up by less than 256 bytes");
+		expect(offset + allocation.size <= memory.size(), "allocations are inside the ring");
+
+		return { offset, offset + allocation.size };
+	}
+
+	// Frames of random constants with the GPU up to three frames behind.
+	// Each frame fills its allocations with its own tag, which must still
+	// be there when the frame completes.
+	void testRandomFrames()
+	{
+		std::vector<unsigned char> memory(64 * 1024);
+		ConstantAllocator allocator(memory.data(), gpu_base, memory.size());
+
+		std::mt19937 random(1);
+		std::deque<Frame> in_flight;
+
+		std::uint64_t fence_value = 0;
+		std::uint64_t completed_value = 0;
+		std::uint32_t full = 0;
+		std::uint32_t wraps = 0;
+		std::uint64_t last_end = 0;
+
+		for (std::uint32_t frame_index = 0; frame_index < 10000; ++frame_index)
+		{
+			while (!in_flight.empty() && (in_flight.size() >= 3 || random() % 2 == 0))
+			{
+				Frame const& completed = in_flight.front();
+				bool intact = true;
+
+				for (auto const& range : completed.ranges)
+				{
+					for (std::uint64_t i = range.begin; i < range.end; ++i)
+					{
+						intact &= memory[i] == completed.tag;
+					}
+				}
+
+				expect(intact, "a frame's memory is not reused before its fence completes");
+
+				completed_value = completed.fence_value;
+				in_flight.pop_front();
+			}
+
+			allocator.beginFrame(completed_value);
+
+			Frame frame;
+			frame.fence_value = fence_value + 1;
+			frame.tag = static_cast<unsigned char>(1 + frame_index % 255);
+
+			std::uint32_t count = random() % 40;
+
+			for (std::uint32_t i = 0; i < count; ++i)
+			{
+				// Mostly object constants, some odd sizes.
+				bool object = random() % 3 != 0;
+				std::uint64_t requested = object ? sizeof(ObjectConstants) : 1 + random() % 700;
+
+				ConstantAllocator::Allocation allocation = object ?
+					allocator.push(ObjectConstants{}) :
+					allocator.allocate(requested);
+
+				if (allocation.data == nullptr)
+				{
+					++full;
+					continue;
+				}
+
+				Range range = checkAllocation(allocation, requested, memory);
+
+				wraps += range.begin < last_end ? 1 : 0;
+				last_end = range.end;
+
+				for (auto const& other : in_flight)
+				{
+					for (auto const& other_range : other.ranges)
+					{
+						expect(!overlaps(range, other_range), "allocations do not overlap frames in flight");
+					}
+				}
+
+				for (auto const& other_range : frame.ranges)
+				{
+					expect(!overlaps(range, other_range), "allocations of a frame do not overlap");
+				}
+
+				for (std::uint64_t b = range.begin; b < range.end; ++b)
+				{
+					memory[b] = frame.tag;
+				}
+
+				frame.ranges.push_back(range);
+			}
+
+			allocator.endFrame(++fence_value);
+			in_flight.push_back(frame);
+		}
+
+		allocator.beginFrame(fence_value);
+
+		expect(allocator.usedBytes() == 0, "everything is freed once the last fence completes");
+		expect(wraps > 100, "the ring wraps");
+
+		std::printf("random frames: %u wraps, %u allocations did not fit\n", wraps, full);
+	}
+
+	void testFullRing()
+	{
+		std::uint64_t const capacity = 4 * ConstantAllocator::alignment;
+
+		std::vector<unsigned char> memory(capacity);
+		ConstantAllocator allocator(memory.data(), gpu_base, capacity);
+
+		allocator.beginFrame(0);
+
+		for (std::uint64_t i = 0; i < 4; ++i)
+		{
+			ConstantAllocator::Allocation allocation = allocator.allocate(1);
+
+			expect(allocation.data == memory.data() + i * ConstantAllocator::alignment, "allocations are packed at 256 bytes");
+		}
+
+		expect(allocator.frameBytes() == capacity, "the frame holds the whole ring");
+
+		ConstantAllocator::Allocation overflow = allocator.push(ObjectConstants{});
+
+		expect(overflow.data == nullptr, "a full ring returns null data");
+		expect(overflow.gpu_address == 0 && overflow.size == 0, "and an empty allocation");
+
+		allocator.endFrame(1);
+		allocator.beginFrame(0);
+
+		expect(allocator.allocate(1).data == nullptr, "the ring stays full until the fence completes");
+
+		allocator.endFrame(2);
+		allocator.beginFrame(1);
+
+		expect(allocator.usedBytes() == 0, "the completed frame is freed");
+		expect(allocator.allocate(capacity).data == memory.data(), "the whole ring is available again");
+	}
+
+	void testWrap()
+	{
+		std::uint64_t const capacity = 4 * ConstantAllocator::alignment;
+
+		std::vector<unsigned char> memory(capacity);
+		ConstantAllocator allocator(memory.data(), gpu_base, capacity);
+
+		// Frame 1 takes [0, 512), frame 2 [512, 768).
+		allocator.beginFrame(0);
+		ConstantAllocator::Allocation first = allocator.allocate(512);
+		allocator.endFrame(1);
+
+		allocator.beginFrame(0);
+		ConstantAllocator::Allocation second = allocator.allocate(200);
+		allocator.endFrame(2);
+
+		expect(first.data == memory.data() && second.data == memory.data() + 512, "frames are allocated back to back");
+
+		// 512 bytes do not fit in [768, 1024) and frame 1 still holds the
+		// start of the ring.
+		allocator.beginFrame(0);
+
+		expect(allocator.allocate(512).data == nullptr, "a wrap is refused while the start is in flight");
+
+		// Once frame 1 completes, the allocation wraps to the start and the
+		// skipped end stays used until frame 3 completes.
+		allocator.beginFrame(1);
+
+		ConstantAllocator::Allocation wrapped = allocator.allocate(512);
+
+		expect(wrapped.data == memory.data(), "the allocation wraps to the start");
+		expect(wrapped.gpu_address == gpu_base, "with the ring's base GPU address");
+		expect(allocator.frameBytes() == 256 + 512, "the skipped end is charged to the frame");
+		expect(allocator.allocate(256).data == nullptr, "frame 2 is not overwritten after the wrap");
+
+		allocator.endFrame(3);
+		allocator.beginFrame(2);
+
+		expect(allocator.usedBytes() == 256 + 512, "frame 3 still holds the skipped end and its allocation");
+
+		allocator.beginFrame(3);
+
+		expect(allocator.usedBytes() == 0, "all frames are freed");
+	}
+}
+
+int main()
+{
+	testRandomFrames();
+	testFullRing();
+	testWrap();
+
+	std::printf(failures == 0 ? "ConstantAllocator test passed\n" : "ConstantAllocator test FAILED\n");
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,404 @@
+// Host-side test of FenceWaiter over simulated fences and events: polls of
+// values already seen do not query the fence, a fence completing between
+// the checks of waitAny and arming its event does not block, an event
+// parked by a timed-out wait is not reused before its signal is consumed,
+// and pooled events are reused instead of created per wait. Builds without
+// a device, e.g. from D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. tests\fenceWaiterTest.cpp fenceWaiter.cpp
+//	g++ -std=c++17 -O2 -I. tests/fenceWaiterTest.cpp fenceWaiter.cpp
+
+#include "fenceWaiter.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	int failures = 0;
+
+	void expect(bool condition, char const* what)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", what);
+			++failures;
+		}
+	}
+
+	class SimulatedEvents;
+
+	// Completes rate values per millisecond of simulated time.
+	class SimulatedFence : public FenceTimeline
+	{
+	public:
+		SimulatedFence(SimulatedEvents& events, std::uint64_t rate);
+
+		void setEventOnCompletion(std::uint64_t value, void* event) override;
+
+		// Advances one millisecond and signals the events armed for values
+		// reached.
+		void tick();
+
+		std::uint64_t value = 0;
+
+	protected:
+		std::uint64_t queryCompletedValue() override
+		{
+			return value;
+		}
+
+	private:
+		SimulatedEvents& events;
+		std::uint64_t rate;
+
+		std::vector<std::pair<std::uint64_t, void*>> armed;
+	};
+
+	// Auto-reset events; simulated time only passes while wait blocks.
+	class SimulatedEvents : public WaitEventBackend
+	{
+	public:
+		static std::uint32_t const deadlock_ms = 1000000;
+
+		void* createEvent() override
+		{
+			void* event = reinterpret_cast<void*>(static_cast<std::uintptr_t>(++created));
+			signaled[event] = false;
+
+			return event;
+		}
+
+		void destroyEvent(void* event) override
+		{
+			++destroyed;
+			signaled.erase(event);
+		}
+
+		std::int32_t wait(void* const* events, std::uint32_t count, bool wait_all, std::uint32_t timeout_ms) override
+		{
+			// WaitForMultipleObjects fails on zero handles.
+			if (count == 0)
+			{
+				expect(false, "waits are never on zero events");
+
+				return timed_out;
+			}
+
+			for (std::uint32_t elapsed = 0; ; ++elapsed)
+			{
+				if (wait_all)
+				{
+					bool all = true;
+
+					for (std::uint32_t i = 0; i < count; ++i)
+					{
+						all &= signaled.at(events[i]);
+					}
+
+					if (all)
+					{
+						for (std::uint32_t i = 0; i < count; ++i)
+						{
+							signaled[events[i]] = false;
+						}
+
+						return 0;
+					}
+				}
+				else
+				{
+					for (std::uint32_t i = 0; i < count; ++i)
+					{
+						if (signaled.at(events[i]))
+						{
+							signaled[events[i]] = false;
+
+							return static_cast<std::int32_t>(i);
+						}
+					}
+				}
+
+				if (elapsed >= timeout_ms)
+				{
+					return timed_out;
+				}
+
+				// Nothing left that would ever signal.
+				if (elapsed >= deadlock_ms)
+				{
+					expect(false, "waits do not block forever");
+
+					return timed_out;
+				}
+
+				if (timeout_ms > 0)
+				{
+					++blocking_calls;
+				}
+
+				for (auto fence : fences)
+				{
+					fence->tick();
+				}
+			}
+		}
+
+		void signal(void* event)
+		{
+			signaled.at(event) = true;
+		}
+
+		std::vector<SimulatedFence*> fences;
+		std::map<void*, bool> signaled;
+
+		std::uint32_t created = 0;
+		std::uint32_t destroyed = 0;
+		std::uint32_t blocking_calls = 0;
+	};
+
+	SimulatedFence::SimulatedFence(SimulatedEvents& events, std::uint64_t rate)
+		:
+		events(events),
+		rate(rate)
+	{
+		events.fences.push_back(this);
+	}
+
+	void SimulatedFence::setEventOnCompletion(std::uint64_t completion_value, void* event)
+	{
+		if (completion_value <= value)
+		{
+			events.signal(event);
+		}
+		else
+		{
+			armed.push_back({ completion_value, event });
+		}
+	}
+
+	void SimulatedFence::tick()
+	{
+		value += rate;
+
+		std::size_t kept = 0;
+
+		for (auto const& entry : armed)
+		{
+			if (entry.first <= value)
+			{
+				events.signal(entry.second);
+			}
+			else
+			{
+				armed[kept++] = entry;
+			}
+		}
+
+		armed.resize(kept);
+	}
+
+	// Never completes on its own; completes on its n-th query, i.e. after
+	// the caller checked it once and before it arms an event.
+	class RacingFence : public FenceTimeline
+	{
+	public:
+		RacingFence(std::uint32_t completing_query, std::uint64_t completed)
+			:
+			completing_query(completing_query),
+			completed(completed)
+		{
+
+		}
+
+		void setEventOnCompletion(std::uint64_t, void* event) override
+		{
+			armed.push_back(event);
+		}
+
+		std::vector<void*> armed;
+
+	protected:
+		std::uint64_t queryCompletedValue() override
+		{
+			return ++queries >= completing_query ? completed : 0;
+		}
+
+	private:
+		std::uint32_t completing_query;
+		std::uint64_t completed;
+		std::uint32_t queries = 0;
+	};
+
+	void testCachedPolls()
+	{
+		SimulatedEvents events;
+		SimulatedFence fence(events, 1);
+
+		FenceWaiter fence_waiter(events);
+
+		expect(!fence_waiter.poll(fence, 5), "poll of a future value fails");
+		expect(fence.queryCount() == 1, "poll of a future value queries the fence");
+
+		expect(fence_waiter.wait(fence, 5), "wait succeeds");
+		expect(fence.value >= 5, "wait returns only once the fence reached the value");
+
+		// The event firing for 5 proves the fence passed it.
+		std::uint64_t queries = fence.queryCount();
+
+		for (std::uint64_t value = 0; value <= 5; ++value)
+		{
+			expect(fence_waiter.poll(fence, value), "poll of a passed value succeeds");
+		}
+
+		expect(fence.queryCount() == queries, "polls of passed values do not query the fence");
+
+		fence.tick();
+		fence.tick();
+
+		expect(fence_waiter.poll(fence, 7), "poll of a value reached since succeeds");
+		expect(fence.queryCount() == queries + 1, "it queries the fence once");
+		expect(fence_waiter.poll(fence, 6), "poll below the refreshed value succeeds");
+		expect(fence.queryCount() == queries + 1, "and is answered from the cache");
+	}
+
+	void testArmingRace()
+	{
+		SimulatedEvents events;
+		FenceWaiter fence_waiter(events);
+
+		// The only fence completes between the first check and arming.
+		RacingFence racing(2, 5);
+		FenceWaiter::Wait single{ &racing, 5 };
+
+		expect(fence_waiter.waitAny(&single, 1) == 0, "waitAny reports a fence completing while arming");
+		expect(racing.armed.empty(), "no event is armed for it");
+
+		// The second fence completes after the first fence's event is armed.
+		RacingFence never(~0u, 0);
+		RacingFence late(2, 5);
+		FenceWaiter::Wait waits[2] = { { &never, 1 }, { &late, 5 } };
+
+		expect(fence_waiter.waitAny(waits, 2) == 1, "waitAny reports the fence that completed while arming");
+		expect(never.armed.size() == 1, "the fence before it was armed");
+		expect(fence_waiter.blockingWaits() == 0, "neither waitAny blocks");
+		expect(events.blocking_calls == 0, "the backend never blocks");
+
+		// The armed event is still outstanding, so the next wait must not
+		// take it from the pool.
+		RacingFence other(2, 5);
+		FenceWaiter::Wait next[2] = { { &never, 2 }, { &other, 5 } };
+		fence_waiter.waitAny(next, 2);
+
+		expect(never.armed.size() == 2 && never.armed[1] != never.armed[0], "the outstanding event is not reused");
+	}
+
+	void testParkedEvent()
+	{
+		SimulatedEvents events;
+		SimulatedFence fast(events, 1);
+		SimulatedFence slow(events, 1);
+
+		FenceWaiter fence_waiter(events);
+
+		expect(!fence_waiter.wait(slow, 100, 10), "wait for a far value times out");
+		expect(fence_waiter.eventsCreated() == 1, "the timed-out wait used one event");
+
+		// The timed-out event fires when slow reaches 100. Were it reused
+		// here, that signal would end one of these waits early.
+		for (int i = 0; i < 50; ++i)
+		{
+			std::uint64_t value = fast.value + 3;
+
+			expect(fence_waiter.wait(fast, value), "wait succeeds");
+			expect(fast.value >= value, "wait does not return before the fence reached the value");
+		}
+
+		expect(fence_waiter.eventsCreated() == 2, "the parked event is not reused while its signal is outstanding");
+
+		expect(fence_waiter.wait(slow, 100), "wait for the far value succeeds");
+
+		// The parked event has been signaled; acquiring consumes the signal
+		// and returns it to the pool.
+		for (int i = 0; i < 50; ++i)
+		{
+			std::uint64_t value = fast.value + 3;
+
+			expect(fence_waiter.wait(fast, value), "wait succeeds");
+			expect(fast.value >= value, "a recycled event does not end a wait early");
+		}
+
+		expect(fence_waiter.eventsCreated() == 2, "the parked event is recycled once signaled");
+	}
+
+	void testPoolSize()
+	{
+		SimulatedEvents events;
+		SimulatedFence a(events, 1);
+		SimulatedFence b(events, 2);
+		SimulatedFence c(events, 3);
+
+		{
+			FenceWaiter fence_waiter(events);
+
+			for (int i = 0; i < 1000; ++i)
+			{
+				expect(fence_waiter.wait(a, a.value + 2), "wait succeeds");
+			}
+
+			expect(fence_waiter.eventsCreated() == 1, "sequential waits share one event");
+			expect(fence_waiter.blockingWaits() == 1000, "every wait blocked");
+
+			for (int i = 0; i < 100; ++i)
+			{
+				FenceWaiter::Wait waits[3] = { { &a, a.value + 5 }, { &b, b.value + 5 }, { &c, c.value + 5 } };
+
+				expect(fence_waiter.waitAll(waits, 3), "waitAll succeeds");
+				expect(a.value >= waits[0].value && b.value >= waits[1].value && c.value >= waits[2].value, "waitAll waits for every fence");
+			}
+
+			expect(fence_waiter.eventsCreated() == 3, "waitAll of three fences needs three events");
+
+			for (int i = 0; i < 100; ++i)
+			{
+				FenceWaiter::Wait waits[3] = { { &a, a.value + 50 }, { &b, b.value + 50 }, { &c, c.value + 6 } };
+
+				expect(fence_waiter.waitAny(waits, 3) == 2, "waitAny returns the fence that gets there first");
+			}
+
+			// waitAny leaves the other events armed. Once their fences pass,
+			// they all return to the pool, so the same waits again need no
+			// new events.
+			std::uint32_t created = fence_waiter.eventsCreated();
+			expect(fence_waiter.wait(a, a.value + 100), "wait succeeds");
+
+			for (int i = 0; i < 100; ++i)
+			{
+				FenceWaiter::Wait waits[3] = { { &a, a.value + 50 }, { &b, b.value + 50 }, { &c, c.value + 6 } };
+
+				expect(fence_waiter.waitAny(waits, 3) == 2, "waitAny returns the fence that gets there first");
+			}
+
+			expect(fence_waiter.eventsCreated() == created, "waitAny recycles its outstanding events");
+
+			expect(!fence_waiter.poll(a, a.value + 1), "poll of a future value fails");
+			expect(fence_waiter.blockingWaits() == 1301, "polls never block");
+		}
+
+		expect(events.destroyed == events.created, "every event is destroyed with the waiter");
+	}
+}
+
+int main()
+{
+	testCachedPolls();
+	testArmingRace();
+	testParkedEvent();
+	testPoolSize();
+
+	std::printf(failures == 0 ? "FenceWaiter test passed\n" : "FenceWaiter test FAILED\n");
+
+	return failures == 0 ? 0 : 1;
+}
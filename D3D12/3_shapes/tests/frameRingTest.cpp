@@ -0,0 +1,164 @@
+// Host-side test of FrameRing against a simulated GPU that completes
+// frames at a fixed rate: a slot is never handed out before the frame that
+// last used it has completed, and beginFrame waits exactly when the CPU is
+// frame_count frames ahead, never earlier. Builds without a device, e.g.
+// from D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. tests\frameRingTest.cpp
+//	g++ -std=c++17 -O2 -I. tests/frameRingTest.cpp
+
+#include "frameRing.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+
+namespace
+{
+	int failures = 0;
+
+	void expect(bool condition, char const* what)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", what);
+			++failures;
+		}
+	}
+
+	struct FrameResource
+	{
+		explicit FrameResource(int tag)
+			:
+			tag(tag)
+		{
+
+		}
+
+		int tag;
+		std::uint64_t fence = 0;
+	};
+
+	// Frames are completed in submission order, one every gpu_period CPU
+	// frames, or never on its own with gpu_period 0.
+	class SimulatedGpu
+	{
+	public:
+		explicit SimulatedGpu(std::uint32_t gpu_period)
+			:
+			gpu_period(gpu_period)
+		{
+
+		}
+
+		std::uint64_t submit()
+		{
+			submitted.push_back(++signaled);
+
+			return signaled;
+		}
+
+		void tick(std::uint32_t frame)
+		{
+			if (gpu_period != 0 && frame % gpu_period == 0)
+			{
+				completeOne();
+			}
+		}
+
+		// Blocks the CPU until value is completed.
+		void waitFor(std::uint64_t value)
+		{
+			while (completed < value && !submitted.empty())
+			{
+				completeOne();
+			}
+		}
+
+		std::uint64_t completed = 0;
+		std::uint64_t signaled = 0;
+
+	private:
+		void completeOne()
+		{
+			if (!submitted.empty())
+			{
+				completed = submitted.front();
+				submitted.pop_front();
+			}
+		}
+
+		std::uint32_t gpu_period;
+		std::deque<std::uint64_t> submitted;
+	};
+
+	void run(std::uint32_t frame_count, std::uint32_t gpu_period)
+	{
+		FrameRing<FrameResource> ring(frame_count, 42);
+		SimulatedGpu gpu(gpu_period);
+
+		std::uint64_t expected_waits = 0;
+
+		for (std::uint32_t frame = 0; frame < 100; ++frame)
+		{
+			gpu.tick(frame);
+
+			// The next slot is still in use only when every slot is.
+			bool ring_full = ring.framesInFlight(gpu.completed) == frame_count;
+			expected_waits += ring_full ? 1 : 0;
+
+			std::uint64_t waited_for = 0;
+
+			FrameResource& resource = ring.beginFrame(gpu.completed, [&](std::uint64_t value)
+			{
+				waited_for = value;
+				gpu.waitFor(value);
+			});
+
+			expect(resource.tag == 42, "slots are built from the constructor arguments");
+			expect(ring.currentIndex() == frame % frame_count, "slots are used round robin");
+			expect(&resource == &ring.current(), "beginFrame returns the current slot");
+			expect(resource.fence <= gpu.completed, "a slot is not reused before its fence completes");
+			expect(ring.waitCount() == expected_waits, "beginFrame waits only when the CPU is frame_count frames ahead");
+			expect(!ring_full || waited_for == resource.fence, "beginFrame waits for the slot's own fence value");
+			expect(ring_full || waited_for == 0, "beginFrame does not wait while a slot is free");
+
+			ring.endFrame(gpu.submit());
+
+			expect(ring.framesInFlight(gpu.completed) <= frame_count, "at most frame_count frames are in flight");
+			expect(ring.lastFenceValue() == gpu.signaled, "lastFenceValue is the last frame's fence");
+		}
+
+		// A GPU that keeps up never makes the CPU wait; one that never
+		// completes on its own makes every frame after the first
+		// frame_count wait.
+		if (gpu_period == 1)
+		{
+			expect(ring.waitCount() == 0, "a GPU that keeps up causes no waits");
+		}
+		else if (gpu_period == 0)
+		{
+			expect(ring.waitCount() == 100 - frame_count, "a stalled GPU causes a wait every frame once the ring is full");
+		}
+
+		std::printf(
+			"%u frames, GPU %s: %3llu waits\n",
+			frame_count,
+			gpu_period == 0 ? "stalled" : (gpu_period == 1 ? "keeps up" : "at half rate"),
+			static_cast<unsigned long long>(ring.waitCount()));
+	}
+}
+
+int main()
+{
+	for (std::uint32_t frame_count : { 1u, 2u, 3u })
+	{
+		for (std::uint32_t gpu_period : { 0u, 1u, 2u })
+		{
+			run(frame_count, gpu_period);
+		}
+	}
+
+	std::printf(failures == 0 ? "FrameRing test passed\n" : "FrameRing test FAILED\n");
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,251 @@
+// Host-side test of InstanceBatcher: batches come in order of the first
+// object of each submesh, objects keep their order within a batch, batches
+// are split at max_instances_per_batch, getInstanceSlots points at each
+// object's instance, and instances hold the transposed world matrices.
+// Builds without a device, e.g. from D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. tests\instanceBatcherTest.cpp instanceBatcher.cpp
+//	g++ -std=c++17 -O2 -I. tests/instanceBatcherTest.cpp instanceBatcher.cpp
+
+#include "instanceBatcher.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	int failures = 0;
+
+	void expect(bool condition, char const* what)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", what);
+			++failures;
+		}
+	}
+
+	struct Object
+	{
+		std::uint32_t mesh;
+		std::uint32_t submesh;
+	};
+
+	// Every element distinct and exact in float, so a transposed or
+	// misplaced matrix cannot compare equal.
+	XMFLOAT4X4 worldOf(std::uint32_t object)
+	{
+		XMFLOAT4X4 world;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				world.m[i][j] = static_cast<float>(object * 16 + i * 4 + j);
+			}
+		}
+
+		return world;
+	}
+
+	// Batches the build should produce: submeshes in order of their first
+	// object, each cut into runs of max_instances_per_batch.
+	std::vector<InstanceBatcher::Batch> expectedBatches(std::vector<Object> const& objects, std::uint32_t max_instances_per_batch)
+	{
+		std::vector<std::pair<Object, std::uint32_t>> groups;
+
+		for (auto const& object : objects)
+		{
+			bool found = false;
+
+			for (auto& group : groups)
+			{
+				if (group.first.mesh == object.mesh && group.first.submesh == object.submesh)
+				{
+					++group.second;
+					found = true;
+					break;
+				}
+			}
+
+			if (!found)
+			{
+				groups.push_back({ object, 1 });
+			}
+		}
+
+		std::vector<InstanceBatcher::Batch> batches;
+		std::uint32_t first_instance = 0;
+
+		for (auto const& group : groups)
+		{
+			for (std::uint32_t done = 0; done < group.second; )
+			{
+				InstanceBatcher::Batch batch;
+				batch.mesh = group.first.mesh;
+				batch.submesh = group.first.submesh;
+				batch.first_instance = first_instance;
+				batch.instance_count = std::min(max_instances_per_batch, group.second - done);
+
+				batches.push_back(batch);
+
+				first_instance += batch.instance_count;
+				done += batch.instance_count;
+			}
+		}
+
+		return batches;
+	}
+
+	void check(InstanceBatcher const& batcher, std::vector<Object> const& objects, std::uint32_t max_instances_per_batch)
+	{
+		auto const& batches = batcher.getBatches();
+		auto const& instances = batcher.getInstances();
+		auto const& slots = batcher.getInstanceSlots();
+
+		std::vector<InstanceBatcher::Batch> expected = expectedBatches(objects, max_instances_per_batch);
+
+		bool same_batches = batches.size() == expected.size();
+
+		for (std::size_t b = 0; same_batches && b < batches.size(); ++b)
+		{
+			same_batches =
+				batches[b].mesh == expected[b].mesh &&
+				batches[b].submesh == expected[b].submesh &&
+				batches[b].first_instance == expected[b].first_instance &&
+				batches[b].instance_count == expected[b].instance_count;
+		}
+
+		expect(same_batches, "batches follow the first object of each submesh and split at the limit");
+		expect(batcher.objectCount() == objects.size(), "objectCount counts the objects");
+		expect(instances.size() == objects.size(), "one instance per object");
+		expect(slots.size() == objects.size(), "one slot per object");
+
+		if (slots.size() != objects.size() || instances.size() != objects.size())
+		{
+			return;
+		}
+
+		// Each object's slot holds its transposed world and lies in a batch
+		// of its submesh.
+		std::vector<std::uint32_t> owner(instances.size(), UINT32_MAX);
+
+		for (std::uint32_t object = 0; object < objects.size(); ++object)
+		{
+			std::uint32_t slot = slots[object];
+
+			if (slot >= instances.size() || owner[slot] != UINT32_MAX)
+			{
+				expect(false, "slots are distinct and inside the instances");
+				continue;
+			}
+
+			owner[slot] = object;
+
+			XMFLOAT4X4 world = worldOf(object);
+			bool transposed = true;
+
+			for (int i = 0; i < 4; ++i)
+			{
+				for (int j = 0; j < 4; ++j)
+				{
+					transposed &= instances[slot].world.m[i][j] == world.m[j][i];
+				}
+			}
+
+			expect(transposed, "instances hold the transposed world");
+		}
+
+		for (auto const& batch : batches)
+		{
+			for (std::uint32_t k = 0; k < batch.instance_count; ++k)
+			{
+				std::uint32_t object = owner[batch.first_instance + k];
+
+				expect(objects[object].mesh == batch.mesh && objects[object].submesh == batch.submesh, "batches only hold objects of their submesh");
+
+				if (k > 0)
+				{
+					expect(owner[batch.first_instance + k - 1] < object, "objects keep their order within a batch");
+				}
+			}
+		}
+
+		// Splits of one submesh continue in object order.
+		for (std::size_t b = 1; b < batches.size(); ++b)
+		{
+			if (batches[b].mesh == batches[b - 1].mesh && batches[b].submesh == batches[b - 1].submesh)
+			{
+				expect(owner[batches[b - 1].first_instance + batches[b - 1].instance_count - 1] < owner[batches[b].first_instance], "splits continue in object order");
+			}
+		}
+	}
+
+	void testSmall()
+	{
+		// Submesh (2, 0) comes first, then (1, 1), then (2, 1).
+		std::vector<Object> objects = {
+			{ 2, 0 }, { 1, 1 }, { 2, 0 }, { 2, 1 }, { 1, 1 }, { 2, 0 }, { 2, 0 }, { 2, 0 } };
+
+		InstanceBatcher batcher;
+
+		for (std::uint32_t i = 0; i < objects.size(); ++i)
+		{
+			expect(batcher.addObject(objects[i].mesh, objects[i].submesh, worldOf(i)) == i, "addObject returns the object index");
+		}
+
+		batcher.build();
+		check(batcher, objects, UINT32_MAX);
+
+		expect(batcher.getBatches().size() == 3, "three submeshes give three batches");
+		expect(batcher.getInstanceSlots()[3] == 7, "the only object of the last submesh is the last instance");
+
+		batcher.build(2);
+		check(batcher, objects, 2);
+
+		expect(batcher.getBatches().size() == 5, "the five objects of (2, 0) split into three batches, five in all");
+
+		batcher.clear();
+		batcher.build();
+
+		expect(batcher.objectCount() == 0 && batcher.getBatches().empty() && batcher.getInstances().empty(), "clear empties the batcher");
+	}
+
+	void testRandom()
+	{
+		std::mt19937 random(1);
+
+		for (std::uint32_t count : { 0u, 1u, 1000u, 100000u })
+		{
+			for (std::uint32_t max_instances_per_batch : { UINT32_MAX, 64u, 1u })
+			{
+				InstanceBatcher batcher;
+				std::vector<Object> objects(count);
+
+				for (std::uint32_t i = 0; i < count; ++i)
+				{
+					objects[i] = { static_cast<std::uint32_t>(random() % 10), static_cast<std::uint32_t>(random() % 3) };
+					batcher.addObject(objects[i].mesh, objects[i].submesh, worldOf(i));
+				}
+
+				batcher.build(max_instances_per_batch);
+				check(batcher, objects, max_instances_per_batch);
+			}
+		}
+	}
+}
+
+int main()
+{
+	testSmall();
+	testRandom();
+
+	std::printf(failures == 0 ? "InstanceBatcher test passed\n" : "InstanceBatcher test FAILED\n");
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+// Checks that MeshletBuilder::cull never rejects a meshlet with a triangle
+// facing the camera, on a convex sphere and on concave inverted spheres.
+// Builds without a device, e.g. from D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. tests\meshletBuilderTest.cpp meshletBuilder.cpp geometryGenerator.cpp meshOptimizer.cpp boundsBuilder.cpp
+
+#include "meshletBuilder.hpp"
+#include "meshOptimizer.hpp"
+
+#include <cstdio>
+#include <utility>
+
+using namespace DirectX;
+
+namespace
+{
+	// Front faces of triangles that cull() rejected, seen from camera.
+	std::uint32_t countWronglyCulled(
+		GeometryGenerator::MeshData const& mesh,
+		MeshletBuilder::MeshletData const& meshlet_data,
+		XMFLOAT3 const& camera_position)
+	{
+		MeshletBuilder builder;
+
+		// Planes no sphere can be outside of.
+		Frustum everything;
+
+		for (auto& plane : everything.planes)
+		{
+			plane = XMFLOAT4(0.0f, 0.0f, 0.0f, 1e9f);
+		}
+
+		std::vector<std::uint32_t> visible;
+		builder.cull(meshlet_data, everything, camera_position, visible);
+
+		std::vector<bool> is_visible(meshlet_data.meshlets.size());
+
+		for (std::uint32_t i : visible)
+		{
+			is_visible[i] = true;
+		}
+
+		XMVECTOR camera = XMLoadFloat3(&camera_position);
+		std::uint32_t wrongly_culled = 0;
+
+		for (std::size_t i = 0; i < meshlet_data.meshlets.size(); ++i)
+		{
+			if (is_visible[i])
+			{
+				continue;
+			}
+
+			MeshletBuilder::Meshlet const& meshlet = meshlet_data.meshlets[i];
+
+			for (std::uint32_t t = 0; t < meshlet.triangle_count; ++t)
+			{
+				XMVECTOR p[3];
+
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					std::uint32_t local = meshlet_data.meshlet_triangles[meshlet.triangle_offset + t * 3 + k];
+					std::uint32_t v = meshlet_data.meshlet_vertices[meshlet.vertex_offset + local];
+
+					p[k] = XMLoadFloat3(&mesh.vertices[v].position);
+				}
+
+				XMVECTOR normal = XMVector3Cross(p[1] - p[0], p[2] - p[0]);
+
+				// Same facing convention as computeBounds.
+				if (XMVectorGetX(XMVector3Dot(camera - p[0], normal)) > 1e-6f)
+				{
+					++wrongly_culled;
+				}
+			}
+		}
+
+		return wrongly_culled;
+	}
+
+	bool check(char const* name, GeometryGenerator::MeshData const& mesh, std::uint32_t triangle_limit)
+	{
+		MeshletBuilder builder;
+		MeshletBuilder::MeshletData meshlet_data = builder.build(mesh, MeshletBuilder::max_vertices, triangle_limit);
+
+		std::uint32_t wrongly_culled = 0;
+		std::uint32_t camera_count = 0;
+
+		// Cameras inside and outside the unit sphere, on a grid.
+		for (float x = -3.0f; x <= 3.0f; x += 0.75f)
+		{
+			for (float y = -3.0f; y <= 3.0f; y += 0.75f)
+			{
+				for (float z = -3.0f; z <= 3.0f; z += 0.75f)
+				{
+					wrongly_culled += countWronglyCulled(mesh, meshlet_data, XMFLOAT3(x, y, z));
+					++camera_count;
+				}
+			}
+		}
+
+		std::printf(
+			"%-28s meshlets %5zu cameras %4u wrongly culled triangles %u\n",
+			name,
+			meshlet_data.meshlets.size(),
+			camera_count,
+			wrongly_culled);
+
+		return wrongly_culled == 0;
+	}
+}
+
+int main()
+{
+	GeometryGenerator generator;
+	MeshOptimizer optimizer;
+
+	GeometryGenerator::MeshData sphere = generator.createGeosphereDirect(1.0f, 4);
+	optimizer.optimizeVertexCache(sphere);
+
+	// The inside of the sphere: every meshlet is a concave bowl.
+	GeometryGenerator::MeshData inside = sphere;
+
+	for (std::size_t i = 0; i < inside.indices_32.size(); i += 3)
+	{
+		std::swap(inside.indices_32[i + 1], inside.indices_32[i + 2]);
+	}
+
+	bool passed = true;
+
+	passed &= check("convex sphere", sphere, MeshletBuilder::max_triangles);
+	passed &= check("concave sphere", inside, MeshletBuilder::max_triangles);
+	passed &= check("concave sphere, 16 triangles", inside, 16);
+
+	std::printf(passed ? "passed\n" : "FAILED\n");
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,380 @@
+// Host-side test of OcclusionCuller on a scene of closed and single-sided
+// occluders: the depth buffer matches a ray cast through every pixel
+// center in coverage and depth except for a few silhouette pixels, no box
+// that shows a pixel at full resolution is reported hidden, and boxes
+// crossing the near plane are always visible. Builds without a device,
+// e.g. from D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. tests\occlusionCullerTest.cpp occlusionCuller.cpp geometryGenerator.cpp boundsBuilder.cpp
+//	g++ -std=c++17 -O2 -pthread -I. tests/occlusionCullerTest.cpp occlusionCuller.cpp geometryGenerator.cpp boundsBuilder.cpp
+
+#include "occlusionCuller.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	int failures = 0;
+
+	void expect(bool condition, char const* what)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", what);
+			++failures;
+		}
+	}
+
+	float const near_z = 0.5f;
+	float const far_z = 100.0f;
+	float const aspect_ratio = 2.0f;
+
+	// Camera at the origin looking down +z, so view space is world space.
+	struct Camera
+	{
+		Camera()
+		{
+			XMStoreFloat4x4(&view_proj, XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), aspect_ratio, near_z, far_z));
+			cot_half_fov = 1.0f / std::tan(XMConvertToRadians(30.0f));
+		}
+
+		float depth(float z) const
+		{
+			return far_z / (far_z - near_z) * (1.0f - near_z / z);
+		}
+
+		XMFLOAT4X4 view_proj;
+		float cot_half_fov;
+	};
+
+	struct Occluder
+	{
+		GeometryGenerator::MeshData mesh_data;
+		XMFLOAT4X4 world;
+	};
+
+	std::vector<Occluder> buildScene()
+	{
+		GeometryGenerator geometry_generator;
+		std::vector<Occluder> occluders;
+
+		auto add = [&occluders](GeometryGenerator::MeshData mesh_data, XMMATRIX world)
+		{
+			Occluder occluder;
+			occluder.mesh_data = std::move(mesh_data);
+			XMStoreFloat4x4(&occluder.world, world);
+
+			occluders.push_back(std::move(occluder));
+		};
+
+		// A wall facing the camera, a sphere, a cylinder, and a ground plane
+		// that crosses the near plane and leaves the viewport on every side.
+		add(geometry_generator.createGrid(6.0f, 4.0f, 3, 3),
+			XMMatrixRotationRollPitchYaw(-XM_PIDIV2, 0.0f, 0.0f) * XMMatrixTranslation(0.0f, 0.0f, 10.0f));
+		add(geometry_generator.createGeosphere(2.0f, 2), XMMatrixTranslation(5.0f, 1.0f, 8.0f));
+		add(geometry_generator.createCylinder(1.0f, 0.5f, 3.0f, 12, 2), XMMatrixTranslation(-4.0f, 0.0f, 6.0f));
+		add(geometry_generator.createGrid(200.0f, 200.0f, 3, 3), XMMatrixTranslation(0.0f, -2.5f, 50.0f));
+
+		return occluders;
+	}
+
+	// Nearest view space z hit by the ray from the origin through
+	// direction (z = 1), or 0 when nothing is hit.
+	float rayCast(std::vector<Occluder> const& occluders, XMFLOAT3 const& direction)
+	{
+		double nearest = 0.0;
+
+		for (auto const& occluder : occluders)
+		{
+			XMMATRIX world = XMLoadFloat4x4(&occluder.world);
+			auto const& indices = occluder.mesh_data.indices_32;
+
+			for (std::size_t i = 0; i < indices.size(); i += 3)
+			{
+				double p[3][3];
+
+				for (int k = 0; k < 3; ++k)
+				{
+					XMFLOAT3 position;
+					XMStoreFloat3(&position, XMVector3Transform(XMLoadFloat3(&occluder.mesh_data.vertices[indices[i + k]].position), world));
+
+					p[k][0] = position.x;
+					p[k][1] = position.y;
+					p[k][2] = position.z;
+				}
+
+				// Moller-Trumbore in double.
+				double e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+				double e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+				double d[3] = { direction.x, direction.y, direction.z };
+
+				double pv[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+				double det = e1[0] * pv[0] + e1[1] * pv[1] + e1[2] * pv[2];
+
+				if (std::fabs(det) < 1e-12)
+				{
+					continue;
+				}
+
+				double tv[3] = { -p[0][0], -p[0][1], -p[0][2] };
+				double u = (tv[0] * pv[0] + tv[1] * pv[1] + tv[2] * pv[2]) / det;
+
+				if (u < 0.0 || u > 1.0)
+				{
+					continue;
+				}
+
+				double q[3] = { tv[1] * e1[2] - tv[2] * e1[1], tv[2] * e1[0] - tv[0] * e1[2], tv[0] * e1[1] - tv[1] * e1[0] };
+				double v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) / det;
+
+				if (v < 0.0 || u + v > 1.0)
+				{
+					continue;
+				}
+
+				double t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / det;
+
+				if (t >= near_z && t <= far_z && (nearest == 0.0 || t < nearest))
+				{
+					nearest = t;
+				}
+			}
+		}
+
+		return static_cast<float>(nearest);
+	}
+
+	void testDepthBuffer(OcclusionCuller const& culler, std::vector<Occluder> const& occluders, Camera const& camera)
+	{
+		std::uint32_t width = culler.getWidth();
+		std::uint32_t height = culler.getHeight();
+		auto const& depth = culler.getDepthBuffer();
+
+		std::vector<float> reference(width * height);
+
+		for (std::uint32_t y = 0; y < height; ++y)
+		{
+			for (std::uint32_t x = 0; x < width; ++x)
+			{
+				float ndc_x = (x + 0.5f) / width * 2.0f - 1.0f;
+				float ndc_y = 1.0f - (y + 0.5f) / height * 2.0f;
+
+				XMFLOAT3 direction(ndc_x * aspect_ratio / camera.cot_half_fov, ndc_y / camera.cot_half_fov, 1.0f);
+
+				float z = rayCast(occluders, direction);
+				reference[y * width + x] = z > 0.0f ? camera.depth(z) : 1.0f;
+			}
+		}
+
+		// A pixel whose neighborhood in the ray cast jumps to another surface
+		// or to the background; its center may fall either side of the edge.
+		auto silhouette = [&](std::uint32_t x, std::uint32_t y)
+		{
+			float center = reference[y * width + x];
+
+			for (std::uint32_t ny = y > 0 ? y - 1 : 0; ny <= std::min(y + 1, height - 1); ++ny)
+			{
+				for (std::uint32_t nx = x > 0 ? x - 1 : 0; nx <= std::min(x + 1, width - 1); ++nx)
+				{
+					if (std::fabs(reference[ny * width + nx] - center) > 0.01f)
+					{
+						return true;
+					}
+				}
+			}
+
+			return false;
+		};
+
+		std::uint32_t covered = 0;
+		std::uint32_t differing = 0;
+		std::uint32_t differing_inside = 0;
+
+		for (std::uint32_t y = 0; y < height; ++y)
+		{
+			for (std::uint32_t x = 0; x < width; ++x)
+			{
+				float expected = reference[y * width + x];
+				float rasterized = depth[y * width + x];
+
+				covered += rasterized < 1.0f ? 1 : 0;
+
+				bool same =
+					(expected < 1.0f) == (rasterized < 1.0f) &&
+					std::fabs(expected - rasterized) < 1e-3f;
+
+				if (!same)
+				{
+					++differing;
+					differing_inside += silhouette(x, y) ? 0 : 1;
+				}
+			}
+		}
+
+		std::printf(
+			"%ux%u: %u pixels covered, %u silhouette pixels differ from the ray cast, %u others\n",
+			width,
+			height,
+			covered,
+			differing - differing_inside,
+			differing_inside);
+
+		expect(covered > width * height / 4, "the occluders cover a good part of the screen");
+		expect(differing <= 16, "only a few pixels differ from the ray cast");
+		expect(differing_inside == 0, "pixels away from silhouettes match the ray cast coverage and depth");
+	}
+
+	// Visible at full resolution: some pixel under the box's screen
+	// rectangle, taken generously, is no nearer than the box.
+	bool visibleAtFullResolution(OcclusionCuller const& culler, Camera const& camera, BoundingBox const& box)
+	{
+		std::uint32_t width = culler.getWidth();
+		std::uint32_t height = culler.getHeight();
+		auto const& depth = culler.getDepthBuffer();
+
+		float min_depth = 2.0f;
+		float x0 = 1e9f;
+		float x1 = -1e9f;
+		float y0 = 1e9f;
+		float y1 = -1e9f;
+
+		for (int k = 0; k < 8; ++k)
+		{
+			XMFLOAT3 p(
+				box.Center.x + (k & 1 ? box.Extents.x : -box.Extents.x),
+				box.Center.y + (k & 2 ? box.Extents.y : -box.Extents.y),
+				box.Center.z + (k & 4 ? box.Extents.z : -box.Extents.z));
+
+			if (p.z < near_z)
+			{
+				return true;
+			}
+
+			float screen_x = (p.x * camera.cot_half_fov / aspect_ratio / p.z * 0.5f + 0.5f) * width;
+			float screen_y = (0.5f - p.y * camera.cot_half_fov / p.z * 0.5f) * height;
+
+			min_depth = std::min(min_depth, camera.depth(p.z));
+			x0 = std::min(x0, screen_x);
+			x1 = std::max(x1, screen_x);
+			y0 = std::min(y0, screen_y);
+			y1 = std::max(y1, screen_y);
+		}
+
+		int first_x = std::max(0, static_cast<int>(std::floor(x0)));
+		int last_x = std::min(static_cast<int>(width) - 1, static_cast<int>(std::floor(x1)));
+		int first_y = std::max(0, static_cast<int>(std::floor(y0)));
+		int last_y = std::min(static_cast<int>(height) - 1, static_cast<int>(std::floor(y1)));
+
+		for (int y = first_y; y <= last_y; ++y)
+		{
+			for (int x = first_x; x <= last_x; ++x)
+			{
+				if (depth[y * width + x] >= min_depth - 1e-6f)
+				{
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	void testConservative(OcclusionCuller const& culler, Camera const& camera)
+	{
+		std::mt19937 random(5);
+		std::uniform_real_distribution<float> position(-15.0f, 15.0f);
+		std::uniform_real_distribution<float> distance(1.0f, 40.0f);
+		std::uniform_real_distribution<float> size(0.1f, 1.5f);
+
+		std::vector<BoundingBox> boxes(20000);
+
+		for (auto& box : boxes)
+		{
+			box = BoundingBox(
+				XMFLOAT3(position(random), position(random) * 0.3f, distance(random)),
+				XMFLOAT3(size(random), size(random), size(random)));
+		}
+
+		std::vector<std::uint32_t> visible;
+		culler.cull(boxes, visible);
+
+		std::vector<bool> reported(boxes.size(), false);
+
+		for (auto i : visible)
+		{
+			reported[i] = true;
+		}
+
+		std::uint32_t wrongly_hidden = 0;
+		std::uint32_t hidden = 0;
+
+		for (std::size_t i = 0; i < boxes.size(); ++i)
+		{
+			expect(reported[i] == culler.isVisible(boxes[i]), "cull agrees with isVisible");
+
+			hidden += reported[i] ? 0 : 1;
+			wrongly_hidden += !reported[i] && visibleAtFullResolution(culler, camera, boxes[i]) ? 1 : 0;
+		}
+
+		std::printf("%zu boxes: %u hidden, %u hidden although visible at full resolution\n", boxes.size(), hidden, wrongly_hidden);
+
+		expect(hidden > boxes.size() / 4, "the occluders hide a good part of the boxes");
+		expect(wrongly_hidden == 0, "no box visible at full resolution is reported hidden");
+	}
+
+	void testNearPlane(OcclusionCuller const& culler)
+	{
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> position(-3.0f, 3.0f);
+		std::uniform_real_distribution<float> size(0.1f, 2.0f);
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			// Straddles z = near_z; many are also behind the camera or
+			// inside the ground plane.
+			BoundingBox box(
+				XMFLOAT3(position(random), position(random), near_z + position(random) * 0.1f),
+				XMFLOAT3(size(random), size(random), 0.5f + size(random)));
+
+			expect(culler.isVisible(box), "boxes crossing the near plane are visible");
+		}
+
+		// One right in front of the camera, entirely behind the wall.
+		expect(culler.isVisible(BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.5f), XMFLOAT3(0.1f, 0.1f, 0.2f))), "a small box on the near plane is visible");
+	}
+}
+
+int main()
+{
+	Camera camera;
+	std::vector<Occluder> occluders = buildScene();
+
+	for (std::uint32_t width : { 256u, 320u })
+	{
+		OcclusionCuller culler(width, width / 2);
+
+		culler.beginFrame(camera.view_proj);
+
+		for (auto const& occluder : occluders)
+		{
+			culler.renderOccluder(occluder.mesh_data, occluder.world);
+		}
+
+		culler.endOccluders();
+
+		testDepthBuffer(culler, occluders, camera);
+		testConservative(culler, camera);
+		testNearPlane(culler);
+	}
+
+	std::printf(failures == 0 ? "OcclusionCuller test passed\n" : "OcclusionCuller test FAILED\n");
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+// Host-side test of QueueScheduler over queues that record their calls:
+// waits implied by an earlier wait on another queue are elided, compute
+// and copy work goes to the direct queue when those queues are missing,
+// dependencies the CPU already saw complete need no wait, and evicted
+// history only costs redundant waits, never missing ones. Builds without
+// a device, e.g. from D3D12/3_shapes:
+//	cl /std:c++17 /EHsc /O2 /I. tests\queueSchedulerTest.cpp queueScheduler.cpp
+//	g++ -std=c++17 -O2 -I. tests/queueSchedulerTest.cpp queueScheduler.cpp
+
+#include "queueScheduler.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+	int failures = 0;
+
+	void expect(bool condition, char const* what)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", what);
+			++failures;
+		}
+	}
+
+	// Completed value set by the test; the GPU is simulated by hand.
+	class ManualFence : public FenceTimeline
+	{
+	public:
+		void setEventOnCompletion(std::uint64_t, void*) override
+		{
+
+		}
+
+		std::uint64_t completed = 0;
+
+	protected:
+		std::uint64_t queryCompletedValue() override
+		{
+			return completed;
+		}
+	};
+
+	// Appends every call to a log shared by all queues, e.g.
+	// "compute wait copy 1", "compute execute 2", "compute signal 1".
+	class RecordingQueue : public QueueBackend
+	{
+	public:
+		RecordingQueue(char const* name, std::vector<std::string>& log)
+			:
+			name(name),
+			log(log)
+		{
+
+		}
+
+		void executeCommandLists(void* const*, std::uint32_t count) override
+		{
+			log.push_back(name + " execute " + std::to_string(count));
+		}
+
+		void signal(std::uint64_t value) override
+		{
+			log.push_back(name + " signal " + std::to_string(value));
+		}
+
+		void wait(QueueBackend& other, std::uint64_t value) override
+		{
+			log.push_back(name + " wait " + static_cast<RecordingQueue&>(other).name + " " + std::to_string(value));
+		}
+
+		FenceTimeline& fence() override
+		{
+			return manual_fence;
+		}
+
+		std::string name;
+		ManualFence manual_fence;
+
+	private:
+		std::vector<std::string>& log;
+	};
+
+	bool sameLog(std::vector<std::string> const& log, std::vector<std::string> const& expected)
+	{
+		if (log != expected)
+		{
+			for (auto const& entry : log)
+			{
+				std::printf("  %s\n", entry.c_str());
+			}
+
+			return false;
+		}
+
+		return true;
+	}
+
+	void* const command_lists[2] = {};
+
+	void testTransitiveWaits()
+	{
+		std::vector<std::string> log;
+		RecordingQueue direct("direct", log);
+		RecordingQueue compute("compute", log);
+		RecordingQueue copy("copy", log);
+
+		QueueScheduler scheduler(&direct, &compute, &copy);
+
+		// Upload, then a compute pass on the uploaded data, then a draw that
+		// reads both. Compute already waited for the upload, so the draw
+		// only needs to wait for compute.
+		QueueScheduler::Point upload = scheduler.submit(QueueType::Copy, command_lists, 1);
+
+		QueueScheduler::Point simulate = scheduler.submit(QueueType::Compute, command_lists, 2, &upload, 1);
+
+		QueueScheduler::Point draw_dependencies[2] = { upload, simulate };
+		QueueScheduler::Point draw = scheduler.submit(QueueType::Direct, command_lists, 1, draw_dependencies, 2);
+
+		expect(upload.queue == QueueType::Copy && upload.value == 1, "the upload signals copy 1");
+		expect(simulate.queue == QueueType::Compute && simulate.value == 1, "the compute pass signals compute 1");
+		expect(draw.queue == QueueType::Direct && draw.value == 1, "the draw signals direct 1");
+
+		expect(sameLog(log, {
+			"copy execute 1",
+			"copy signal 1",
+			"compute wait copy 1",
+			"compute execute 2",
+			"compute signal 1",
+			"direct wait compute 1",
+			"direct execute 1",
+			"direct signal 1" }), "the draw waits for compute only");
+
+		// Waiting again for points already covered, or on the same queue,
+		// inserts nothing.
+		log.clear();
+
+		QueueScheduler::Point covered[3] = { upload, simulate, draw };
+		scheduler.submit(QueueType::Direct, command_lists, 1, covered, 3);
+
+		expect(sameLog(log, { "direct execute 1", "direct signal 2" }), "covered dependencies insert no waits");
+
+		QueueScheduler::Statistics statistics = scheduler.getStatistics();
+
+		expect(statistics.submissions == 4, "four submissions");
+		expect(statistics.waits_inserted == 2, "two waits inserted");
+		expect(statistics.waits_skipped == 4, "four waits skipped");
+
+		// A later upload is not covered by the old compute wait.
+		log.clear();
+
+		QueueScheduler::Point second_upload = scheduler.submit(QueueType::Copy, command_lists, 1);
+		QueueScheduler::Point dependencies[2] = { simulate, second_upload };
+		scheduler.submit(QueueType::Direct, nullptr, 0, dependencies, 2);
+
+		expect(sameLog(log, {
+			"copy execute 1",
+			"copy signal 2",
+			"direct wait copy 2",
+			"direct signal 3" }), "a newer point on a waited queue still needs a wait");
+	}
+
+	void testMissingQueues()
+	{
+		std::vector<std::string> log;
+		RecordingQueue direct("direct", log);
+
+		QueueScheduler scheduler(&direct, nullptr, nullptr);
+
+		QueueScheduler::Point upload = scheduler.submit(QueueType::Copy, command_lists, 1);
+		QueueScheduler::Point simulate = scheduler.submit(QueueType::Compute, command_lists, 1, &upload, 1);
+
+		QueueScheduler::Point draw_dependencies[2] = { upload, simulate };
+		QueueScheduler::Point draw = scheduler.submit(QueueType::Direct, command_lists, 1, draw_dependencies, 2);
+
+		expect(upload.queue == QueueType::Direct && upload.value == 1, "copy work runs on direct");
+		expect(simulate.queue == QueueType::Direct && simulate.value == 2, "compute work runs on direct");
+		expect(draw.value == 3, "direct values continue across the redirected work");
+
+		expect(sameLog(log, {
+			"direct execute 1",
+			"direct signal 1",
+			"direct execute 1",
+			"direct signal 2",
+			"direct execute 1",
+			"direct signal 3" }), "one queue needs no waits");
+
+		expect(scheduler.lastPoint(QueueType::Copy).queue == QueueType::Direct, "lastPoint of copy is on direct");
+		expect(scheduler.lastPoint(QueueType::Compute).value == 3, "lastPoint of compute is the last direct value");
+
+		// Points named by their original queue resolve to direct as well.
+		QueueScheduler::Point named{ QueueType::Compute, 2 };
+
+		expect(scheduler.fenceWait(named).fence == &direct.fence(), "fenceWait of compute uses direct's fence");
+
+		direct.manual_fence.completed = 2;
+
+		expect(scheduler.isComplete(named), "isComplete of compute reads direct's fence");
+		expect(scheduler.getStatistics().waits_inserted == 0, "no waits inserted");
+	}
+
+	void testCompletedDependencies()
+	{
+		std::vector<std::string> log;
+		RecordingQueue direct("direct", log);
+		RecordingQueue compute("compute", log);
+		RecordingQueue copy("copy", log);
+
+		QueueScheduler scheduler(&direct, &compute, &copy);
+
+		QueueScheduler::Point upload = scheduler.submit(QueueType::Copy, command_lists, 1);
+
+		// The GPU finished the upload, but the CPU has not looked yet:
+		// submit uses the cached value only, so it still waits.
+		copy.manual_fence.completed = 1;
+		log.clear();
+
+		std::uint64_t queries = copy.fence().queryCount();
+		scheduler.submit(QueueType::Direct, command_lists, 1, &upload, 1);
+
+		expect(copy.fence().queryCount() == queries, "submit does not query fences");
+		expect(sameLog(log, { "direct wait copy 1", "direct execute 1", "direct signal 1" }), "an unseen completion still needs a wait");
+
+		// Once a poll saw it complete, a queue that never waited for the
+		// upload needs no wait either.
+		expect(scheduler.isComplete(upload), "the upload is complete");
+
+		log.clear();
+		scheduler.submit(QueueType::Compute, command_lists, 1, &upload, 1);
+
+		expect(sameLog(log, { "compute execute 1", "compute signal 1" }), "a completed dependency needs no wait");
+
+		QueueScheduler::Point second_upload = scheduler.submit(QueueType::Copy, command_lists, 1);
+
+		log.clear();
+		scheduler.submit(QueueType::Compute, command_lists, 1, &second_upload, 1);
+
+		expect(sameLog(log, { "compute wait copy 2", "compute execute 1", "compute signal 2" }), "a newer value still needs a wait");
+	}
+
+	void testEvictedHistory()
+	{
+		std::vector<std::string> log;
+		RecordingQueue direct("direct", log);
+		RecordingQueue compute("compute", log);
+		RecordingQueue copy("copy", log);
+
+		QueueScheduler scheduler(&direct, &compute, &copy);
+
+		QueueScheduler::Point upload = scheduler.submit(QueueType::Copy, command_lists, 1);
+		QueueScheduler::Point simulate = scheduler.submit(QueueType::Compute, command_lists, 1, &upload, 1);
+
+		// Push the compute pass out of compute's history.
+		for (std::uint32_t i = 0; i < QueueScheduler::history_size; ++i)
+		{
+			scheduler.submit(QueueType::Compute, command_lists, 1);
+		}
+
+		log.clear();
+
+		QueueScheduler::Point dependencies[2] = { upload, simulate };
+		scheduler.submit(QueueType::Direct, command_lists, 1, dependencies, 2);
+
+		expect(sameLog(log, {
+			"direct wait compute 1",
+			"direct wait copy 1",
+			"direct execute 1",
+			"direct signal 1" }), "without history both waits are inserted");
+	}
+}
+
+int main()
+{
+	testTransitiveWaits();
+	testMissingQueues();
+	testCompletedDependencies();
+	testEvictedHistory();
+
+	std::printf(failures == 0 ? "QueueScheduler test passed\n" : "QueueScheduler test FAILED\n");
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that split index ranges between themselves
+// and the calling thread. parallelFor blocks until the whole range is done
+// and is meant to be called from one thread at a time.
+class ThreadPool
+{
+public:
+	using RangeFunction = std::function<void(std::uint32_t begin, std::uint32_t end)>;
+
+	ThreadPool(ThreadPool const&) = delete;
+	ThreadPool& operator=(ThreadPool const&) = delete;
+
+	explicit ThreadPool(
+		std::uint32_t n_threads = std::max(1u, std::thread::hardware_concurrency()))
+	{
+		for (std::uint32_t i = 1; i < n_threads; ++i)
+		{
+			workers.emplace_back([this] { workerLoop(); });
+		}
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+
+		wake.notify_all();
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	std::uint32_t threadCount() const
+	{
+		return static_cast<std::uint32_t>(workers.size()) + 1;
+	}
+
+	// Calls fn on disjoint sub-ranges covering [0, count). min_chunk keeps
+	// tiny ranges from being split into more work items than is useful.
+	void parallelFor(std::uint32_t count, RangeFunction const& fn, std::uint32_t min_chunk = 1)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		std::uint32_t chunk = std::max(min_chunk, count / (4 * threadCount()));
+
+		if (workers.empty() || chunk >= count)
+		{
+			fn(0, count);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			job = &fn;
+			job_count = count;
+			job_chunk = chunk;
+			next_begin.store(0);
+			busy_workers = static_cast<std::uint32_t>(workers.size());
+
+			++generation;
+		}
+
+		wake.notify_all();
+
+		runChunks();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return busy_workers == 0; });
+
+		job = nullptr;
+	}
+
+private:
+	void workerLoop()
+	{
+		std::uint64_t seen_generation = 0;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return stopping || generation != seen_generation; });
+
+				if (stopping)
+				{
+					return;
+				}
+
+				seen_generation = generation;
+			}
+
+			runChunks();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				if (--busy_workers == 0)
+				{
+					done.notify_one();
+				}
+			}
+		}
+	}
+
+	void runChunks()
+	{
+		while (true)
+		{
+			std::uint32_t begin = next_begin.fetch_add(job_chunk);
+
+			if (begin >= job_count)
+			{
+				return;
+			}
+
+			(*job)(begin, std::min(begin + job_chunk, job_count));
+		}
+	}
+
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	RangeFunction const* job = nullptr;
+	std::uint32_t job_count = 0;
+	std::uint32_t job_chunk = 1;
+	std::atomic<std::uint32_t> next_begin{ 0 };
+
+	std::uint32_t busy_workers = 0;
+	std::uint64_t generation = 0;
+	bool stopping = false;
+};
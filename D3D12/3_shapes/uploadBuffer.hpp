@@ -2,6 +2,7 @@
 
 #include "config.hpp"
 #include "helpers.hpp"
+#include "streamCopy.hpp"
 
 template <typename T>
 class UploadBuffer
@@ -15,6 +16,7 @@ public:
 		UINT n_elements,
 		bool is_constant_buffer)
 		:
+		element_count{ n_elements },
 		is_constant_buffer{ is_constant_buffer }
 	{
 		element_size_in_bytes = sizeof(T);
@@ -55,13 +57,67 @@ public:
 
 	void copyData(int element_index, T const& data)
 	{
+		assert(element_index >= 0 && static_cast<UINT>(element_index) < element_count);
+
 		memcpy(&mapped_data[element_index * element_size_in_bytes], &data, sizeof(T));
 	}
 
+	// The bulk writes below use streaming stores and end with a fence, so
+	// they are for data written once per frame and never read back.
+
+	// Copies count contiguous elements to [first_element, first_element + count).
+	void copyData(UINT first_element, T const* data, UINT count)
+	{
+		assert(first_element <= element_count && count <= element_count - first_element);
+
+		streamCopyElements(elementData(first_element), element_size_in_bytes, data, sizeof(T), sizeof(T), count);
+		streamFence();
+	}
+
+	// Copies count elements that are source_stride_in_bytes apart in the
+	// source, e.g. one member of an array of larger structures.
+	void copyStrided(UINT first_element, void const* data, UINT count, SIZE_T source_stride_in_bytes)
+	{
+		assert(first_element <= element_count && count <= element_count - first_element);
+
+		streamCopyElements(
+			elementData(first_element),
+			element_size_in_bytes,
+			data,
+			source_stride_in_bytes,
+			sizeof(T),
+			count);
+
+		streamFence();
+	}
+
+	// Calls write(index, element) for each element of [first_element,
+	// first_element + count), with element built on the stack and then
+	// streamed into place; mapped upload memory is never read.
+	template <typename Write>
+	void fill(UINT first_element, UINT count, Write&& write)
+	{
+		assert(first_element <= element_count && count <= element_count - first_element);
+
+		streamFillElements<T>(elementData(first_element), element_size_in_bytes, first_element, count, write);
+		streamFence();
+	}
+
+	UINT elementCount() const
+	{
+		return element_count;
+	}
+
 private:
+	BYTE* elementData(UINT element_index) const
+	{
+		return mapped_data + SIZE_T(element_index) * element_size_in_bytes;
+	}
+
 	Microsoft::WRL::ComPtr<ID3D12Resource> upload_buffer;
 	BYTE* mapped_data = nullptr;
 
 	UINT element_size_in_bytes = 0;
+	UINT element_count = 0;
 	bool is_constant_buffer = false;
 };
@@ -0,0 +1,295 @@
+#include "uploadManager.hpp"
+
+#include <cstring>
+
+namespace
+{
+	// CopyBufferRegion has no alignment requirement; this keeps each upload
+	// on its own cache lines.
+	UINT64 const buffer_alignment = 256;
+}
+
+UploadManager::UploadManager(
+	Microsoft::WRL::ComPtr<ID3D12Device> device,
+	QueueScheduler& scheduler,
+	FenceWaiter& fence_waiter,
+	UINT64 staging_size_in_bytes)
+	:
+	device{ device },
+	scheduler{ scheduler },
+	fence_waiter{ fence_waiter },
+	staging_ring{ staging_size_in_bytes }
+{
+	// Without a copy queue the scheduler runs copies on the direct queue.
+	command_list_type = scheduler.lastPoint(QueueType::Copy).queue == QueueType::Copy ?
+		D3D12_COMMAND_LIST_TYPE_COPY :
+		D3D12_COMMAND_LIST_TYPE_DIRECT;
+
+	auto heap_properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+	auto buffer = CD3DX12_RESOURCE_DESC::Buffer(staging_size_in_bytes);
+
+	THROW_IF_FAILED(device->CreateCommittedResource(
+		&heap_properties,
+		D3D12_HEAP_FLAG_NONE,
+		&buffer,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&staging_buffer)));
+
+	THROW_IF_FAILED(staging_buffer->Map(0, nullptr, reinterpret_cast<void**>(&staging_data)));
+}
+
+UploadManager::~UploadManager()
+{
+	submit();
+
+	fence_waiter.wait(copyFence(), scheduler.lastPoint(QueueType::Copy).value);
+
+	if (staging_buffer)
+	{
+		staging_buffer->Unmap(0, nullptr);
+	}
+}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> UploadManager::createBuffer(void const* data, UINT64 size_in_bytes)
+{
+	Microsoft::WRL::ComPtr<ID3D12Resource> default_buffer;
+
+	auto heap_properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+	auto buffer = CD3DX12_RESOURCE_DESC::Buffer(size_in_bytes);
+
+	THROW_IF_FAILED(device->CreateCommittedResource(
+		&heap_properties,
+		D3D12_HEAP_FLAG_NONE,
+		&buffer,
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(&default_buffer)));
+
+	uploadBuffer(default_buffer.Get(), 0, data, size_in_bytes);
+
+	return default_buffer;
+}
+
+void UploadManager::uploadBuffer(
+	ID3D12Resource* destination,
+	UINT64 destination_offset,
+	void const* data,
+	UINT64 size_in_bytes)
+{
+	Staging staging = allocateStaging(size_in_bytes, buffer_alignment);
+	std::memcpy(staging.data, data, size_in_bytes);
+
+	beginBatch();
+
+	command_list->CopyBufferRegion(
+		destination,
+		destination_offset,
+		staging.resource,
+		staging.offset,
+		size_in_bytes);
+}
+
+void UploadManager::uploadTexture(
+	ID3D12Resource* texture,
+	UINT first_subresource,
+	UINT subresource_count,
+	D3D12_SUBRESOURCE_DATA const* data)
+{
+	D3D12_RESOURCE_DESC desc = texture->GetDesc();
+
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresource_count);
+	std::vector<UINT> row_counts(subresource_count);
+	std::vector<UINT64> row_sizes_in_bytes(subresource_count);
+	UINT64 total_size_in_bytes = 0;
+
+	device->GetCopyableFootprints(
+		&desc,
+		first_subresource,
+		subresource_count,
+		0,
+		layouts.data(),
+		row_counts.data(),
+		row_sizes_in_bytes.data(),
+		&total_size_in_bytes);
+
+	Staging staging = allocateStaging(total_size_in_bytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+	beginBatch();
+
+	for (UINT i = 0; i < subresource_count; ++i)
+	{
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = layouts[i];
+
+		D3D12_MEMCPY_DEST destination;
+		destination.pData = staging.data + layout.Offset;
+		destination.RowPitch = layout.Footprint.RowPitch;
+		destination.SlicePitch = SIZE_T(layout.Footprint.RowPitch) * row_counts[i];
+
+		MemcpySubresource(
+			&destination,
+			&data[i],
+			static_cast<SIZE_T>(row_sizes_in_bytes[i]),
+			row_counts[i],
+			layout.Footprint.Depth);
+
+		layout.Offset += staging.offset;
+
+		CD3DX12_TEXTURE_COPY_LOCATION destination_location(texture, first_subresource + i);
+		CD3DX12_TEXTURE_COPY_LOCATION source_location(staging.resource, layout);
+
+		command_list->CopyTextureRegion(&destination_location, 0, 0, 0, &source_location, nullptr);
+	}
+}
+
+UploadManager::Ticket UploadManager::submit()
+{
+	if (!batch_open)
+	{
+		return scheduler.lastPoint(QueueType::Copy);
+	}
+
+	THROW_IF_FAILED(command_list->Close());
+
+	ID3D12CommandList* command_lists[] = { command_list.Get() };
+
+	Ticket ticket = scheduler.submit(
+		QueueType::Copy,
+		reinterpret_cast<void* const*>(command_lists),
+		_countof(command_lists));
+
+	staging_ring.close(ticket.value);
+
+	in_flight_allocators.push_back({ command_allocator, ticket.value });
+	command_allocator = nullptr;
+
+	for (auto& dedicated : batch_dedicated_staging)
+	{
+		in_flight_dedicated_staging.push_back({ dedicated, ticket.value });
+	}
+
+	batch_dedicated_staging.clear();
+	batch_open = false;
+
+	retire();
+
+	return ticket;
+}
+
+bool UploadManager::isComplete(Ticket ticket)
+{
+	return scheduler.isComplete(ticket);
+}
+
+void UploadManager::retire()
+{
+	UINT64 completed_value = copyFence().refresh();
+
+	staging_ring.release(completed_value);
+
+	while (!in_flight_allocators.empty() && in_flight_allocators.front().fence_value <= completed_value)
+	{
+		free_allocators.push_back(in_flight_allocators.front().object);
+		in_flight_allocators.pop_front();
+	}
+
+	while (!in_flight_dedicated_staging.empty() && in_flight_dedicated_staging.front().fence_value <= completed_value)
+	{
+		in_flight_dedicated_staging.pop_front();
+	}
+}
+
+UploadManager::Staging UploadManager::allocateStaging(UINT64 size_in_bytes, UINT64 alignment)
+{
+	if (size_in_bytes > staging_ring.capacity())
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> dedicated;
+
+		auto heap_properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+		auto buffer = CD3DX12_RESOURCE_DESC::Buffer(size_in_bytes);
+
+		THROW_IF_FAILED(device->CreateCommittedResource(
+			&heap_properties,
+			D3D12_HEAP_FLAG_NONE,
+			&buffer,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&dedicated)));
+
+		// Upload heaps stay valid while mapped; the buffer is released once
+		// its copy completes, which unmaps it.
+		BYTE* data = nullptr;
+		THROW_IF_FAILED(dedicated->Map(0, nullptr, reinterpret_cast<void**>(&data)));
+
+		batch_dedicated_staging.push_back(dedicated);
+
+		return { dedicated.Get(), 0, data };
+	}
+
+	UINT64 offset = staging_ring.allocate(size_in_bytes, alignment);
+
+	while (offset == StagingRing::invalid_offset)
+	{
+		// The open batch may hold the space; otherwise wait for the oldest
+		// submitted batch to free its part of the ring.
+		if (staging_ring.openBytes() > 0)
+		{
+			submit();
+		}
+
+		fence_waiter.wait(copyFence(), staging_ring.oldestFenceValue());
+		retire();
+
+		offset = staging_ring.allocate(size_in_bytes, alignment);
+	}
+
+	return { staging_buffer.Get(), offset, staging_data + offset };
+}
+
+void UploadManager::beginBatch()
+{
+	if (batch_open)
+	{
+		return;
+	}
+
+	if (free_allocators.empty())
+	{
+		retire();
+	}
+
+	if (free_allocators.empty())
+	{
+		THROW_IF_FAILED(device->CreateCommandAllocator(
+			command_list_type,
+			IID_PPV_ARGS(&command_allocator)));
+	}
+	else
+	{
+		command_allocator = free_allocators.back();
+		free_allocators.pop_back();
+
+		THROW_IF_FAILED(command_allocator->Reset());
+	}
+
+	if (command_list)
+	{
+		THROW_IF_FAILED(command_list->Reset(command_allocator.Get(), nullptr));
+	}
+	else
+	{
+		THROW_IF_FAILED(device->CreateCommandList(
+			0,
+			command_list_type,
+			command_allocator.Get(),
+			nullptr,
+			IID_PPV_ARGS(&command_list)));
+	}
+
+	batch_open = true;
+}
+
+FenceTimeline& UploadManager::copyFence()
+{
+	return *scheduler.fenceWait(scheduler.lastPoint(QueueType::Copy)).fence;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "config.hpp"
+#include "fenceWaiter.hpp"
+#include "queueScheduler.hpp"
+#include "stagingRing.hpp"
+
+#include <deque>
+#include <vector>
+
+// Uploads buffers and textures through a persistently mapped staging ring
+// on the copy queue of a QueueScheduler. Copies are batched into one
+// command list until submit(), which returns the ticket to make the direct
+// queue wait on before it uses the resources. Staging memory, command
+// allocators and oversized staging buffers are recycled as the copy fence
+// passes, so nothing has to be disposed of by hand.
+//
+// Resources are created in D3D12_RESOURCE_STATE_COMMON: the copy queue
+// promotes them to COPY_DEST and they decay back to COMMON once the copy
+// completes, so no barriers are recorded on either queue.
+class UploadManager
+{
+public:
+	using Ticket = QueueScheduler::Point;
+
+	static UINT64 const default_staging_size_in_bytes = 32ull << 20;
+
+	UploadManager(UploadManager const&) = delete;
+	UploadManager& operator=(UploadManager const&) = delete;
+
+	// The scheduler's copy queue must not be used by anyone else.
+	UploadManager(
+		Microsoft::WRL::ComPtr<ID3D12Device> device,
+		QueueScheduler& scheduler,
+		FenceWaiter& fence_waiter,
+		UINT64 staging_size_in_bytes = default_staging_size_in_bytes);
+
+	// Waits for every submitted copy.
+	~UploadManager();
+
+	// Creates a default heap buffer and queues the copy of data into it.
+	Microsoft::WRL::ComPtr<ID3D12Resource> createBuffer(void const* data, UINT64 size_in_bytes);
+
+	// Queues a copy into an existing buffer in the COMMON state, e.g. a
+	// placed buffer or a block of a shared one.
+	void uploadBuffer(
+		ID3D12Resource* destination,
+		UINT64 destination_offset,
+		void const* data,
+		UINT64 size_in_bytes);
+
+	// Queues copies into subresources [first_subresource, first_subresource
+	// + subresource_count) of a texture in the COMMON state.
+	void uploadTexture(
+		ID3D12Resource* texture,
+		UINT first_subresource,
+		UINT subresource_count,
+		D3D12_SUBRESOURCE_DATA const* data);
+
+	// Submits the queued copies. With nothing queued, returns the ticket of
+	// the last submission.
+	Ticket submit();
+
+	bool isComplete(Ticket ticket);
+
+	// Recycles what completed copies were using. Also done by submit and
+	// whenever the staging ring runs out.
+	void retire();
+
+	StagingRing const& getStagingRing() const
+	{
+		return staging_ring;
+	}
+
+private:
+	struct Staging
+	{
+		ID3D12Resource* resource;
+		UINT64 offset;
+		BYTE* data;
+	};
+
+	template <typename T>
+	struct InFlight
+	{
+		Microsoft::WRL::ComPtr<T> object;
+		UINT64 fence_value;
+	};
+
+	// Allocations larger than the ring get their own upload buffer.
+	Staging allocateStaging(UINT64 size_in_bytes, UINT64 alignment);
+
+	void beginBatch();
+
+	FenceTimeline& copyFence();
+
+	Microsoft::WRL::ComPtr<ID3D12Device> device;
+	QueueScheduler& scheduler;
+	FenceWaiter& fence_waiter;
+
+	D3D12_COMMAND_LIST_TYPE command_list_type;
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> staging_buffer;
+	BYTE* staging_data = nullptr;
+	StagingRing staging_ring;
+
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> command_list;
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> command_allocator;
+	bool batch_open = false;
+
+	std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> free_allocators;
+	std::deque<InFlight<ID3D12CommandAllocator>> in_flight_allocators;
+
+	// Dedicated staging buffers of the open batch, then of submitted
+	// batches until their ticket completes.
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> batch_dedicated_staging;
+	std::deque<InFlight<ID3D12Resource>> in_flight_dedicated_staging;
+};
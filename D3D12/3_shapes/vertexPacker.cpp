@@ -0,0 +1,356 @@
+#include "vertexPacker.hpp"
+
+#include <DirectXPackedVector.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	std::uint32_t const normal_offset = 8;
+
+	// Octahedral8 stores normal and tangent as R8G8_SNORM pairs.
+	std::uint32_t normalSize(VertexPacker::Precision precision)
+	{
+		return precision == VertexPacker::Precision::Octahedral16 ? 4 : 2;
+	}
+
+	template <typename T>
+	void write(std::uint8_t* destination, T const& value)
+	{
+		std::memcpy(destination, &value, sizeof(T));
+	}
+
+	template <typename T>
+	T read(std::uint8_t const* source)
+	{
+		T value;
+		std::memcpy(&value, source, sizeof(T));
+
+		return value;
+	}
+
+	void writeSnormPair(
+		std::uint8_t* destination,
+		std::int32_t qx,
+		std::int32_t qy,
+		VertexPacker::Precision precision)
+	{
+		if (precision == VertexPacker::Precision::Octahedral16)
+		{
+			write(destination + 0, static_cast<std::int16_t>(qx));
+			write(destination + 2, static_cast<std::int16_t>(qy));
+		}
+		else
+		{
+			write(destination + 0, static_cast<std::int8_t>(qx));
+			write(destination + 1, static_cast<std::int8_t>(qy));
+		}
+	}
+
+	void readSnormPair(
+		std::uint8_t const* source,
+		std::int32_t& qx,
+		std::int32_t& qy,
+		VertexPacker::Precision precision)
+	{
+		if (precision == VertexPacker::Precision::Octahedral16)
+		{
+			qx = read<std::int16_t>(source + 0);
+			qy = read<std::int16_t>(source + 2);
+		}
+		else
+		{
+			qx = read<std::int8_t>(source + 0);
+			qy = read<std::int8_t>(source + 1);
+		}
+	}
+}
+
+XMFLOAT4X4 VertexPacker::PackedVertices::positionDecodeMatrix() const
+{
+	return XMFLOAT4X4(
+		position_scale.x, 0.0f, 0.0f, 0.0f,
+		0.0f, position_scale.y, 0.0f, 0.0f,
+		0.0f, 0.0f, position_scale.z, 0.0f,
+		position_offset.x, position_offset.y, position_offset.z, 1.0f);
+}
+
+VertexPacker::PackedVertices VertexPacker::pack(
+	GeometryGenerator::MeshData const& mesh_data,
+	Precision precision)
+{
+	return pack(
+		mesh_data.vertices,
+		0,
+		static_cast<std::uint32_t>(mesh_data.vertices.size()),
+		precision);
+}
+
+VertexPacker::PackedVertices VertexPacker::pack(
+	std::vector<GeometryGenerator::Vertex> const& vertices,
+	std::uint32_t first_vertex,
+	std::uint32_t vertex_count,
+	Precision precision)
+{
+	assert(static_cast<std::size_t>(first_vertex) + vertex_count <= vertices.size());
+
+	PackedVertices packed;
+	packed.precision = precision;
+	packed.stride_in_bytes = strideInBytes(precision);
+	packed.vertex_count = vertex_count;
+	packed.input_layout = inputLayout(precision);
+	packed.data.resize(static_cast<std::size_t>(vertex_count) * packed.stride_in_bytes);
+
+	if (vertex_count == 0)
+	{
+		return packed;
+	}
+
+	XMFLOAT3 p_min(FLT_MAX, FLT_MAX, FLT_MAX);
+	XMFLOAT3 p_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	for (std::uint32_t i = first_vertex; i < first_vertex + vertex_count; ++i)
+	{
+		XMFLOAT3 const& p = vertices[i].position;
+
+		p_min = XMFLOAT3(std::min(p_min.x, p.x), std::min(p_min.y, p.y), std::min(p_min.z, p.z));
+		p_max = XMFLOAT3(std::max(p_max.x, p.x), std::max(p_max.y, p.y), std::max(p_max.z, p.z));
+	}
+
+	packed.position_offset = p_min;
+	packed.position_scale = XMFLOAT3(p_max.x - p_min.x, p_max.y - p_min.y, p_max.z - p_min.z);
+
+	// A flat axis keeps a zero scale and quantizes to 0.
+	auto inverse = [](float extent) { return extent > 0.0f ? 1.0f / extent : 0.0f; };
+
+	XMFLOAT3 inverse_scale(
+		inverse(packed.position_scale.x),
+		inverse(packed.position_scale.y),
+		inverse(packed.position_scale.z));
+
+	std::uint32_t bits = precision == Precision::Octahedral16 ? 16 : 8;
+	std::uint32_t tangent_offset = normal_offset + normalSize(precision);
+	std::uint32_t tex_c_offset = tangent_offset + normalSize(precision);
+
+	for (std::uint32_t i = 0; i < vertex_count; ++i)
+	{
+		GeometryGenerator::Vertex const& v = vertices[first_vertex + i];
+		std::uint8_t* destination = packed.data.data() + static_cast<std::size_t>(i) * packed.stride_in_bytes;
+
+		write(destination + 0, quantizeUnorm16((v.position.x - p_min.x) * inverse_scale.x));
+		write(destination + 2, quantizeUnorm16((v.position.y - p_min.y) * inverse_scale.y));
+		write(destination + 4, quantizeUnorm16((v.position.z - p_min.z) * inverse_scale.z));
+		write(destination + 6, std::uint16_t(UINT16_MAX));
+
+		std::int32_t qx, qy;
+
+		octahedralEncodeQuantized(v.normal, bits, qx, qy);
+		writeSnormPair(destination + normal_offset, qx, qy, precision);
+
+		octahedralEncodeQuantized(v.tangent_u, bits, qx, qy);
+		writeSnormPair(destination + tangent_offset, qx, qy, precision);
+
+		write(destination + tex_c_offset + 0, PackedVector::XMConvertFloatToHalf(v.tex_c.x));
+		write(destination + tex_c_offset + 2, PackedVector::XMConvertFloatToHalf(v.tex_c.y));
+	}
+
+	return packed;
+}
+
+GeometryGenerator::Vertex VertexPacker::unpack(PackedVertices const& packed, std::uint32_t index)
+{
+	assert(index < packed.vertex_count);
+
+	std::uint8_t const* source = packed.data.data() + static_cast<std::size_t>(index) * packed.stride_in_bytes;
+
+	std::uint32_t bits = packed.precision == Precision::Octahedral16 ? 16 : 8;
+	std::uint32_t tangent_offset = normal_offset + normalSize(packed.precision);
+	std::uint32_t tex_c_offset = tangent_offset + normalSize(packed.precision);
+
+	GeometryGenerator::Vertex v;
+
+	v.position = XMFLOAT3(
+		packed.position_offset.x + dequantizeUnorm16(read<std::uint16_t>(source + 0)) * packed.position_scale.x,
+		packed.position_offset.y + dequantizeUnorm16(read<std::uint16_t>(source + 2)) * packed.position_scale.y,
+		packed.position_offset.z + dequantizeUnorm16(read<std::uint16_t>(source + 4)) * packed.position_scale.z);
+
+	std::int32_t qx, qy;
+
+	readSnormPair(source + normal_offset, qx, qy, packed.precision);
+	v.normal = octahedralDecode(XMFLOAT2(dequantizeSnorm(qx, bits), dequantizeSnorm(qy, bits)));
+
+	readSnormPair(source + tangent_offset, qx, qy, packed.precision);
+	v.tangent_u = octahedralDecode(XMFLOAT2(dequantizeSnorm(qx, bits), dequantizeSnorm(qy, bits)));
+
+	v.tex_c = XMFLOAT2(
+		PackedVector::XMConvertHalfToFloat(read<PackedVector::HALF>(source + tex_c_offset + 0)),
+		PackedVector::XMConvertHalfToFloat(read<PackedVector::HALF>(source + tex_c_offset + 2)));
+
+	return v;
+}
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> VertexPacker::inputLayout(Precision precision)
+{
+	DXGI_FORMAT unit_vector_format = precision == Precision::Octahedral16 ?
+		DXGI_FORMAT_R16G16_SNORM :
+		DXGI_FORMAT_R8G8_SNORM;
+
+	UINT tangent_offset = normal_offset + normalSize(precision);
+	UINT tex_c_offset = tangent_offset + normalSize(precision);
+
+	return
+	{
+		{
+			"POSITION",
+			0,
+			DXGI_FORMAT_R16G16B16A16_UNORM,
+			0,
+			0,
+			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+			0
+		},
+		{
+			"NORMAL",
+			0,
+			unit_vector_format,
+			0,
+			normal_offset,
+			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+			0
+		},
+		{
+			"TANGENT",
+			0,
+			unit_vector_format,
+			0,
+			tangent_offset,
+			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+			0
+		},
+		{
+			"TEXCOORD",
+			0,
+			DXGI_FORMAT_R16G16_FLOAT,
+			0,
+			tex_c_offset,
+			D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+			0
+		}
+	};
+}
+
+std::uint32_t VertexPacker::strideInBytes(Precision precision)
+{
+	return normal_offset + 2 * normalSize(precision) + 4;
+}
+
+std::uint16_t VertexPacker::quantizeUnorm16(float v)
+{
+	v = std::min(std::max(v, 0.0f), 1.0f);
+
+	return static_cast<std::uint16_t>(v * UINT16_MAX + 0.5f);
+}
+
+float VertexPacker::dequantizeUnorm16(std::uint16_t q)
+{
+	return q / float(UINT16_MAX);
+}
+
+std::int32_t VertexPacker::quantizeSnorm(float v, std::uint32_t bits)
+{
+	float max_value = float((1 << (bits - 1)) - 1);
+	v = std::min(std::max(v, -1.0f), 1.0f);
+
+	return static_cast<std::int32_t>(roundf(v * max_value));
+}
+
+float VertexPacker::dequantizeSnorm(std::int32_t q, std::uint32_t bits)
+{
+	float max_value = float((1 << (bits - 1)) - 1);
+
+	// Matches the GPU, which maps both -2^(bits-1) and its successor to -1.
+	return std::max(q / max_value, -1.0f);
+}
+
+XMFLOAT2 VertexPacker::octahedralEncode(XMFLOAT3 const& n)
+{
+	float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+
+	if (l1 == 0.0f)
+	{
+		return XMFLOAT2(0.0f, 0.0f);
+	}
+
+	float x = n.x / l1;
+	float y = n.y / l1;
+
+	if (n.z < 0.0f)
+	{
+		float folded_x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float folded_y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+
+		x = folded_x;
+		y = folded_y;
+	}
+
+	return XMFLOAT2(x, y);
+}
+
+XMFLOAT3 VertexPacker::octahedralDecode(XMFLOAT2 const& e)
+{
+	XMFLOAT3 n(e.x, e.y, 1.0f - fabsf(e.x) - fabsf(e.y));
+
+	float t = std::max(-n.z, 0.0f);
+
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+
+	XMStoreFloat3(&n, XMVector3Normalize(XMLoadFloat3(&n)));
+
+	return n;
+}
+
+void VertexPacker::octahedralEncodeQuantized(
+	XMFLOAT3 const& n,
+	std::uint32_t bits,
+	std::int32_t& qx,
+	std::int32_t& qy)
+{
+	XMFLOAT2 e = octahedralEncode(n);
+
+	float max_value = float((1 << (bits - 1)) - 1);
+
+	std::int32_t base_x = static_cast<std::int32_t>(floorf(e.x * max_value));
+	std::int32_t base_y = static_cast<std::int32_t>(floorf(e.y * max_value));
+
+	XMVECTOR target = XMVector3Normalize(XMLoadFloat3(&n));
+	float best_dot = -FLT_MAX;
+
+	qx = quantizeSnorm(e.x, bits);
+	qy = quantizeSnorm(e.y, bits);
+
+	for (std::int32_t dy = 0; dy <= 1; ++dy)
+	{
+		for (std::int32_t dx = 0; dx <= 1; ++dx)
+		{
+			std::int32_t cx = std::min(std::max(base_x + dx, -std::int32_t(max_value)), std::int32_t(max_value));
+			std::int32_t cy = std::min(std::max(base_y + dy, -std::int32_t(max_value)), std::int32_t(max_value));
+
+			XMFLOAT3 decoded = octahedralDecode(XMFLOAT2(dequantizeSnorm(cx, bits), dequantizeSnorm(cy, bits)));
+			float dot = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&decoded), target));
+
+			if (dot > best_dot)
+			{
+				best_dot = dot;
+				qx = cx;
+				qy = cy;
+			}
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "geometryGenerator.hpp"
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <vector>
+
+// Packs GeometryGenerator::Vertex (44 bytes) into 20 or 16 bytes:
+//   POSITION  R16G16B16A16_UNORM, relative to the bounds of the packed range
+//   NORMAL    octahedral R16G16_SNORM, or R8G8_SNORM
+//   TANGENT   octahedral R16G16_SNORM, or R8G8_SNORM
+//   TEXCOORD  R16G16_FLOAT
+// The vertex shader rebuilds the unit vectors from the octahedral e with
+//   float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+//   float t = saturate(-n.z);
+//   n.xy += n.xy >= 0.0f ? -t : t;
+//   n = normalize(n);
+class VertexPacker
+{
+public:
+	enum class Precision
+	{
+		Octahedral16,
+		Octahedral8
+	};
+
+	struct PackedVertices
+	{
+		std::vector<std::uint8_t> data;
+		std::uint32_t stride_in_bytes = 0;
+		std::uint32_t vertex_count = 0;
+
+		Precision precision = Precision::Octahedral16;
+
+		// position = position_offset + unorm * position_scale
+		DirectX::XMFLOAT3 position_offset = { 0.0f, 0.0f, 0.0f };
+		DirectX::XMFLOAT3 position_scale = { 1.0f, 1.0f, 1.0f };
+
+		std::vector<D3D12_INPUT_ELEMENT_DESC> input_layout;
+
+		// Maps the unorm positions back to object space. Multiplying it in
+		// front of the world matrix leaves the shader unchanged.
+		DirectX::XMFLOAT4X4 positionDecodeMatrix() const;
+	};
+
+	PackedVertices pack(
+		GeometryGenerator::MeshData const& mesh_data,
+		Precision precision = Precision::Octahedral16);
+
+	// Packs vertex_count vertices starting at first_vertex, quantizing the
+	// positions to the bounds of that range only (one submesh).
+	PackedVertices pack(
+		std::vector<GeometryGenerator::Vertex> const& vertices,
+		std::uint32_t first_vertex,
+		std::uint32_t vertex_count,
+		Precision precision = Precision::Octahedral16);
+
+	GeometryGenerator::Vertex unpack(PackedVertices const& packed, std::uint32_t index);
+
+	std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayout(Precision precision);
+	std::uint32_t strideInBytes(Precision precision);
+
+	// Encoding building blocks, public so round trip errors can be measured.
+	std::uint16_t quantizeUnorm16(float v);
+	float dequantizeUnorm16(std::uint16_t q);
+
+	std::int32_t quantizeSnorm(float v, std::uint32_t bits);
+	float dequantizeSnorm(std::int32_t q, std::uint32_t bits);
+
+	DirectX::XMFLOAT2 octahedralEncode(DirectX::XMFLOAT3 const& n);
+	DirectX::XMFLOAT3 octahedralDecode(DirectX::XMFLOAT2 const& e);
+
+	// Quantizes to bits per component, picking among the four neighbouring
+	// grid points the one that decodes closest to n.
+	void octahedralEncodeQuantized(
+		DirectX::XMFLOAT3 const& n,
+		std::uint32_t bits,
+		std::int32_t& qx,
+		std::int32_t& qy);
+};